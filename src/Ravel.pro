@@ -73,7 +73,23 @@ SOURCES  += main.cpp \
     clustertask.cpp \
     taskgroup.cpp \
     otf2exporter.cpp \
-    otf2exportfunctor.cpp
+    otf2exportfunctor.cpp \
+    stepindex.cpp \
+    timepyramid.cpp \
+    hotspotindex.cpp \
+    packedcalls.cpp \
+    callstore.cpp \
+    barrenderer.cpp \
+    stridegraph.cpp \
+    tracesnapshot.cpp \
+    otf2writerattributes.cpp \
+    processingprofile.cpp \
+    profiledialog.cpp \
+    framebuilder.cpp \
+    calltreeframe.cpp \
+    tilecache.cpp \
+    labelcache.cpp \
+    hotspotsdialog.cpp
 
 HEADERS += \
     trace.h \
@@ -121,13 +137,32 @@ HEADERS += \
     clustertask.h \
     taskgroup.h \
     otf2exporter.h \
-    otf2exportfunctor.h
+    otf2exportfunctor.h \
+    stepindex.h \
+    timepyramid.h \
+    hotspotindex.h \
+    packedcalls.h \
+    callstore.h \
+    barrenderer.h \
+    stridegraph.h \
+    tracesnapshot.h \
+    otf2writerattributes.h \
+    processingprofile.h \
+    profiledialog.h \
+    hitgrid.h \
+    framebuilder.h \
+    calltreeframe.h \
+    tilecache.h \
+    labelcache.h \
+    hotspotsdialog.h
 
 FORMS += \
     mainwindow.ui \
     importoptionsdialog.ui \
     visoptionsdialog.ui \
-    metricrangedialog.ui
+    metricrangedialog.ui \
+    profiledialog.ui \
+    hotspotsdialog.ui
 
 HOME = $$system(echo $HOME)
 
@@ -0,0 +1,232 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+//
+// This file is part of Ravel.
+// Written by Kate Isaacs, kisaacs@acm.org, All rights reserved.
+// LLNL-CODE-663885
+//
+// For details, see https://github.com/scalability-llnl/ravel
+// Please also see the LICENSE file for our notice and the LGPL.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (as published by
+// the Free Software Foundation) version 2.1 dated February 1999.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the IMPLIED WARRANTY OF
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the terms and
+// conditions of the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//////////////////////////////////////////////////////////////////////////////
+#include "barrenderer.h"
+
+#include "colormap.h"
+
+static const char * bar_vertex_shader =
+    "attribute vec2 vertex;\n"
+    "attribute vec2 spread;\n"
+    "attribute float value;\n"
+    "attribute float selected;\n"
+    "uniform vec2 origin;\n"
+    "uniform vec2 extent;\n"
+    "uniform vec2 widen;\n"
+    "uniform float opacity;\n"
+    "uniform float dimmed;\n"
+    "uniform float range_low;\n"
+    "uniform float range_high;\n"
+    "uniform float categories;\n"
+    "varying float coord;\n"
+    "varying float alpha;\n"
+    "void main()\n"
+    "{\n"
+    "    vec2 world = vertex + spread * widen;\n"
+    "    gl_Position = vec4(2.0 * (world - origin) / extent - 1.0, 0.0, 1.0);\n"
+    "    if (categories > 0.0)\n"
+    "        coord = (mod(floor(value - range_low), categories) + 0.5)\n"
+    "                / categories;\n"
+    "    else if (range_high > range_low)\n"
+    "        coord = (value - range_low) / (range_high - range_low);\n"
+    "    else\n"
+    "        coord = 0.0;\n"
+    "    alpha = (selected > 0.5) ? opacity : opacity * dimmed;\n"
+    "}\n";
+
+static const char * bar_fragment_shader =
+    "uniform sampler1D colormap;\n"
+    "varying float coord;\n"
+    "varying float alpha;\n"
+    "void main()\n"
+    "{\n"
+    "    gl_FragColor = vec4(texture1D(colormap, coord).rgb, alpha);\n"
+    "}\n";
+
+BarRenderer::BarRenderer()
+    : ready(false),
+      num_bars(0),
+      program(NULL),
+      buffer(NULL),
+      texture(0)
+{
+}
+
+BarRenderer::~BarRenderer()
+{
+    // The context owning these must be current, as it is during the
+    // owning widget's destruction.
+    if (texture)
+        glDeleteTextures(1, &texture);
+    if (buffer)
+        buffer->destroy();
+    delete buffer;
+    delete program;
+}
+
+bool BarRenderer::initialize()
+{
+    if (ready)
+        return true;
+    if (program) // Tried and failed before
+        return false;
+
+    program = new QGLShaderProgram();
+    if (!QGLShaderProgram::hasOpenGLShaderPrograms()
+        || !program->addShaderFromSourceCode(QGLShader::Vertex,
+                                             bar_vertex_shader)
+        || !program->addShaderFromSourceCode(QGLShader::Fragment,
+                                             bar_fragment_shader)
+        || !program->link())
+    {
+        return false;
+    }
+
+    buffer = new QGLBuffer(QGLBuffer::VertexBuffer);
+    buffer->setUsagePattern(QGLBuffer::StaticDraw);
+    if (!buffer->create())
+        return false;
+
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_1D, texture);
+    glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_1D, 0);
+
+    ready = true;
+    return true;
+}
+
+void BarRenderer::appendBar(QVector<GLfloat> * vertices,
+                            float x, float y, float w, float h,
+                            float value, bool selected)
+{
+    GLfloat corners[verticesPerBar][4] = {
+        { x, y, -1, -1 },
+        { x, y + h, -1, 1 },
+        { x + w, y + h, 1, 1 },
+        { x + w, y, 1, -1 }
+    };
+    for (int i = 0; i < verticesPerBar; ++i)
+    {
+        for (int j = 0; j < 4; ++j)
+            vertices->append(corners[i][j]);
+        vertices->append(value);
+        vertices->append(selected ? 1 : 0);
+    }
+}
+
+void BarRenderer::setBars(const QVector<GLfloat>& vertices)
+{
+    num_bars = vertices.size() / (floatsPerVertex * verticesPerBar);
+    buffer->bind();
+    buffer->allocate(vertices.constData(), vertices.size() * sizeof(GLfloat));
+    buffer->release();
+}
+
+// Copies the colormap's lookup table into the texture. Categorical maps
+// get one texel per color so lookups land on exact entries.
+void BarRenderer::setColorMap(ColorMap * colormap)
+{
+    double low = colormap->getMin();
+    double high = colormap->getClamp();
+    QVector<QRgb> colors;
+    if (colormap->isCategorical())
+    {
+        QVector<double> values = QVector<double>(colormap->numColors());
+        for (int i = 0; i < values.size(); ++i)
+            values[i] = low + i;
+        colors.resize(values.size());
+        colormap->mapColors(values.constData(), values.size(),
+                            colors.data());
+    }
+    else
+    {
+        colors = colormap->colorTable();
+    }
+
+    int size = colors.size();
+    QVector<GLubyte> texels = QVector<GLubyte>(4 * size);
+    for (int i = 0; i < size; ++i)
+    {
+        texels[4 * i] = qRed(colors[i]);
+        texels[4 * i + 1] = qGreen(colors[i]);
+        texels[4 * i + 2] = qBlue(colors[i]);
+        texels[4 * i + 3] = 255;
+    }
+
+    GLint filter = colormap->isCategorical() ? GL_NEAREST : GL_LINEAR;
+    glBindTexture(GL_TEXTURE_1D, texture);
+    glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MIN_FILTER, filter);
+    glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MAG_FILTER, filter);
+    glTexImage1D(GL_TEXTURE_1D, 0, GL_RGBA, size, 0, GL_RGBA,
+                 GL_UNSIGNED_BYTE, texels.constData());
+    glBindTexture(GL_TEXTURE_1D, 0);
+
+    program->bind();
+    program->setUniformValue("range_low", GLfloat(low));
+    program->setUniformValue("range_high", GLfloat(high));
+    program->setUniformValue("categories",
+                             GLfloat(colormap->isCategorical() ? size : 0));
+    program->release();
+}
+
+void BarRenderer::draw(int first, int count, QPointF origin, QPointF extent,
+                       QPointF spread, float opacity, float dimmed)
+{
+    if (count <= 0)
+        return;
+
+    int stride = floatsPerVertex * sizeof(GLfloat);
+    program->bind();
+    program->setUniformValue("origin", origin);
+    program->setUniformValue("extent", extent);
+    program->setUniformValue("widen", spread);
+    program->setUniformValue("opacity", opacity);
+    program->setUniformValue("dimmed", dimmed);
+    program->setUniformValue("colormap", 0);
+
+    glBindTexture(GL_TEXTURE_1D, texture);
+    buffer->bind();
+    program->enableAttributeArray("vertex");
+    program->enableAttributeArray("spread");
+    program->enableAttributeArray("value");
+    program->enableAttributeArray("selected");
+    program->setAttributeBuffer("vertex", GL_FLOAT, 0, 2, stride);
+    program->setAttributeBuffer("spread", GL_FLOAT, 2 * sizeof(GLfloat),
+                                2, stride);
+    program->setAttributeBuffer("value", GL_FLOAT, 4 * sizeof(GLfloat),
+                                1, stride);
+    program->setAttributeBuffer("selected", GL_FLOAT, 5 * sizeof(GLfloat),
+                                1, stride);
+
+    glDrawArrays(GL_QUADS, first * verticesPerBar, count * verticesPerBar);
+
+    program->disableAttributeArray("vertex");
+    program->disableAttributeArray("spread");
+    program->disableAttributeArray("value");
+    program->disableAttributeArray("selected");
+    buffer->release();
+    glBindTexture(GL_TEXTURE_1D, 0);
+    program->release();
+}
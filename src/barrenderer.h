@@ -0,0 +1,75 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+//
+// This file is part of Ravel.
+// Written by Kate Isaacs, kisaacs@acm.org, All rights reserved.
+// LLNL-CODE-663885
+//
+// For details, see https://github.com/scalability-llnl/ravel
+// Please also see the LICENSE file for our notice and the LGPL.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (as published by
+// the Free Software Foundation) version 2.1 dated February 1999.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the IMPLIED WARRANTY OF
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the terms and
+// conditions of the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//////////////////////////////////////////////////////////////////////////////
+#ifndef BARRENDERER_H
+#define BARRENDERER_H
+
+#include <QGLBuffer>
+#include <QGLShaderProgram>
+#include <QVector>
+#include <QPointF>
+
+class ColorMap;
+
+// Retained GL drawing of metric colored bars. The bars are uploaded once
+// in world coordinates and colored in a shader through the colormap held
+// as a 1-D texture, so panning and zooming only change uniforms.
+class BarRenderer
+{
+public:
+    BarRenderer();
+    ~BarRenderer();
+
+    // Needs a current context. False if shaders are not available.
+    bool initialize();
+    bool isReady() { return ready; }
+
+    // Each bar is four corners, each corner six floats in order:
+    // world x, world y, spread x, spread y, metric value, selected.
+    // Spread is -1 or 1 and says which way the corner moves when bars
+    // are widened for overplotting.
+    static const int floatsPerVertex = 6;
+    static const int verticesPerBar = 4;
+    static void appendBar(QVector<GLfloat> * vertices,
+                          float x, float y, float w, float h,
+                          float value, bool selected);
+
+    void setBars(const QVector<GLfloat>& vertices);
+    void setColorMap(ColorMap * colormap);
+    int numBars() { return num_bars; }
+
+    // Draws count bars starting at first. The world rectangle with corner
+    // origin and size extent fills the current viewport.
+    void draw(int first, int count, QPointF origin, QPointF extent,
+              QPointF spread, float opacity, float dimmed);
+
+private:
+    bool ready;
+    int num_bars;
+    QGLShaderProgram * program;
+    QGLBuffer * buffer;
+    GLuint texture;
+};
+
+#endif // BARRENDERER_H
@@ -0,0 +1,205 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+//
+// This file is part of Ravel.
+// Written by Kate Isaacs, kisaacs@acm.org, All rights reserved.
+// LLNL-CODE-663885
+//
+// For details, see https://github.com/scalability-llnl/ravel
+// Please also see the LICENSE file for our notice and the LGPL.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (as published by
+// the Free Software Foundation) version 2.1 dated February 1999.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the IMPLIED WARRANTY OF
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the terms and
+// conditions of the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//////////////////////////////////////////////////////////////////////////////
+/* Ravel batch processing, no windows */
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QFile>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <iostream>
+
+#include "general_util.h"
+#include "trace.h"
+#include "otfconverter.h"
+#include "otfimportoptions.h"
+#include "otf2exporter.h"
+#include "tracesnapshot.h"
+#include "processingprofile.h"
+
+// Adds one phase to the report and restarts the timer
+static void reportPhase(QJsonArray& phases, QString name, QElapsedTimer& timer)
+{
+    QJsonObject phase;
+    phase["name"] = name;
+    phase["seconds"] = timer.nsecsElapsed() * 1e-9;
+    phase["peak_rss_bytes"] = double(gu_peakMemory());
+    phases.append(phase);
+    timer.restart();
+}
+
+int main(int argc, char **argv)
+{
+    QCoreApplication app(argc, argv);
+    // Same name as the GUI so snapshots land in the cache it reads
+    QCoreApplication::setApplicationName("Ravel");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Process a trace without the Ravel GUI "
+                                     "and report per-phase timings as JSON.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("trace", "OTF or OTF2 trace to process.");
+    QCommandLineOption saveOption(QStringList() << "s" << "save",
+                                  "Write the processed trace as a Ravel OTF2 "
+                                  "archive.", "file.otf2");
+    QCommandLineOption snapshotOption("snapshot",
+                                      "Write a snapshot to the cache Ravel "
+                                      "checks when opening this trace.");
+    QCommandLineOption setOption(QStringList() << "o" << "option",
+                                 "Set an import option, e.g. "
+                                 "option_leapMerge=true. May be repeated.",
+                                 "name=value");
+    QCommandLineOption reportOption(QStringList() << "r" << "report",
+                                    "Write the JSON report here instead of "
+                                    "to standard output.", "file");
+    QCommandLineOption chromeOption("chrome-trace",
+                                    "Write the processing profile in Chrome "
+                                    "trace event format.", "file");
+    parser.addOption(saveOption);
+    parser.addOption(snapshotOption);
+    parser.addOption(setOption);
+    parser.addOption(reportOption);
+    parser.addOption(chromeOption);
+    parser.process(app);
+
+    if (parser.positionalArguments().size() != 1)
+        parser.showHelp(1);
+    QString dataFileName = parser.positionalArguments().first();
+    if (!QFileInfo(dataFileName).exists())
+    {
+        std::cerr << "No such trace: " << dataFileName.toStdString() << std::endl;
+        return 1;
+    }
+
+    OTFImportOptions options = OTFImportOptions();
+    QStringList settings = parser.values(setOption);
+    for (QStringList::Iterator setting = settings.begin();
+         setting != settings.end(); ++setting)
+    {
+        int split = setting->indexOf('=');
+        if (split < 0)
+            options.setOption(*setting, "true");
+        else
+            options.setOption(setting->left(split), setting->mid(split + 1));
+    }
+
+    // Progress output from the pipeline goes to stderr so stdout is
+    // left for the report
+    std::streambuf * stdout_buffer = std::cout.rdbuf(std::cerr.rdbuf());
+
+    QJsonArray phases;
+    QElapsedTimer totalTimer, phaseTimer;
+    totalTimer.start();
+    phaseTimer.start();
+
+    OTFConverter * importer = new OTFConverter();
+    Trace * trace = NULL;
+    if (dataFileName.endsWith("otf", Qt::CaseInsensitive))
+    {
+        options.origin = OTFImportOptions::OF_OTF;
+        trace = importer->importOTF(dataFileName, &options);
+    }
+    else
+    {
+        options.origin = OTFImportOptions::OF_OTF2;
+        options.waitallMerge = false; // Not applicable
+        trace = importer->importOTF2(dataFileName, &options);
+    }
+    delete importer;
+    reportPhase(phases, "import", phaseTimer);
+
+    if (trace->options.origin == OTFImportOptions::OF_SAVE_OTF2)
+        trace->preprocessFromSaved();
+    else
+        trace->preprocess(&options);
+    reportPhase(phases, "preprocess", phaseTimer);
+
+    bool ok = true;
+    if (parser.isSet(saveOption))
+    {
+        QFileInfo saveFile = QFileInfo(parser.value(saveOption));
+        OTF2Exporter exporter(trace);
+        exporter.exportTrace(saveFile.path(), saveFile.fileName());
+        reportPhase(phases, "export", phaseTimer);
+    }
+
+    if (parser.isSet(snapshotOption))
+    {
+        TraceSnapshot snapshot(dataFileName, &options);
+        ok = snapshot.save(trace) && ok;
+        reportPhase(phases, "snapshot", phaseTimer);
+    }
+
+    std::cout.rdbuf(stdout_buffer);
+
+    int num_events = 0;
+    for (int i = 0; i < trace->num_tasks; i++)
+        num_events += trace->events->at(i)->size();
+
+    QJsonObject report;
+    report["trace"] = QFileInfo(dataFileName).absoluteFilePath();
+    report["tasks"] = trace->num_tasks;
+    report["events"] = num_events;
+    report["partitions"] = trace->partitions->size();
+    report["steps"] = trace->global_max_step + 1;
+    report["phases"] = phases;
+    report["total_seconds"] = totalTimer.nsecsElapsed() * 1e-9;
+    report["peak_rss_bytes"] = double(gu_peakMemory());
+    report["ok"] = ok;
+    report["profile"] = QJsonDocument::fromJson(trace->profile->toJson()).object();
+    QByteArray json = QJsonDocument(report).toJson();
+
+    if (parser.isSet(chromeOption))
+    {
+        QFile chromeFile(parser.value(chromeOption));
+        if (chromeFile.open(QIODevice::WriteOnly | QIODevice::Truncate))
+            chromeFile.write(trace->profile->toChromeTrace());
+        else
+            std::cerr << "Could not write Chrome trace to "
+                      << parser.value(chromeOption).toStdString() << std::endl;
+    }
+
+    delete trace;
+
+    if (parser.isSet(reportOption))
+    {
+        QFile reportFile(parser.value(reportOption));
+        if (!reportFile.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        {
+            std::cerr << "Could not write report to "
+                      << parser.value(reportOption).toStdString() << std::endl;
+            return 1;
+        }
+        reportFile.write(json);
+    }
+    else
+    {
+        std::cout << json.constData();
+    }
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,256 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+//
+// This file is part of Ravel.
+// Written by Kate Isaacs, kisaacs@acm.org, All rights reserved.
+// LLNL-CODE-663885
+//
+// For details, see https://github.com/scalability-llnl/ravel
+// Please also see the LICENSE file for our notice and the LGPL.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (as published by
+// the Free Software Foundation) version 2.1 dated February 1999.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the IMPLIED WARRANTY OF
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the terms and
+// conditions of the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//////////////////////////////////////////////////////////////////////////////
+/* Ravel scaling benchmark on synthetic traces */
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QTemporaryDir>
+#include <QDir>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QStringList>
+#include <iostream>
+#include <cmath>
+
+#include "trace.h"
+#include "otfconverter.h"
+#include "otfimportoptions.h"
+#include "synthetictrace.h"
+#include "processingprofile.h"
+
+// Adds one phase to the run and restarts the timer
+static void reportPhase(QJsonArray& phases, QString name, QElapsedTimer& timer)
+{
+    QJsonObject phase;
+    phase["name"] = name;
+    phase["seconds"] = timer.nsecsElapsed() * 1e-9;
+    phase["peak_rss_bytes"] = double(gu_peakMemory());
+    phases.append(phase);
+    timer.restart();
+}
+
+// Generate, import and process one synthetic trace
+static QJsonObject runBenchmark(SyntheticTrace& synthetic, QString dir)
+{
+    QJsonArray phases;
+    QJsonObject run;
+    run["pattern"] = SyntheticTrace::patternName(synthetic.pattern);
+    run["ranks"] = synthetic.ranks;
+    run["iterations"] = synthetic.iterations;
+    run["depth"] = synthetic.depth;
+
+    QString filename = QString("%1_%2").arg(run["pattern"].toString())
+                                       .arg(synthetic.ranks);
+    QElapsedTimer timer;
+    timer.start();
+    if (!synthetic.write(dir, filename))
+    {
+        run["error"] = QString("could not write archive");
+        return run;
+    }
+    reportPhase(phases, "generate", timer);
+
+    OTFImportOptions options = OTFImportOptions();
+    options.origin = OTFImportOptions::OF_OTF2;
+    options.waitallMerge = false; // Not applicable
+    options.seedClusters = true; // Same clusters every run
+
+    OTFConverter * importer = new OTFConverter();
+    Trace * trace = importer->importOTF2(QDir(dir).filePath(filename + ".otf2"),
+                                         &options);
+    delete importer;
+    reportPhase(phases, "import", timer);
+
+    // The phases of Trace::preprocess, timed one at a time
+    trace->options = options;
+    trace->partition();
+    reportPhase(phases, "partition", timer);
+
+    trace->assignSteps();
+    reportPhase(phases, "steps", timer);
+
+    trace->clusterTasks();
+    if (options.cluster)
+        reportPhase(phases, "gnomify", timer);
+
+    trace->compactCallTrees();
+    if (options.compactCallTrees || options.pageCallTrees)
+        reportPhase(phases, "compact", timer);
+
+    trace->buildIndexes();
+    trace->addPartitionMetric();
+    reportPhase(phases, "index", timer);
+
+    int num_events = 0;
+    for (int i = 0; i < trace->num_tasks; i++)
+        num_events += trace->events->at(i)->size();
+    run["events"] = num_events;
+    run["partitions"] = trace->partitions->size();
+    run["steps"] = trace->global_max_step + 1;
+    // Finer grained merge and stepping phases plus the partition counts
+    run["profile"] = QJsonDocument::fromJson(trace->profile->toJson()).object();
+
+    delete trace;
+    reportPhase(phases, "free", timer);
+
+    run["phases"] = phases;
+    return run;
+}
+
+// Growth of each phase between consecutive sizes of one pattern as the
+// exponent k in time ~ ranks^k
+static QJsonArray scalingCurves(QJsonArray runs)
+{
+    QJsonArray curves;
+    for (int i = 1; i < runs.size(); i++)
+    {
+        QJsonObject small = runs.at(i - 1).toObject();
+        QJsonObject large = runs.at(i).toObject();
+        if (small["pattern"] != large["pattern"] || small.contains("error")
+            || large.contains("error"))
+        {
+            continue;
+        }
+
+        double rank_ratio = large["ranks"].toDouble() / small["ranks"].toDouble();
+        QJsonObject exponents;
+        QJsonArray small_phases = small["phases"].toArray();
+        QJsonArray large_phases = large["phases"].toArray();
+        for (int p = 0; p < small_phases.size() && p < large_phases.size(); p++)
+        {
+            double before = small_phases.at(p).toObject()["seconds"].toDouble();
+            double after = large_phases.at(p).toObject()["seconds"].toDouble();
+            if (before > 0 && after > 0 && rank_ratio > 1)
+                exponents[small_phases.at(p).toObject()["name"].toString()]
+                        = log(after / before) / log(rank_ratio);
+        }
+
+        QJsonObject curve;
+        curve["pattern"] = small["pattern"];
+        curve["from_ranks"] = small["ranks"];
+        curve["to_ranks"] = large["ranks"];
+        curve["exponents"] = exponents;
+        curves.append(curve);
+    }
+    return curves;
+}
+
+int main(int argc, char **argv)
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Time Ravel's import and structure "
+                                     "extraction on synthetic OTF2 traces.");
+    parser.addHelpOption();
+    QCommandLineOption patternOption(QStringList() << "p" << "patterns",
+                                     "Comma separated patterns: stencil, "
+                                     "alltoall, masterworker, isendburst, "
+                                     "collective. Default all.", "list");
+    QCommandLineOption ranksOption(QStringList() << "r" << "ranks",
+                                   "Comma separated rank counts.", "list",
+                                   "16,64,256");
+    QCommandLineOption iterationsOption(QStringList() << "i" << "iterations",
+                                        "Iterations per rank.", "count", "20");
+    QCommandLineOption depthOption(QStringList() << "d" << "depth",
+                                   "Calls above each MPI call.", "count", "3");
+    QCommandLineOption dirOption("dir", "Keep the archives in this directory.",
+                                 "path");
+    parser.addOption(patternOption);
+    parser.addOption(ranksOption);
+    parser.addOption(iterationsOption);
+    parser.addOption(depthOption);
+    parser.addOption(dirOption);
+    parser.process(app);
+
+    QList<SyntheticTrace::Pattern> patterns = SyntheticTrace::allPatterns();
+    if (parser.isSet(patternOption))
+    {
+        patterns.clear();
+        QStringList names = parser.value(patternOption).split(',');
+        for (QStringList::Iterator name = names.begin(); name != names.end();
+             ++name)
+        {
+            SyntheticTrace::Pattern pattern;
+            if (!SyntheticTrace::patternFromName(name->trimmed(), &pattern))
+            {
+                std::cerr << "Unknown pattern: " << name->toStdString()
+                          << std::endl;
+                return 1;
+            }
+            patterns.append(pattern);
+        }
+    }
+
+    QList<int> rank_counts = QList<int>();
+    QStringList counts = parser.value(ranksOption).split(',');
+    for (QStringList::Iterator count = counts.begin(); count != counts.end();
+         ++count)
+    {
+        int ranks = count->toInt();
+        if (ranks < 1)
+        {
+            std::cerr << "Bad rank count: " << count->toStdString() << std::endl;
+            return 1;
+        }
+        rank_counts.append(ranks);
+    }
+    qSort(rank_counts);
+
+    int iterations = qMax(1, parser.value(iterationsOption).toInt());
+    int depth = qMax(0, parser.value(depthOption).toInt());
+
+    QTemporaryDir temp_dir;
+    QString dir = parser.isSet(dirOption) ? parser.value(dirOption)
+                                          : temp_dir.path();
+    QDir().mkpath(dir);
+
+    // Progress output from the pipeline goes to stderr so stdout is
+    // left for the report
+    std::streambuf * stdout_buffer = std::cout.rdbuf(std::cerr.rdbuf());
+
+    // Peak memory only grows, so runs go from small to large
+    QJsonArray runs;
+    for (QList<SyntheticTrace::Pattern>::Iterator pattern = patterns.begin();
+         pattern != patterns.end(); ++pattern)
+    {
+        for (QList<int>::Iterator ranks = rank_counts.begin();
+             ranks != rank_counts.end(); ++ranks)
+        {
+            SyntheticTrace synthetic(*pattern, *ranks, iterations, depth);
+            runs.append(runBenchmark(synthetic, dir));
+        }
+    }
+
+    std::cout.rdbuf(stdout_buffer);
+
+    QJsonObject report;
+    report["runs"] = runs;
+    report["scaling"] = scalingCurves(runs);
+    std::cout << QJsonDocument(report).toJson().constData();
+
+    return 0;
+}
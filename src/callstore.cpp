@@ -0,0 +1,98 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+//
+// This file is part of Ravel.
+// Written by Kate Isaacs, kisaacs@acm.org, All rights reserved.
+// LLNL-CODE-663885
+//
+// For details, see https://github.com/scalability-llnl/ravel
+// Please also see the LICENSE file for our notice and the LGPL.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (as published by
+// the Free Software Foundation) version 2.1 dated February 1999.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the IMPLIED WARRANTY OF
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the terms and
+// conditions of the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//////////////////////////////////////////////////////////////////////////////
+#include "callstore.h"
+#include <QDir>
+#include <QMutexLocker>
+
+CallStore::CallStore(qint64 _budget)
+    : mutex(),
+      file(QDir::tempPath() + "/ravel-calls-XXXXXX"),
+      pages(QVector<Page>()),
+      resident(QHash<int, Resident>()),
+      order(QMap<quint64, int>()),
+      clock(0),
+      budget(_budget),
+      held(0),
+      stored(0)
+{
+}
+
+bool CallStore::open()
+{
+    QMutexLocker locker(&mutex);
+    return file.isOpen() || file.open();
+}
+
+// Pages are only appended, so a write never moves an existing page
+int CallStore::store(const QByteArray& bytes)
+{
+    QMutexLocker locker(&mutex);
+    if (!file.isOpen() || !file.seek(stored))
+        return -1;
+    if (file.write(bytes) != bytes.size())
+        return -1;
+
+    pages.append(Page(stored, bytes.size()));
+    stored += bytes.size();
+    return pages.size() - 1;
+}
+
+QByteArray CallStore::load(int page)
+{
+    QMutexLocker locker(&mutex);
+    if (page < 0 || page >= pages.size())
+        return QByteArray();
+
+    if (resident.contains(page))
+    {
+        Resident& hit = resident[page];
+        order.remove(hit.used);
+        hit.used = ++clock;
+        order.insert(hit.used, page);
+        return hit.bytes;
+    }
+
+    const Page& where = pages.at(page);
+    Resident loaded = Resident();
+    if (file.seek(where.offset))
+        loaded.bytes = file.read(where.length);
+    if (loaded.bytes.size() != where.length)
+        return QByteArray();
+
+    // The page asked for is returned even when it alone is over budget
+    while (!order.isEmpty() && held + where.length > budget)
+    {
+        int oldest = order.begin().value();
+        order.erase(order.begin());
+        held -= resident.value(oldest).bytes.size();
+        resident.remove(oldest);
+    }
+
+    loaded.used = ++clock;
+    resident.insert(page, loaded);
+    order.insert(loaded.used, page);
+    held += where.length;
+    return loaded.bytes;
+}
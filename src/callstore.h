@@ -0,0 +1,81 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+//
+// This file is part of Ravel.
+// Written by Kate Isaacs, kisaacs@acm.org, All rights reserved.
+// LLNL-CODE-663885
+//
+// For details, see https://github.com/scalability-llnl/ravel
+// Please also see the LICENSE file for our notice and the LGPL.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (as published by
+// the Free Software Foundation) version 2.1 dated February 1999.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the IMPLIED WARRANTY OF
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the terms and
+// conditions of the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//////////////////////////////////////////////////////////////////////////////
+#ifndef CALLSTORE_H
+#define CALLSTORE_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QMap>
+#include <QMutex>
+#include <QTemporaryFile>
+#include <QVector>
+
+// Packed call records kept in a temporary file, with only the most
+// recently used pages held in memory under a budget. Each page is the
+// records of one PackedCalls. Pages are loaded by both the GUI and the
+// frame builder thread, so everything is behind the mutex.
+class CallStore
+{
+public:
+    CallStore(qint64 _budget);
+
+    bool open();
+
+    // The page written, -1 if it could not be
+    int store(const QByteArray& bytes);
+    QByteArray load(int page);
+
+    qint64 bytesStored() { return stored; }
+
+private:
+    class Page {
+    public:
+        Page() : offset(0), length(0) {}
+        Page(qint64 _offset, int _length) : offset(_offset), length(_length) {}
+
+        qint64 offset;
+        int length;
+    };
+
+    class Resident {
+    public:
+        Resident() : bytes(QByteArray()), used(0) {}
+
+        QByteArray bytes;
+        quint64 used;
+    };
+
+    QMutex mutex;
+    QTemporaryFile file;
+    QVector<Page> pages;
+    QHash<int, Resident> resident;
+    QMap<quint64, int> order; // pages by last use, least recent first
+    quint64 clock;
+    qint64 budget; // bytes
+    qint64 held; // bytes in memory
+    qint64 stored; // bytes on disk
+};
+
+#endif // CALLSTORE_H
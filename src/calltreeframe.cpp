@@ -0,0 +1,384 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+//
+// This file is part of Ravel.
+// Written by Kate Isaacs, kisaacs@acm.org, All rights reserved.
+// LLNL-CODE-663885
+//
+// For details, see https://github.com/scalability-llnl/ravel
+// Please also see the LICENSE file for our notice and the LGPL.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (as published by
+// the Free Software Foundation) version 2.1 dated February 1999.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the IMPLIED WARRANTY OF
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the terms and
+// conditions of the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//////////////////////////////////////////////////////////////////////////////
+#include "calltreeframe.h"
+#include <QPainter>
+#include <QFont>
+#include <cmath>
+
+#include "viswidget.h"
+#include "trace.h"
+#include "event.h"
+#include "packedcalls.h"
+#include "labelcache.h"
+#include "timepyramid.h"
+
+CallTreeFrame::CallTreeFrame(Trace * _trace, QList<TileKey> _tiles,
+                             QMap<int, int> _order_to_proc,
+                             Event * _selected_event,
+                             LabelCache * _labels)
+    : FrameJob(QSize(TileCache::tileSize * _tiles.size(),
+                     TileCache::tileSize)),
+      trace(_trace),
+      tiles(_tiles),
+      width(TileCache::tileSize),
+      labelWidth(0),
+      canvasHeight(TileCache::tileSize),
+      startTime(0),
+      timeSpan(0),
+      time_scale(1),
+      startTask(0),
+      taskSpan(0),
+      order_to_proc(_order_to_proc),
+      selected_event(_selected_event),
+      labels(_labels),
+      task_spacing(0),
+      blockheight(0),
+      barheight(0),
+      extents(QRect(0, 0, TileCache::tileSize, TileCache::tileSize))
+{
+}
+
+unsigned long long CallTreeFrame::tileTime(const TileKey& key)
+{
+    return floor(key.x * double(TileCache::tileSize) * key.time_scale);
+}
+
+float CallTreeFrame::tileTask(const TileKey& key)
+{
+    return key.y * TileCache::tileSize / key.task_scale;
+}
+
+bool CallTreeFrame::render(QPainter * painter, FrameBuilder * builder)
+{
+    painter->setFont(QFont("Helvetica", 10));
+    labels->setTrace(trace);
+    labels->setFont(painter->font());
+    for (int i = 0; i < tiles.size(); ++i)
+    {
+        if (builder->isStale(generation))
+            return false;
+
+        painter->save();
+        painter->translate(i * TileCache::tileSize, 0);
+        painter->setClipRect(extents);
+        paintTile(painter, tiles.at(i), builder);
+        painter->restore();
+    }
+    return true;
+}
+
+// Positions follow the widget's, with the tile's corner standing in for
+// the start of the view
+void CallTreeFrame::paintTile(QPainter * painter, const TileKey& key,
+                              FrameBuilder * builder)
+{
+    startTime = tileTime(key);
+    time_scale = key.time_scale;
+    timeSpan = ceil(time_scale * width);
+    startTask = tileTask(key);
+    taskSpan = canvasHeight / key.task_scale;
+    blockheight = key.task_scale;
+    task_spacing = 0;
+    if (blockheight > 12)
+        task_spacing = 3;
+    barheight = blockheight - task_spacing;
+    painter->setPen(QPen(QColor(0, 0, 0)));
+
+    // When a pixel covers a whole summary bin, draw from the summaries
+    // rather than walking every call tree. Summaries shared by a group of
+    // tasks are only used while the group fits in a pixel row.
+    int level = trace->time_pyramid->findLevel(key.time_scale);
+    int group = trace->time_pyramid->taskGroup();
+    if (group > 1 && group * blockheight > 1)
+        level = -1;
+
+    int start = std::max(int(floor(startTask)), 0);
+    int end = std::min(int(ceil(startTask + taskSpan)),
+                       trace->num_tasks - 1);
+    int last_row = -1;
+    int last_group = -1;
+    for (int i = start; i <= end; ++i)
+    {
+        if (builder->isStale(generation))
+            return;
+
+        int position = order_to_proc.value(i);
+        if (level >= 0)
+        {
+            // Tasks of a group landing on the same pixel row look the same
+            int row = floor((position - startTask) * blockheight);
+            bool repeat = group > 1 && row == last_row
+                          && i / group == last_group;
+            last_row = row;
+            last_group = i / group;
+            paintSummaryEvents(painter, i, position, level, !repeat);
+            continue;
+        }
+
+        QVector<Event *> * roots = trace->roots->at(i);
+        for (QVector<Event *>::Iterator root = roots->begin();
+             root != roots->end(); ++root)
+        {
+            paintNotStepEvents(painter, *root, position);
+        }
+    }
+}
+
+// To make sure events have correct overlapping, this draws from the root down
+// TODO: Have a level cut off so we don't descend all the way down the tree
+void CallTreeFrame::paintNotStepEvents(QPainter *painter, Event * evt,
+                                       float position)
+{
+    if (evt->enter > startTime + timeSpan || evt->exit < startTime)
+        return; // Out of time
+    if (evt->isCommEvent())
+        return; // Drawn by the widget
+    if (evt->isPacked())
+    {
+        paintPackedCalls(painter, static_cast<PackedCalls *>(evt), position);
+        return;
+    }
+
+    if ((evt->exit - evt->enter) / time_scale >= 2) // Don't draw tiny events
+    {
+        unsigned long long drawnEnter = std::max(startTime, evt->enter);
+        paintCall(painter, evt->enter, evt->exit, evt->function, evt->depth,
+                  evt->getVisibleEnd(drawnEnter), evt == selected_event,
+                  position);
+    }
+
+    for (QVector<Event *>::Iterator child = evt->callees->begin();
+         child != evt->callees->end(); ++child)
+    {
+        paintNotStepEvents(painter, *child, position);
+    }
+
+
+}
+
+// Only the calls in this tile's span are decoded. They come callers
+// first, so they overlap like the events they stand for.
+void CallTreeFrame::paintPackedCalls(QPainter *painter, PackedCalls * packed,
+                                     float position)
+{
+    QVector<PackedCalls::Call> calls = QVector<PackedCalls::Call>();
+    packed->decode(&calls, startTime, startTime + timeSpan);
+
+    // A label runs until the first callee entered after it starts showing
+    QVector<unsigned long long> visible_ends = QVector<unsigned long long>();
+    visible_ends.reserve(calls.size());
+    QVector<bool> ended = QVector<bool>(calls.size(), false);
+    for (int i = 0; i < calls.size(); ++i)
+    {
+        const PackedCalls::Call& call = calls.at(i);
+        visible_ends.append(call.exit);
+        int parent = call.parent;
+        if (parent >= 0 && !ended.at(parent)
+            && call.enter > std::max(startTime, calls.at(parent).enter))
+        {
+            visible_ends[parent] = call.enter;
+            ended[parent] = true;
+        }
+    }
+
+    // The selection may be one of these, made for the GUI by the stub
+    bool selected_here = selected_event && !selected_event->isCommEvent()
+                         && selected_event->task == packed->task;
+    for (int i = 0; i < calls.size(); ++i)
+    {
+        const PackedCalls::Call& call = calls.at(i);
+        if ((call.exit - call.enter) / time_scale < 2)
+            continue;
+
+        bool selected = selected_here && selected_event->enter == call.enter
+                        && selected_event->depth == call.depth;
+        paintCall(painter, call.enter, call.exit, call.function, call.depth,
+                  visible_ends.at(i), selected, position);
+    }
+}
+
+void CallTreeFrame::paintCall(QPainter *painter, unsigned long long enter,
+                              unsigned long long exit, int function,
+                              int depth, unsigned long long visible_end,
+                              bool selected, float position)
+{
+    int x, y, w, h;
+    w = (exit - enter) / time_scale;
+    y = floor((position - startTask) * blockheight) + 1;
+    x = floor(static_cast<long long>(enter - startTime)
+              / time_scale) + 1 + labelWidth;
+    h = barheight;
+
+
+    // Corrections for partially drawn
+    bool complete = true;
+    if (y < 0) {
+        h = barheight - fabs(y);
+        y = 0;
+        complete = false;
+    } else if (y + barheight > canvasHeight) {
+        h = canvasHeight - y;
+        complete = false;
+    }
+    if (x < labelWidth) {
+        w -= (labelWidth - x);
+        x = labelWidth;
+        complete = false;
+    } else if (x + w > width) {
+        w = width - x;
+        complete = false;
+    }
+
+
+    // Change pen color if selected
+    if (selected)
+        painter->setPen(QPen(Qt::yellow));
+
+
+    if (selected)
+        painter->fillRect(QRectF(x, y, w, h), QBrush(Qt::yellow));
+    else
+    {
+        // Draw event
+        int graycolor = std::max(100, 100 + depth * 20);
+        painter->fillRect(QRectF(x, y, w, h),
+                          QBrush(QColor(graycolor, graycolor, graycolor)));
+    }
+
+
+    // Draw border
+    if (task_spacing > 0)
+    {
+        if (complete)
+            painter->drawRect(QRectF(x,y,w,h));
+        else
+            VisWidget::incompleteBox(painter, x, y, w, h, &extents);
+    }
+
+    // Revert pen color
+    if (selected)
+        painter->setPen(QPen(QColor(0, 0, 0)));
+
+    unsigned long long drawnEnter = std::max(startTime, enter);
+    unsigned long long available_w = (visible_end - drawnEnter)
+                                     / time_scale + 2;
+
+    if (labels->height() < h)
+    {
+        QString fxnName = labels->label(function, available_w);
+        if (!fxnName.isEmpty())
+            painter->drawText(x + 2, y + labels->height(), fxnName);
+    }
+}
+
+// Draw runs of like bins from the time summary at the given level. The
+// selected event is still drawn from the call tree so it stands out.
+void CallTreeFrame::paintSummaryEvents(QPainter *painter, int task,
+                                       float position, int level,
+                                       bool bins)
+{
+    TimePyramid * pyramid = trace->time_pyramid;
+    unsigned long long stopTime = startTime + timeSpan;
+
+    int y = floor((position - startTask) * blockheight) + 1;
+    int h = barheight;
+    bool complete = true;
+    if (y < 0) {
+        h = barheight - fabs(y);
+        y = 0;
+        complete = false;
+    } else if (y + barheight > canvasHeight) {
+        h = canvasHeight - y;
+        complete = false;
+    }
+
+    int first = pyramid->binIndex(level, startTime);
+    int last = pyramid->binIndex(level, stopTime);
+    int run_start = bins ? first : last + 1;
+    while (run_start <= last)
+    {
+        const TimePyramid::TimeBin& bin = pyramid->bin(task, level,
+                                                       run_start);
+        int run_stop = run_start + 1;
+        while (run_stop <= last)
+        {
+            const TimePyramid::TimeBin& next = pyramid->bin(task, level,
+                                                            run_stop);
+            if (next.function != bin.function || next.depth != bin.depth)
+                break;
+            ++run_stop;
+        }
+
+        if (bin.function >= 0)
+        {
+            unsigned long long run_enter = std::max(startTime,
+                                                    pyramid->binStart(level,
+                                                                      run_start));
+            unsigned long long run_exit = std::min(stopTime,
+                                                   pyramid->binStart(level,
+                                                                     run_stop));
+            int x = floor(static_cast<long long>(run_enter - startTime)
+                          / time_scale) + 1 + labelWidth;
+            int w = (run_exit - run_enter) / time_scale;
+            bool run_complete = complete;
+            if (x + w > width) {
+                w = width - x;
+                run_complete = false;
+            }
+
+            if (w >= 1)
+            {
+                int graycolor = std::max(100, 100 + bin.depth * 20);
+                painter->fillRect(QRectF(x, y, w, h),
+                                  QBrush(QColor(graycolor, graycolor,
+                                                graycolor)));
+
+                if (task_spacing > 0)
+                {
+                    if (run_complete)
+                        painter->drawRect(QRectF(x, y, w, h));
+                    else
+                        VisWidget::incompleteBox(painter, x, y, w, h,
+                                                 &extents);
+                }
+
+                if (labels->height() < h)
+                {
+                    QString fxnName = labels->label(bin.function, w);
+                    if (!fxnName.isEmpty())
+                        painter->drawText(x + 2, y + labels->height(),
+                                          fxnName);
+                }
+            }
+        }
+        run_start = run_stop;
+    }
+
+    if (selected_event && !selected_event->isCommEvent()
+        && selected_event->task == task)
+    {
+        paintNotStepEvents(painter, selected_event, position);
+    }
+}
@@ -0,0 +1,89 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+//
+// This file is part of Ravel.
+// Written by Kate Isaacs, kisaacs@acm.org, All rights reserved.
+// LLNL-CODE-663885
+//
+// For details, see https://github.com/scalability-llnl/ravel
+// Please also see the LICENSE file for our notice and the LGPL.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (as published by
+// the Free Software Foundation) version 2.1 dated February 1999.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the IMPLIED WARRANTY OF
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the terms and
+// conditions of the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//////////////////////////////////////////////////////////////////////////////
+#ifndef CALLTREEFRAME_H
+#define CALLTREEFRAME_H
+
+#include "framebuilder.h"
+#include "tilecache.h"
+#include <QMap>
+#include <QRect>
+#include <QList>
+
+class Trace;
+class Event;
+class PackedCalls;
+class LabelCache;
+
+// Tiles of the physical timeline's call tree layer, everything but the
+// communication events, drawn on the frame builder thread. The tiles
+// are laid side by side in the frame in the order they were asked for.
+// The label cache is only touched from the frame builder thread.
+class CallTreeFrame : public FrameJob
+{
+public:
+    CallTreeFrame(Trace * _trace, QList<TileKey> _tiles,
+                  QMap<int, int> _order_to_proc, Event * _selected_event,
+                  LabelCache * _labels);
+
+    bool render(QPainter * painter, FrameBuilder * builder);
+
+    // Where the tile starts in time and tasks
+    static unsigned long long tileTime(const TileKey& key);
+    static float tileTask(const TileKey& key);
+
+private:
+    void paintTile(QPainter *painter, const TileKey& key,
+                   FrameBuilder * builder);
+    void paintNotStepEvents(QPainter *painter, Event * evt, float position);
+    void paintPackedCalls(QPainter *painter, PackedCalls * packed,
+                          float position);
+    void paintCall(QPainter *painter, unsigned long long enter,
+                   unsigned long long exit, int function, int depth,
+                   unsigned long long visible_end, bool selected,
+                   float position);
+    void paintSummaryEvents(QPainter *painter, int task, float position,
+                            int level, bool bins = true);
+
+    Trace * trace;
+    QList<TileKey> tiles;
+    int width;
+    int labelWidth;
+    int canvasHeight;
+    unsigned long long startTime;
+    unsigned long long timeSpan;
+    double time_scale; // time per pixel
+    float startTask;
+    float taskSpan;
+    QMap<int, int> order_to_proc;
+    Event * selected_event;
+    LabelCache * labels;
+
+    int task_spacing;
+    float blockheight;
+    float barheight;
+    QRect extents;
+};
+
+#endif // CALLTREEFRAME_H
@@ -41,6 +41,12 @@ void ClusterTreeVis::setGnome(Gnome * _gnome)
     //repaint();
 }
 
+void ClusterTreeVis::releaseTrace()
+{
+    VisWidget::releaseTrace();
+    gnome = NULL;
+}
+
 // We'll let the active gnome handle this
 void ClusterTreeVis::qtPaint(QPainter *painter)
 {
@@ -63,7 +69,7 @@ void ClusterTreeVis::mouseDoubleClickEvent(QMouseEvent * event)
         gnome->handleTreeDoubleClick(event);
         changeSource = true;
         emit(clusterChange());
-        repaint();
+        update();
     }
 }
 
@@ -82,5 +88,5 @@ void ClusterTreeVis::clusterChanged()
         return;
     }
 
-    repaint();
+    update();
 }
@@ -34,6 +34,7 @@ public:
     explicit ClusterTreeVis(QWidget *parent = 0,
                             VisOptions * _options = new VisOptions());
     Gnome * getGnome() { return gnome; }
+    void releaseTrace();
 
 signals:
     void clusterChange();
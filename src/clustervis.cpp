@@ -26,6 +26,7 @@
 #include "clustertreevis.h"
 #include "trace.h"
 #include "gnome.h"
+#include "stepindex.h"
 
 #include <QMouseEvent>
 #include <QWheelEvent>
@@ -35,7 +36,7 @@
 ClusterVis::ClusterVis(ClusterTreeVis *ctv, QWidget* parent,
                        VisOptions *_options)
     : TimelineVis(parent, _options),
-      drawnGnomes(QMap<Gnome *, QRect>()),
+      drawnGnomes(HitGrid<Gnome *>(32)),
       selected(NULL),
       treevis(ctv),
       hover_gnome(NULL)
@@ -59,6 +60,13 @@ void ClusterVis::setTrace(Trace * t)
     maxStep = trace->global_max_step;
 }
 
+void ClusterVis::releaseTrace()
+{
+    TimelineVis::releaseTrace();
+    hover_gnome = NULL;
+    drawnGnomes.reset(rect());
+}
+
 // Just like stepvis
 void ClusterVis::setSteps(float start, float stop, bool jump)
 {
@@ -76,7 +84,7 @@ void ClusterVis::setSteps(float start, float stop, bool jump)
 
     if (!closed)
     {
-        repaint();
+        update();
     }
 }
 
@@ -109,7 +117,7 @@ void ClusterVis::mouseMoveEvent(QMouseEvent * event)
         mousex = event->x();
         mousey = event->y();
 
-        repaint();
+        update();
         changeSource = true;
         emit stepsChanged(startStep, startStep + stepSpan, false);
     }
@@ -119,10 +127,10 @@ void ClusterVis::mouseMoveEvent(QMouseEvent * event)
         mousey = event->y();
         Gnome * focus_gnome = treevis->getGnome();
         bool emit_flag = false;
-        if (hover_gnome && drawnGnomes[hover_gnome].contains(mousex, mousey))
+        if (hover_gnome && drawnGnomes.value(hover_gnome).contains(mousex, mousey))
         {
             if (hover_gnome->handleHover(event))
-                repaint();
+                update();
             if (hover_gnome != focus_gnome)
             {
                 treevis->setGnome(hover_gnome);
@@ -131,22 +139,17 @@ void ClusterVis::mouseMoveEvent(QMouseEvent * event)
         }
         else
         {
-            hover_gnome = NULL;
-            for (QMap<Gnome *, QRect>::Iterator grect = drawnGnomes.begin();
-                 grect != drawnGnomes.end(); ++grect)
+            hover_gnome = drawnGnomes.find(mousex, mousey);
+            if (hover_gnome)
             {
-                if (grect.value().contains(mousex, mousey))
+                hover_gnome->handleHover(event);
+                if (hover_gnome != focus_gnome)
                 {
-                    hover_gnome = grect.key();
-                    hover_gnome->handleHover(event);
-                    if (hover_gnome != focus_gnome)
-                    {
-                        treevis->setGnome(hover_gnome);
-                        emit_flag = true;
-                    }
+                    treevis->setGnome(hover_gnome);
+                    emit_flag = true;
                 }
             }
-            repaint();
+            update();
         }
         if (emit_flag)
             emit(focusGnome());
@@ -177,7 +180,7 @@ void ClusterVis::wheelEvent(QWheelEvent * event)
         stepSpan *= scale;
         startStep = avgStep - stepSpan / 2.0;
 
-        repaint();
+        update();
         changeSource = true;
         emit stepsChanged(startStep, startStep + stepSpan, false);
     }
@@ -200,47 +203,40 @@ void ClusterVis::mouseDoubleClickEvent(QMouseEvent * event)
     // the old gnome when a different one has become selected. We should
     // probably just save the one that's currently selected, but this list is
     //fairly short and we need it anyway for other interactions.
-    for (QMap<Gnome *, QRect>::Iterator gnome = drawnGnomes.begin();
-         gnome != drawnGnomes.end(); ++gnome)
+    for (int i = 0; i < drawnGnomes.size(); i++)
     {
-        gnome.key()->setSelected(false);
+        drawnGnomes.itemAt(i)->setSelected(false);
     }
 
-    for (QMap<Gnome *, QRect>::Iterator gnome = drawnGnomes.begin();
-         gnome != drawnGnomes.end(); ++gnome)
+    Gnome * g = drawnGnomes.find(x, y);
+    if (g)
     {
-        if (gnome.value().contains(x,y))
+        Gnome::ChangeType change = g->handleDoubleClick(event);
+        update();
+        if (change == Gnome::CHANGE_CLUSTER) // Clicked to open Cluster
+        {
+            changeSource = true;
+            emit(clusterChange());
+        }
+        else if (change == Gnome::CHANGE_SELECTION) // Selected a cluster
         {
-            Gnome * g = gnome.key();
-            Gnome::ChangeType change = g->handleDoubleClick(event);
-            repaint();
-            if (change == Gnome::CHANGE_CLUSTER) // Clicked to open Cluster
+            changeSource = true;
+            PartitionCluster * pc = g->getSelectedPartitionCluster();
+            if (pc)
             {
-                changeSource = true;
-                emit(clusterChange());
+                changeSource = false;
+                g->setSelected(true);
+                emit(tasksSelected(*(pc->members), g));
+
             }
-            else if (change == Gnome::CHANGE_SELECTION) // Selected a cluster
+            else
             {
-                changeSource = true;
-                PartitionCluster * pc = g->getSelectedPartitionCluster();
-                if (pc)
-                {
-                    changeSource = false;
-                    g->setSelected(true);
-                    emit(tasksSelected(*(pc->members), g));
-
-                }
-                else
-                {
-                    emit(tasksSelected(QList<int>(), NULL));
-                }
+                emit(tasksSelected(QList<int>(), NULL));
             }
-            return;
         }
+        return;
     }
 
-
-
     // If we get here, fall through to normal behavior
     TimelineVis::mouseDoubleClickEvent(event);
 }
@@ -253,7 +249,7 @@ void ClusterVis::clusterChanged()
         return;
     }
 
-    repaint();
+    update();
 }
 
 
@@ -261,64 +257,11 @@ void ClusterVis::clusterChanged()
 void ClusterVis::prepaint()
 {
     closed = false;
-    drawnGnomes.clear();
-
-    // Figure out what partitions we need to search in hopefully a more
-    // efficient manner than iterating through them all by making use of
-    // where we were before and the fact we probably haven't moved that much.
-
-    if (jumped) // We have to redo the active_partitions
-    {
-        // We know this list is in order, so we only have to go so far
-        //int topStep = boundStep(startStep + stepSpan) + 1;
-        int bottomStep = floor(startStep) - 1;
-        Partition * part = NULL;
-        for (int i = 0; i < trace->partitions->length(); ++i)
-        {
-            part = trace->partitions->at(i);
-            if (part->max_global_step >= bottomStep)
-            {
-                startPartition = i;
-                break;
-            }
-        }
-    }
-    else // We nudge the active partitions as necessary
-    {
-        int bottomStep = floor(startStep) - 1;
-        Partition * part = NULL;
-         // check earlier partitions in case wee need to move the start back
-        if (startStep < lastStartStep)
-        {
-             // Keep setting the one before until its right
-            for (int i = startPartition; i >= 0; --i)
-            {
-                part = trace->partitions->at(i);
-                if (part->max_global_step >= bottomStep)
-                {
-                    startPartition = i;
-                }
-                else
-                {
-                    break;
-                }
-            }
-        }
-        else if (startStep > lastStartStep) // check current partitions up
-        {
-             // See if we've advanced the start forward
-            for (int i = startPartition; i < trace->partitions->length(); ++i)
-            {
-                part = trace->partitions->at(i);
-                if (part->max_global_step >= bottomStep)
-                {
-                    startPartition = i;
-                    break;
-                }
-            }
-        }
-    }
+    drawnGnomes.reset(rect());
 
+    // First partition we may need to draw
+    int bottomStep = floor(startStep) - 1;
+    startPartition = trace->step_index->findPartition(bottomStep);
 }
 
 void ClusterVis::qtPaint(QPainter *painter)
@@ -454,7 +397,7 @@ void ClusterVis::paintEvents(QPainter * painter)
                                     part->events->size() / 1.0
                                     / trace->num_tasks * effectiveHeight);
             part->gnome->drawGnomeQt(painter, gnomeRect, options, blockwidth);
-            drawnGnomes[part->gnome] = gnomeRect;
+            drawnGnomes.insert(part->gnome, gnomeRect);
             if (!leftmost)
                 leftmost = part->gnome;
             else if (!nextgnome)
@@ -466,7 +409,7 @@ void ClusterVis::paintEvents(QPainter * painter)
 
     if (!treevis->getGnome())
     {
-        QRect left = drawnGnomes[leftmost];
+        QRect left = drawnGnomes.value(leftmost);
         float left_steps = (std::min(rect().width(), left.x() + left.width())
                             - std::max(0, left.x())) / 1.0 / blockwidth;
         if (left_steps < 2)
@@ -484,7 +427,7 @@ void ClusterVis::changeNeighborRadius(int neighbors)
     {
         treevis->getGnome()->setNeighbors(neighbors);
         emit(neighborChange(neighbors));
-        repaint();
+        update();
     }
 }
 
@@ -38,6 +38,7 @@ public:
                VisOptions *_options = new VisOptions());
     ~ClusterVis() {}
     void setTrace(Trace * t);
+    void releaseTrace();
 
     void mouseMoveEvent(QMouseEvent * event);
     void wheelEvent(QWheelEvent * event);
@@ -60,7 +61,7 @@ protected:
     void prepaint();
     void mouseDoubleClickEvent(QMouseEvent * event);
 
-    QMap<Gnome *, QRect> drawnGnomes;
+    HitGrid<Gnome *> drawnGnomes;
     PartitionCluster * selected;
     ClusterTreeVis * treevis;
     Gnome * hover_gnome;
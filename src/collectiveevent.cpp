@@ -34,9 +34,9 @@ CollectiveEvent::CollectiveEvent(unsigned long long _enter,
 {
 }
 
+// The record is shared by every member, the trace frees it
 CollectiveEvent::~CollectiveEvent()
 {
-    delete collective;
 }
 
 // We check mark so we only do this once per collective,
@@ -101,8 +101,7 @@ void CollectiveEvent::update_basic_strides()
              = collective->events->begin();
              ev != collective->events->end(); ++ev)
         {
-            task_next->stride_parents->insert(*ev);
-            (*ev)->stride_children->insert(task_next);
+            (*ev)->addStrideChild(task_next);
         }
     }
 }
@@ -145,8 +144,7 @@ void CollectiveEvent::set_stride_relationships()
              = collective->events->begin();
              ev != collective->events->end(); ++ev)
         {
-            task_next->stride_parents->insert(*ev);
-            (*ev)->stride_children->insert(task_next);
+            (*ev)->addStrideChild(task_next);
         }
     }
 }
@@ -222,7 +220,7 @@ QList<int> CollectiveEvent::neighborTasks()
 }
 
 // We know we have no children, so just do enter/leave as well as the collectives
-void CollectiveEvent::writeToOTF2(OTF2_EvtWriter * writer, QMap<QString, int> * attributeMap)
+void CollectiveEvent::writeToOTF2(OTF2_EvtWriter * writer, OTF2WriterAttributes * attributes)
 {
     writeOTF2Enter(writer);
 
@@ -240,5 +238,5 @@ void CollectiveEvent::writeToOTF2(OTF2_EvtWriter * writer, QMap<QString, int> *
                                     0,
                                     0);
 
-    writeOTF2Leave(writer, attributeMap);
+    writeOTF2Leave(writer, attributes);
 }
@@ -50,7 +50,7 @@ public:
     void initialize_basic_strides(QSet<CollectiveRecord *> *collectives);
     void update_basic_strides();
     bool calculate_local_step();
-    void writeToOTF2(OTF2_EvtWriter * writer, QMap<QString, int> * attributeMap);
+    void writeToOTF2(OTF2_EvtWriter * writer, OTF2WriterAttributes * attributes);
 
     void addComms(QSet<CommBundle *> * bundleset) { bundleset->insert(collective); }
     QList<int> neighborTasks();
@@ -25,7 +25,8 @@
 #include "collectiverecord.h"
 #include "commevent.h"
 #include "collectiveevent.h"
-#include "viswidget.h"
+#include "commdrawinterface.h"
+#include "stridegraph.h"
 
 CollectiveRecord::CollectiveRecord(unsigned long long _matching,
                                    unsigned int _root,
@@ -57,19 +58,21 @@ void CollectiveRecord::draw(QPainter * painter, CommDrawInterface *vis)
 }
 
 // Return stride set to this collective. Will return zero if cannot set.
-int CollectiveRecord::set_basic_strides()
+int CollectiveRecord::set_basic_strides(StrideGraph * graph)
 {
-    int max_stride;
+    int max_stride = 0;
     for (QList<CollectiveEvent *>::Iterator evt = events->begin();
          evt != events->end(); ++evt)
     {
-        for (QSet<CommEvent *>::Iterator parent = (*evt)->stride_parents->begin();
-             parent != (*evt)->stride_parents->end(); ++parent)
+        int index = graph->indexOf(*evt);
+        for (int edge = graph->firstParent(index);
+             edge < graph->lastParent(index); ++edge)
         {
-            if (!((*parent)->stride)) // Equals zero meaning its unset
+            CommEvent * parent = graph->node(graph->parent(edge));
+            if (!(parent->stride)) // Equals zero meaning its unset
                 return 0;
-            else if ((*parent)->stride > max_stride)
-                max_stride = (*parent)->stride;
+            else if (parent->stride > max_stride)
+                max_stride = parent->stride;
         }
     }
 
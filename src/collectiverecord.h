@@ -29,6 +29,7 @@
 #include "commbundle.h"
 
 class CollectiveEvent;
+class StrideGraph;
 
 // Information we get from OTF about collectives
 class CollectiveRecord : public CommBundle
@@ -50,7 +51,7 @@ public:
     CommEvent * getDesignee();
     void draw(QPainter * painter, CommDrawInterface * vis);
 
-    int set_basic_strides();
+    int set_basic_strides(StrideGraph * graph);
 };
 
 #endif // COLLECTIVERECORD_H
@@ -31,7 +31,10 @@ ColorMap::ColorMap(QColor color, float value, bool _categorical)
       maxValue(1),
       maxClamp(1),
       categorical(_categorical),
-      colors(new QVector<ColorValue *>())
+      colors(new QVector<ColorValue *>()),
+      table(QVector<QRgb>()),
+      table_valid(false),
+      table_scale(0)
 {
     colors->push_back(new ColorValue(color, value));
 }
@@ -59,6 +62,9 @@ ColorMap::ColorMap(const ColorMap & copy)
     {
         colors->push_back(new ColorValue((*itr)->color, (*itr)->value));
     }
+    table = copy.table;
+    table_valid = copy.table_valid;
+    table_scale = copy.table_scale;
 }
 
 void ColorMap::setRange(double low, double high)
@@ -66,11 +72,13 @@ void ColorMap::setRange(double low, double high)
     minValue = low;
     maxValue = high;
     maxClamp = high;
+    table_valid = false;
 }
 
 void ColorMap::setClamp(double clamp)
 {
     maxClamp = clamp;
+    table_valid = false;
 }
 
 void ColorMap::addColor(QColor color, float stop)
@@ -85,11 +93,13 @@ void ColorMap::addColor(QColor color, float stop)
         {
             colors->insert(itr, new ColorValue(color, stop));
             added = true;
+            break;
         }
     }
     if (!added) {
         colors->push_back(new ColorValue(color, stop));
     }
+    table_valid = false;
 }
 
 QColor ColorMap::color(double value, double opacity)
@@ -98,6 +108,68 @@ QColor ColorMap::color(double value, double opacity)
     if (categorical)
         return categorical_color(value);
 
+    if (!table_valid)
+        buildTable();
+    QRgb rgb = table.at(tableIndex(value));
+    return QColor(qRed(rgb), qGreen(rgb), qBlue(rgb), opacity*255);
+}
+
+void ColorMap::mapColors(const double * values, int count, QRgb * out,
+                         double opacity)
+{
+    int alpha = opacity*255;
+    if (categorical)
+    {
+        for (int i = 0; i < count; ++i)
+        {
+            QRgb rgb = categorical_color(values[i]).rgb();
+            out[i] = qRgba(qRed(rgb), qGreen(rgb), qBlue(rgb), alpha);
+        }
+        return;
+    }
+
+    if (!table_valid)
+        buildTable();
+    const QRgb * lookup = table.constData();
+    for (int i = 0; i < count; ++i)
+    {
+        QRgb rgb = lookup[tableIndex(values[i])];
+        out[i] = qRgba(qRed(rgb), qGreen(rgb), qBlue(rgb), alpha);
+    }
+}
+
+const QVector<QRgb>& ColorMap::colorTable()
+{
+    if (!table_valid)
+        buildTable();
+    return table;
+}
+
+// Values below the minimum or past the clamp take the end colors
+int ColorMap::tableIndex(double value)
+{
+    double position = (value - minValue) * table_scale + 0.5;
+    if (!(position > 0)) // Also catches NaN
+        return 0;
+    if (position >= table_size - 1)
+        return table_size - 1;
+    return int(position);
+}
+
+void ColorMap::buildTable()
+{
+    table.resize(table_size);
+    for (int i = 0; i < table_size; ++i)
+        table[i] = interpolated_color(minValue + (maxClamp - minValue)
+                                      * i / (table_size - 1.0)).rgb();
+    table_scale = 0;
+    if (maxClamp > minValue)
+        table_scale = (table_size - 1) / (maxClamp - minValue);
+    table_valid = true;
+}
+
+QColor ColorMap::interpolated_color(double value, double opacity)
+{
     // Find the colors at either end of the given value and blend them them
     ColorValue base1 = ColorValue(QColor(0,0,0,opacity*255), 0);
     ColorValue base2 = ColorValue(QColor(0,0,0,opacity*255), 1);
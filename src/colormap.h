@@ -27,6 +27,7 @@
 
 #include <QVector>
 #include <QColor>
+#include <QRgb>
 
 class ColorMap
 {
@@ -36,9 +37,20 @@ public:
     ColorMap(const ColorMap& copy);
     void addColor(QColor color, float stop);
     QColor color(double value, double opacity = 1.0);
+
+    // Packed colors for count values at once, as color() would give them
+    void mapColors(const double * values, int count, QRgb * out,
+                   double opacity = 1.0);
+
+    // Colors sampled evenly from the range minimum to the clamp
+    static const int table_size = 1024;
+    const QVector<QRgb>& colorTable();
     void setRange(double low, double high);
     void setClamp(double clamp);
     double getMax() { return maxValue; }
+    double getMin() { return minValue; }
+    double getClamp() { return maxClamp; }
+    int numColors() { return colors->size(); }
     bool isCategorical() { return categorical; }
 
 private:
@@ -56,6 +68,9 @@ private:
     QColor average(ColorValue * low, ColorValue * high,
                    double norm, double opacity = 1.0);
     QColor categorical_color(double value);
+    QColor interpolated_color(double value, double opacity = 1.0);
+    void buildTable();
+    int tableIndex(double value);
 
     // metric value range
     double minValue;
@@ -66,6 +81,11 @@ private:
 
     bool categorical;
     QVector<ColorValue *> * colors;
+
+    // Lookup table for continuous maps, rebuilt lazily after any change
+    QVector<QRgb> table;
+    bool table_valid;
+    double table_scale; // table entries per unit of value
 };
 
 #endif // COLORMAP_H
@@ -24,6 +24,8 @@
 //////////////////////////////////////////////////////////////////////////////
 #include "commevent.h"
 #include "clusterevent.h"
+#include "rpartition.h"
+#include "otf2writerattributes.h"
 #include <otf2/OTF2_AttributeList.h>
 #include <otf2/OTF2_GeneralDefinitions.h>
 #include <iostream>
@@ -39,8 +41,6 @@ CommEvent::CommEvent(unsigned long long _enter, unsigned long long _exit,
       next_stride(NULL),
       last_recvs(NULL),
       last_step(-1),
-      stride_parents(new QSet<CommEvent *>()),
-      stride_children(new QSet<CommEvent *>()),
       stride(-1),
       step(-1),
       phase(_phase)
@@ -58,10 +58,12 @@ CommEvent::~CommEvent()
 
     if (last_recvs)
         delete last_recvs;
-    if (stride_children)
-        delete stride_children;
-    if (stride_parents)
-        delete stride_parents;
+}
+
+// The stride graph lives with the partition while it is stepped
+void CommEvent::addStrideChild(CommEvent * child)
+{
+    partition->addStrideEdge(this, child);
 }
 
 
@@ -108,7 +110,7 @@ void CommEvent::calculate_differential_metric(QString metric_name,
                        getMetric(base_name, true)- max_agg_parent));
 }
 
-void CommEvent::writeOTF2Leave(OTF2_EvtWriter * writer, QMap<QString, int> * attributeMap)
+void CommEvent::writeOTF2Leave(OTF2_EvtWriter * writer, OTF2WriterAttributes * attributes)
 {
     // For coalesced steps, don't write attributes
     if (step < 0)
@@ -121,41 +123,53 @@ void CommEvent::writeOTF2Leave(OTF2_EvtWriter * writer, QMap<QString, int> * att
         return;
     }
 
-    OTF2_AttributeList * attribute_list = OTF2_AttributeList_New();
+    // The writer's list is reused for every event
+    OTF2_AttributeList * attribute_list = attributes->attribute_list;
+    OTF2_AttributeList_RemoveAllAttributes(attribute_list);
 
     // Phase and Step
     OTF2_AttributeValue phase_value;
     phase_value.uint32 = phase;
     OTF2_AttributeList_AddAttribute(attribute_list,
-                                    attributeMap->value("phase"),
+                                    attributes->phase_id,
                                     OTF2_TYPE_UINT64,
                                     phase_value);
 
     OTF2_AttributeValue step_value;
     step_value.uint32 = step;
     OTF2_AttributeList_AddAttribute(attribute_list,
-                                    attributeMap->value("step"),
+                                    attributes->step_id,
                                     OTF2_TYPE_UINT64,
                                     step_value);
 
-    // Write metrics
-    for (QMap<QString, int>::Iterator attr = attributeMap->begin();
-         attr != attributeMap->end(); ++attr)
+    // Write metrics, both sides are sorted by name so walk them together
+    int index = 0;
+    int num_metrics = attributes->metric_names.size();
+    for (QMap<QString, MetricPair *>::Iterator metric = metrics->begin();
+         metric != metrics->end() && index < num_metrics; ++metric)
     {
-        if (!hasMetric(attr.key()))
+        while (index < num_metrics
+               && attributes->metric_names.at(index) < metric.key())
+        {
+            index++;
+        }
+        if (index == num_metrics
+            || attributes->metric_names.at(index) != metric.key())
+        {
             continue;
+        }
 
         OTF2_AttributeValue attr_value;
-        attr_value.uint64 = getMetric(attr.key());
+        attr_value.uint64 = metric.value()->event;
         OTF2_AttributeList_AddAttribute(attribute_list,
-                                        attributeMap->value(attr.key()),
+                                        attributes->metric_ids.at(index),
                                         OTF2_TYPE_UINT64,
                                         attr_value);
 
         OTF2_AttributeValue agg_value;
-        agg_value.uint64 = getMetric(attr.key(), true);
+        agg_value.uint64 = metric.value()->aggregate;
         OTF2_AttributeList_AddAttribute(attribute_list,
-                                        attributeMap->value(attr.key() + "_agg"),
+                                        attributes->aggregate_ids.at(index),
                                         OTF2_TYPE_UINT64,
                                         agg_value);
     }
@@ -56,7 +56,7 @@ public:
     virtual bool isP2P() { return false; }
     virtual bool isReceive() { return false; }
     virtual bool isCollective() { return false; }
-    virtual void writeOTF2Leave(OTF2_EvtWriter * writer, QMap<QString, int> * attributeMap);
+    virtual void writeOTF2Leave(OTF2_EvtWriter * writer, OTF2WriterAttributes * attributes);
 
     virtual void fixPhases()=0;
     virtual void calculate_differential_metric(QString metric_name,
@@ -67,6 +67,7 @@ public:
     virtual void initialize_basic_strides(QSet<CollectiveRecord *> * collectives)=0;
     virtual void update_basic_strides()=0;
     virtual bool calculate_local_step()=0;
+    void addStrideChild(CommEvent * child);
 
     virtual ClusterEvent * createClusterEvent(QString metric, long long divider)=0;
     virtual void addToClusterEvent(ClusterEvent * ce, QString metric,
@@ -99,8 +100,6 @@ public:
     CommEvent * next_stride;
     QList<CommEvent *> * last_recvs;
     int last_step;
-    QSet<CommEvent *> * stride_parents;
-    QSet<CommEvent *> * stride_children;
     int stride;
 
     int step;
@@ -32,7 +32,8 @@ CommRecord::CommRecord(unsigned int _s, unsigned long long int _st,
                        unsigned long long _request) :
     sender(_s), send_time(_st), receiver(_r), recv_time(_rt),
     size(_size), tag(_tag), group(_group), send_request(_request),
-    send_complete(0), matched(false), message(NULL)
+    send_complete(0), matched(false), truncated(false), stub(false),
+    message(NULL)
 {
 }
 
@@ -49,6 +49,8 @@ public:
     unsigned long long int send_request;
     unsigned long long int send_complete;
     bool matched;
+    bool truncated; // one end lies outside the import time window
+    bool stub; // the other end is a task outside the imported subset
 
     Message * message;
 
@@ -191,22 +191,22 @@ int Event::comm_count(QMap<Event *, int> * memo)
     return count;
 }
 
-void Event::writeToOTF2(OTF2_EvtWriter * writer, QMap<QString, int> * attributeMap)
+void Event::writeToOTF2(OTF2_EvtWriter * writer, OTF2WriterAttributes * attributes)
 {
     writeOTF2Enter(writer);
 
     for (QVector<Event *>::Iterator child = callees->begin();
          child != callees->end(); ++child)
     {
-        (*child)->writeToOTF2(writer, attributeMap);
+        (*child)->writeToOTF2(writer, attributes);
     }
 
-    writeOTF2Leave(writer, attributeMap);
+    writeOTF2Leave(writer, attributes);
 }
 
-void Event::writeOTF2Leave(OTF2_EvtWriter * writer, QMap<QString, int> * attributeMap)
+void Event::writeOTF2Leave(OTF2_EvtWriter * writer, OTF2WriterAttributes * attributes)
 {
-    Q_UNUSED(attributeMap);
+    Q_UNUSED(attributes);
     OTF2_EvtWriter_Leave(writer,
                          NULL,
                          exit,
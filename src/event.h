@@ -32,13 +32,14 @@
 
 
 class Partition;
+class OTF2WriterAttributes;
 
 class Event
 {
 public:
     Event(unsigned long long _enter, unsigned long long _exit, int _function,
           int _task);
-    ~Event();
+    virtual ~Event();
 
     // Based on enter time
     bool operator<(const Event &);
@@ -47,7 +48,7 @@ public:
     bool operator>=(const Event &);
     bool operator==(const Event &);
 
-    Event * findChild(unsigned long long time);
+    virtual Event * findChild(unsigned long long time);
     unsigned long long getVisibleEnd(unsigned long long start);
     Event * least_common_caller(Event * other);
     bool same_subtree(Event * other);
@@ -56,8 +57,9 @@ public:
     virtual bool isCommEvent() { return false; }
     virtual bool isReceive() { return false; }
     virtual bool isCollective() { return false; }
-    virtual void writeToOTF2(OTF2_EvtWriter * writer, QMap<QString, int> * attributeMap);
-    virtual void writeOTF2Leave(OTF2_EvtWriter * writer, QMap<QString, int> * attributeMap);
+    virtual bool isPacked() { return false; }
+    virtual void writeToOTF2(OTF2_EvtWriter * writer, OTF2WriterAttributes * attributes);
+    virtual void writeOTF2Leave(OTF2_EvtWriter * writer, OTF2WriterAttributes * attributes);
     virtual void writeOTF2Enter(OTF2_EvtWriter * writer);
 
     // Call tree info
@@ -63,8 +63,10 @@ bool ExchangeGnome::detectGnome(Partition * part)
         for (QList<CommEvent *>::Iterator evt = (event_list.value())->begin();
              evt != (event_list.value())->end(); ++evt)
         {
+            // Stubs of messages to tasks outside an imported subset carry no
+            // Message, so we can't tell this is an exchange
             QVector<Message *> * msgs = (*evt)->getMessages();
-            if (!msgs)
+            if (!msgs || msgs->isEmpty())
                 return false;
             for (QVector<Message *>::Iterator msg = msgs->begin();
                  msg != msgs->end(); ++msg)
@@ -133,7 +135,10 @@ ExchangeGnome::ExchangeType ExchangeGnome::findType()
         for (QList<CommEvent *>::Iterator evt = (event_list.value())->begin();
              evt != (event_list.value())->end(); ++evt)
         {
-            Message * msg = (*evt)->getMessages()->at(0);
+            QVector<Message *> * msgs = (*evt)->getMessages();
+            if (!msgs || msgs->isEmpty())
+                continue;
+            Message * msg = msgs->at(0);
             if (first) // For the first message, we don't have a sentlast
             {
                 first = false;
@@ -0,0 +1,99 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+//
+// This file is part of Ravel.
+// Written by Kate Isaacs, kisaacs@acm.org, All rights reserved.
+// LLNL-CODE-663885
+//
+// For details, see https://github.com/scalability-llnl/ravel
+// Please also see the LICENSE file for our notice and the LGPL.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (as published by
+// the Free Software Foundation) version 2.1 dated February 1999.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the IMPLIED WARRANTY OF
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the terms and
+// conditions of the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//////////////////////////////////////////////////////////////////////////////
+#include "framebuilder.h"
+#include <QThread>
+#include <QPainter>
+#include <QMutexLocker>
+
+FrameBuilder::FrameBuilder()
+    : QObject(),
+      thread(new QThread()),
+      pending(NULL),
+      generations(0),
+      latest(0)
+{
+    moveToThread(thread);
+    connect(this, SIGNAL(wake()), this, SLOT(build()), Qt::QueuedConnection);
+    thread->start();
+}
+
+FrameBuilder::~FrameBuilder()
+{
+    cancel();
+    thread->quit();
+    thread->wait();
+    delete thread;
+}
+
+int FrameBuilder::request(FrameJob * job)
+{
+    queue_lock.lock();
+    delete pending;
+    pending = job;
+    job->generation = ++generations;
+    latest.store(job->generation);
+    queue_lock.unlock();
+
+    emit(wake());
+    return job->generation;
+}
+
+void FrameBuilder::cancel()
+{
+    queue_lock.lock();
+    delete pending;
+    pending = NULL;
+    latest.store(++generations);
+    queue_lock.unlock();
+
+    // Wait out whatever is drawing, it will see it is stale and stop
+    render_lock.lock();
+    render_lock.unlock();
+}
+
+// Runs on the builder thread. Several wakes may come for one job since
+// requests replace each other, the extras find nothing pending.
+void FrameBuilder::build()
+{
+    QMutexLocker render_guard(&render_lock);
+
+    queue_lock.lock();
+    FrameJob * job = pending;
+    pending = NULL;
+    queue_lock.unlock();
+
+    if (!job)
+        return;
+
+    QImage frame(job->size, QImage::Format_ARGB32_Premultiplied);
+    frame.fill(Qt::transparent);
+    QPainter painter(&frame);
+    bool finished = job->render(&painter, this);
+    painter.end();
+
+    if (finished && !isStale(job->generation))
+        emit(frameReady(frame, job->generation));
+    delete job;
+}
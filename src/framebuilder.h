@@ -0,0 +1,90 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+//
+// This file is part of Ravel.
+// Written by Kate Isaacs, kisaacs@acm.org, All rights reserved.
+// LLNL-CODE-663885
+//
+// For details, see https://github.com/scalability-llnl/ravel
+// Please also see the LICENSE file for our notice and the LGPL.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (as published by
+// the Free Software Foundation) version 2.1 dated February 1999.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the IMPLIED WARRANTY OF
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the terms and
+// conditions of the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//////////////////////////////////////////////////////////////////////////////
+#ifndef FRAMEBUILDER_H
+#define FRAMEBUILDER_H
+
+#include <QObject>
+#include <QImage>
+#include <QSize>
+#include <QMutex>
+#include <QAtomicInt>
+
+class QThread;
+class QPainter;
+class FrameBuilder;
+
+// One off-screen frame to draw. Jobs copy the view state they need when
+// they are made so drawing never reads from the widget.
+class FrameJob
+{
+public:
+    FrameJob(QSize _size) : generation(0), size(_size) {}
+    virtual ~FrameJob() {}
+
+    // Returns false if it stopped early because a newer job came in.
+    // Implementations should check builder->isStale(generation) now and
+    // then while drawing.
+    virtual bool render(QPainter * painter, FrameBuilder * builder) = 0;
+
+    int generation;
+    QSize size;
+};
+
+// Draws frames on its own thread. Only the most recent request matters:
+// a new request replaces any that is waiting and makes the one being
+// drawn give up, so a view that keeps moving only pays for where it ends.
+class FrameBuilder : public QObject
+{
+    Q_OBJECT
+public:
+    FrameBuilder();
+    ~FrameBuilder();
+
+    // Takes ownership of job and returns its generation
+    int request(FrameJob * job);
+
+    // Drop all requests and wait for any frame being drawn to stop.
+    // Call this before anything the jobs read from goes away.
+    void cancel();
+
+    bool isStale(int generation) { return generation != latest.load(); }
+
+signals:
+    void frameReady(QImage frame, int generation);
+    void wake();
+
+private slots:
+    void build();
+
+private:
+    QThread * thread;
+    QMutex queue_lock; // guards pending
+    QMutex render_lock; // held while a frame is drawn
+    FrameJob * pending;
+    int generations;
+    QAtomicInt latest;
+};
+
+#endif // FRAMEBUILDER_H
@@ -26,7 +26,11 @@
 #define GENERAL_UTIL_H
 
 #include <QString>
+#include <QtGlobal>
 #include <iostream>
+#ifdef Q_OS_UNIX
+#include <sys/resource.h>
+#endif
 
 // For qSorting lists of pointers
 template<class T>
@@ -75,4 +79,21 @@ static void gu_printTime(qint64 nanos)
     return;
 }
 
+// Peak resident set size of this process in bytes, 0 where unsupported
+static qint64 gu_peakMemory()
+{
+#ifdef Q_OS_UNIX
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0;
+#ifdef Q_OS_MAC
+    return usage.ru_maxrss;
+#else
+    return (qint64)usage.ru_maxrss * 1024;
+#endif
+#else
+    return 0;
+#endif
+}
+
 #endif // GENERAL_UTIL_H
@@ -58,7 +58,7 @@ Gnome::Gnome()
       saved_messages(QSet<Message *>()),
       drawnPCs(QMap<PartitionCluster *, QRect>()),
       drawnNodes(QMap<PartitionCluster *, QRect>()),
-      drawnEvents(QMap<Event *, QRect>()),
+      drawnEvents(HitGrid<Event *>()),
       hover_event(NULL),
       hover_aggregate(false),
       stepwidth(0)
@@ -575,7 +575,7 @@ void Gnome::drawGnomeQt(QPainter * painter, QRect extents,
     saved_messages.clear();
     drawnPCs.clear();
     drawnNodes.clear();
-    drawnEvents.clear();
+    drawnEvents.reset(extents);
 
     drawGnomeQtCluster(painter, extents, blockwidth);
 }
@@ -807,10 +807,10 @@ void Gnome::drawGnomeQtTopTasks(QPainter * painter, QRect extents,
                 {
                     painter->drawRect(QRectF(xa, y, wa, h));
                 }
-                drawnEvents[*evt] = QRect(xa, y, (x - xa) + w, h);
+                drawnEvents.insert(*evt, QRect(xa, y, (x - xa) + w, h));
             } else {
                 // For selection
-                drawnEvents[*evt] = QRect(x, y, w, h);
+                drawnEvents.insert(*evt, QRect(x, y, w, h));
             }
 
         }
@@ -1395,16 +1395,16 @@ bool Gnome::handleHover(QMouseEvent * event)
     mousex = event->x();
     mousey = event->y();
     if (options->showAggregateSteps && hover_event
-            && drawnEvents[hover_event].contains(mousex, mousey))
+            && drawnEvents.value(hover_event).contains(mousex, mousey))
     {
         // Need to check if we're changing from aggregate to not or vice versa
-        if (!hover_aggregate && mousex <= drawnEvents[hover_event].x()
+        if (!hover_aggregate && mousex <= drawnEvents.value(hover_event).x()
                                           + stepwidth)
         {
             hover_aggregate = true;
             return true;
         }
-        else if (hover_aggregate && mousex >=  drawnEvents[hover_event].x()
+        else if (hover_aggregate && mousex >=  drawnEvents.value(hover_event).x()
                                                + stepwidth)
         {
             hover_aggregate = false;
@@ -1412,24 +1412,17 @@ bool Gnome::handleHover(QMouseEvent * event)
         }
     }
     else if (hover_event == NULL
-             || !drawnEvents[hover_event].contains(mousex, mousey))
+             || !drawnEvents.value(hover_event).contains(mousex, mousey))
     {
         // Finding potential new hover
-        hover_event = NULL;
-        for (QMap<Event *, QRect>::Iterator evt = drawnEvents.begin();
-             evt != drawnEvents.end(); ++evt)
-        {
-            if (evt.value().contains(mousex, mousey))
-            {
-                hover_aggregate = false;
-                if (options->showAggregateSteps && mousex <= evt.value().x()
-                                                             + stepwidth)
-                    hover_aggregate = true;
-                hover_event = evt.key();
-            }
-        }
+        Event * last_hover = hover_event;
+        hover_event = drawnEvents.find(mousex, mousey);
+        hover_aggregate = false;
+        if (hover_event && options->showAggregateSteps
+            && mousex <= drawnEvents.value(hover_event).x() + stepwidth)
+            hover_aggregate = true;
 
-        return true;
+        return hover_event != last_hover;
     }
     return false;
 }
@@ -31,6 +31,7 @@
 #include "visoptions.h"
 #include "partitioncluster.h"
 #include "clustertask.h"
+#include "hitgrid.h"
 #include <QPainter>
 #include <QRect>
 
@@ -166,7 +167,7 @@ protected:
     QSet<Message *> saved_messages;
     QMap<PartitionCluster *, QRect> drawnPCs;
     QMap<PartitionCluster *, QRect> drawnNodes;
-    QMap<Event *, QRect> drawnEvents;
+    HitGrid<Event *> drawnEvents;
     PartitionCluster * selected_pc;
     bool is_selected;
     Event * hover_event;
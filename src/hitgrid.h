@@ -0,0 +1,135 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+//
+// This file is part of Ravel.
+// Written by Kate Isaacs, kisaacs@acm.org, All rights reserved.
+// LLNL-CODE-663885
+//
+// For details, see https://github.com/scalability-llnl/ravel
+// Please also see the LICENSE file for our notice and the LGPL.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (as published by
+// the Free Software Foundation) version 2.1 dated February 1999.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the IMPLIED WARRANTY OF
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the terms and
+// conditions of the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//////////////////////////////////////////////////////////////////////////////
+#ifndef HITGRID_H
+#define HITGRID_H
+
+#include <QVector>
+#include <QHash>
+#include <QRect>
+#include <algorithm>
+
+// Drawn items and their rects, bucketed by pixel cell so that hover and
+// click lookups only look at the few items under the mouse rather than
+// everything drawn. Refilled on each paint.
+template<class T>
+class HitGrid
+{
+public:
+    HitGrid(int _cell = 8)
+        : cell(_cell), columns(0), rows(0), origin(QPoint()),
+          items(QVector<T>()), rects(QVector<QRect>()),
+          index(QHash<T, int>()), cells(QVector<QVector<int> >())
+    {
+    }
+
+    // Empty the grid and size it to cover area
+    void reset(const QRect& area)
+    {
+        items.clear();
+        rects.clear();
+        index.clear();
+        origin = area.topLeft();
+        int new_columns = area.width() / cell + 1;
+        int new_rows = area.height() / cell + 1;
+        if (new_columns != columns || new_rows != rows)
+        {
+            columns = new_columns;
+            rows = new_rows;
+            cells = QVector<QVector<int> >(columns * rows);
+        }
+        else
+        {
+            for (int i = 0; i < cells.size(); i++)
+                cells[i].clear();
+        }
+    }
+
+    void clear() { reset(QRect()); }
+
+    // Later inserts of the same item move it to the new rect
+    void insert(T item, const QRect& rect)
+    {
+        int i = index.value(item, -1);
+        if (i < 0)
+        {
+            i = items.size();
+            items.append(item);
+            rects.append(rect);
+            index.insert(item, i);
+        }
+        else
+        {
+            rects[i] = rect;
+        }
+
+        int left = std::max(0, (rect.left() - origin.x()) / cell);
+        int right = std::min(columns - 1, (rect.right() - origin.x()) / cell);
+        int top = std::max(0, (rect.top() - origin.y()) / cell);
+        int bottom = std::min(rows - 1, (rect.bottom() - origin.y()) / cell);
+        for (int y = top; y <= bottom; y++)
+            for (int x = left; x <= right; x++)
+                cells[y * columns + x].append(i);
+    }
+
+    // The last inserted item containing (x, y), so whatever was drawn on top
+    T find(int x, int y) const
+    {
+        int cx = (x - origin.x()) / cell;
+        int cy = (y - origin.y()) / cell;
+        if (x < origin.x() || y < origin.y() || cx >= columns || cy >= rows)
+            return T();
+
+        const QVector<int>& bucket = cells.at(cy * columns + cx);
+        for (int i = bucket.size() - 1; i >= 0; i--)
+            if (rects.at(bucket.at(i)).contains(x, y))
+                return items.at(bucket.at(i));
+        return T();
+    }
+
+    bool contains(T item) const { return index.contains(item); }
+    QRect value(T item) const
+    {
+        int i = index.value(item, -1);
+        return i < 0 ? QRect() : rects.at(i);
+    }
+
+    // For walking everything drawn
+    int size() const { return items.size(); }
+    T itemAt(int i) const { return items.at(i); }
+    QRect rectAt(int i) const { return rects.at(i); }
+
+private:
+    int cell; // pixels per side of a cell
+    int columns;
+    int rows;
+    QPoint origin;
+
+    QVector<T> items;
+    QVector<QRect> rects;
+    QHash<T, int> index;
+    QVector<QVector<int> > cells; // row-major, indices into items
+};
+
+#endif // HITGRID_H
@@ -0,0 +1,113 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+//
+// This file is part of Ravel.
+// Written by Kate Isaacs, kisaacs@acm.org, All rights reserved.
+// LLNL-CODE-663885
+//
+// For details, see https://github.com/scalability-llnl/ravel
+// Please also see the LICENSE file for our notice and the LGPL.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (as published by
+// the Free Software Foundation) version 2.1 dated February 1999.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the IMPLIED WARRANTY OF
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the terms and
+// conditions of the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//////////////////////////////////////////////////////////////////////////////
+#include "hotspotindex.h"
+#include <QtConcurrent/QtConcurrentMap>
+#include <queue>
+#include <vector>
+#include <functional>
+
+#include "commevent.h"
+#include "stepindex.h"
+
+HotspotIndex::HotspotIndex()
+    : event_tops(QMap<QString, QVector<int> >()),
+      aggregate_tops(QMap<QString, QVector<int> >())
+{
+}
+
+void HotspotIndex::build(StepIndex * index, QList<QString> * metrics,
+                         int size)
+{
+    event_tops.clear();
+    aggregate_tops.clear();
+
+    QVector<HotspotJob> jobs = QVector<HotspotJob>();
+    for (QList<QString>::Iterator metric = metrics->begin();
+         metric != metrics->end(); ++metric)
+    {
+        HotspotJob job;
+        job.index = index;
+        job.metric = *metric;
+        job.size = size;
+        jobs.append(job);
+        job.aggregate = true;
+        jobs.append(job);
+    }
+
+    QtConcurrent::blockingMap(jobs, HotspotIndex::findTop);
+
+    for (QVector<HotspotJob>::Iterator job = jobs.begin();
+         job != jobs.end(); ++job)
+    {
+        if (job->aggregate)
+            aggregate_tops.insert(job->metric, job->found);
+        else
+            event_tops.insert(job->metric, job->found);
+    }
+}
+
+QVector<int> HotspotIndex::top(QString metric, bool aggregate)
+{
+    if (aggregate)
+        return aggregate_tops.value(metric);
+    return event_tops.value(metric);
+}
+
+// Keeps the largest values seen in a min-heap of at most size entries, so
+// the smallest kept is the one to drop when a larger one comes along
+void HotspotIndex::findTop(HotspotJob& job)
+{
+    typedef std::pair<double, int> Ranked;
+    std::priority_queue<Ranked, std::vector<Ranked>,
+                        std::greater<Ranked> > heap;
+
+    for (int i = 0; i < job.index->size(); ++i)
+    {
+        CommEvent * evt = job.index->at(i);
+        CommEvent::MetricPair * mp = evt->metrics->value(job.metric);
+        if (!mp)
+            continue;
+
+        // Steps with no aggregate before them have nothing to rank
+        if (job.aggregate && evt->step <= 0)
+            continue;
+
+        double value = job.aggregate ? mp->aggregate : mp->event;
+        if (int(heap.size()) < job.size)
+            heap.push(Ranked(value, i));
+        else if (value > heap.top().first)
+        {
+            heap.pop();
+            heap.push(Ranked(value, i));
+        }
+    }
+
+    job.found = QVector<int>(heap.size());
+    for (int i = job.found.size() - 1; i >= 0; --i)
+    {
+        job.found[i] = heap.top().second;
+        heap.pop();
+    }
+}
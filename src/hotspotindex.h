@@ -0,0 +1,73 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+//
+// This file is part of Ravel.
+// Written by Kate Isaacs, kisaacs@acm.org, All rights reserved.
+// LLNL-CODE-663885
+//
+// For details, see https://github.com/scalability-llnl/ravel
+// Please also see the LICENSE file for our notice and the LGPL.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (as published by
+// the Free Software Foundation) version 2.1 dated February 1999.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the IMPLIED WARRANTY OF
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the terms and
+// conditions of the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//////////////////////////////////////////////////////////////////////////////
+#ifndef HOTSPOTINDEX_H
+#define HOTSPOTINDEX_H
+
+#include <QList>
+#include <QMap>
+#include <QString>
+#include <QVector>
+
+class StepIndex;
+
+// The events with the largest values of each metric, by event value and by
+// aggregate value, so the worst spots can be listed without a search.
+// Events are kept as their positions in the step index, largest first.
+class HotspotIndex
+{
+public:
+    HotspotIndex();
+
+    // Metrics are searched in parallel, one job per metric and kind
+    void build(StepIndex * index, QList<QString> * metrics,
+               int size = defaultSize);
+
+    // Empty if the metric was not indexed
+    QVector<int> top(QString metric, bool aggregate = false);
+
+    static const int defaultSize = 100;
+
+private:
+    // One metric and kind to rank
+    class HotspotJob {
+    public:
+        HotspotJob()
+            : index(NULL), metric(""), aggregate(false), size(0),
+              found(QVector<int>()) {}
+
+        StepIndex * index;
+        QString metric;
+        bool aggregate;
+        int size;
+        QVector<int> found;
+    };
+
+    static void findTop(HotspotJob& job);
+
+    QMap<QString, QVector<int> > event_tops;
+    QMap<QString, QVector<int> > aggregate_tops;
+};
+
+#endif // HOTSPOTINDEX_H
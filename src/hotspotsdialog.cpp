@@ -0,0 +1,117 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+//
+// This file is part of Ravel.
+// Written by Kate Isaacs, kisaacs@acm.org, All rights reserved.
+// LLNL-CODE-663885
+//
+// For details, see https://github.com/scalability-llnl/ravel
+// Please also see the LICENSE file for our notice and the LGPL.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (as published by
+// the Free Software Foundation) version 2.1 dated February 1999.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the IMPLIED WARRANTY OF
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the terms and
+// conditions of the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//////////////////////////////////////////////////////////////////////////////
+#include "hotspotsdialog.h"
+#include "ui_hotspotsdialog.h"
+#include "trace.h"
+#include "function.h"
+#include "commevent.h"
+#include "stepindex.h"
+#include "hotspotindex.h"
+#include <QTreeWidgetItem>
+
+HotspotsDialog::HotspotsDialog(QWidget *parent, Trace * _trace,
+                               QString _metric)
+    : QDialog(parent),
+    ui(new Ui::HotspotsDialog),
+    trace(_trace),
+    metric(_metric),
+    aggregate(false)
+{
+    ui->setupUi(this);
+
+    if (trace)
+    {
+        for (QList<QString>::Iterator itr = trace->metrics->begin();
+             itr != trace->metrics->end(); ++itr)
+        {
+            ui->metricComboBox->addItem(*itr);
+        }
+        int index = ui->metricComboBox->findText(metric);
+        if (index < 0)
+            index = 0;
+        ui->metricComboBox->setCurrentIndex(index);
+        metric = ui->metricComboBox->currentText();
+        setWindowTitle("Hotspots - " + trace->name);
+    }
+
+    connect(ui->metricComboBox, SIGNAL(currentIndexChanged(QString)), this,
+            SLOT(onMetric(QString)));
+    connect(ui->aggregateCheckBox, SIGNAL(clicked(bool)), this,
+            SLOT(onAggregate(bool)));
+    connect(ui->hotspotTree, SIGNAL(itemActivated(QTreeWidgetItem*,int)),
+            this, SLOT(onActivated(QTreeWidgetItem*)));
+
+    setUIState();
+}
+
+HotspotsDialog::~HotspotsDialog()
+{
+    delete ui;
+}
+
+void HotspotsDialog::onMetric(QString _metric)
+{
+    metric = _metric;
+    setUIState();
+}
+
+void HotspotsDialog::onAggregate(bool _aggregate)
+{
+    aggregate = _aggregate;
+    setUIState();
+}
+
+void HotspotsDialog::onActivated(QTreeWidgetItem * item)
+{
+    int position = item->data(0, Qt::UserRole).toInt();
+    if (trace && position >= 0 && position < trace->step_index->size())
+        emit(hotspotChosen(trace->step_index->at(position), aggregate));
+}
+
+void HotspotsDialog::setUIState()
+{
+    ui->hotspotTree->clear();
+    if (!trace)
+        return;
+
+    QVector<int> top = trace->hotspots->top(metric, aggregate);
+    for (int i = 0; i < top.size(); ++i)
+    {
+        CommEvent * evt = trace->step_index->at(top.at(i));
+        QStringList columns;
+        columns << QString::number(i + 1)
+                << QString::number(evt->getMetric(metric, aggregate), 'g', 6)
+                << QString::number(evt->task)
+                << QString::number(aggregate ? evt->step - 1 : evt->step)
+                << trace->functions->value(evt->function)->name;
+        QTreeWidgetItem * item = new QTreeWidgetItem(ui->hotspotTree,
+                                                     columns);
+        item->setData(0, Qt::UserRole, top.at(i));
+        for (int j = 0; j < 4; ++j)
+            item->setTextAlignment(j, Qt::AlignRight);
+    }
+    for (int i = 0; i < ui->hotspotTree->columnCount(); i++)
+        ui->hotspotTree->resizeColumnToContents(i);
+}
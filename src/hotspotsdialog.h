@@ -0,0 +1,67 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+//
+// This file is part of Ravel.
+// Written by Kate Isaacs, kisaacs@acm.org, All rights reserved.
+// LLNL-CODE-663885
+//
+// For details, see https://github.com/scalability-llnl/ravel
+// Please also see the LICENSE file for our notice and the LGPL.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (as published by
+// the Free Software Foundation) version 2.1 dated February 1999.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the IMPLIED WARRANTY OF
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the terms and
+// conditions of the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//////////////////////////////////////////////////////////////////////////////
+#ifndef HOTSPOTSDIALOG_H
+#define HOTSPOTSDIALOG_H
+
+#include <QDialog>
+#include <QString>
+
+class Trace;
+class CommEvent;
+class QTreeWidgetItem;
+
+// Ranked list of the events with the largest metric values. Choosing one
+// asks the views to jump to it.
+namespace Ui {
+class HotspotsDialog;
+}
+
+class HotspotsDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit HotspotsDialog(QWidget *parent = 0, Trace * _trace = NULL,
+                            QString _metric = "");
+    ~HotspotsDialog();
+
+signals:
+    void hotspotChosen(CommEvent * event, bool aggregate);
+
+public slots:
+    void onMetric(QString metric);
+    void onAggregate(bool aggregate);
+    void onActivated(QTreeWidgetItem * item);
+
+private:
+    Ui::HotspotsDialog *ui;
+    Trace * trace;
+    QString metric;
+    bool aggregate;
+
+    void setUIState();
+};
+
+#endif // HOTSPOTSDIALOG_H
@@ -56,12 +56,36 @@ ImportOptionsDialog::ImportOptionsDialog(QWidget *parent,
             SLOT(onCluster(bool)));
     connect(ui->isendCheckbox, SIGNAL(clicked(bool)), this,
             SLOT(onIsend(bool)));
+    connect(ui->compactCheckbox, SIGNAL(clicked(bool)), this,
+            SLOT(onCompact(bool)));
+    connect(ui->pageCheckbox, SIGNAL(clicked(bool)), this,
+            SLOT(onPage(bool)));
+    connect(ui->pageBudgetSpin, SIGNAL(valueChanged(int)), this,
+            SLOT(onPageBudget(int)));
+    connect(ui->keepCheckbox, SIGNAL(clicked(bool)), this,
+            SLOT(onKeepRecords(bool)));
+    connect(ui->snapshotCheckbox, SIGNAL(clicked(bool)), this,
+            SLOT(onSnapshots(bool)));
+    connect(ui->snapshotLimitSpin, SIGNAL(valueChanged(int)), this,
+            SLOT(onSnapshotLimit(int)));
     connect(ui->messageSizeCheckbox, SIGNAL(clicked(bool)), this,
             SLOT(onMessageSize(bool)));
     connect(ui->stepCheckbox, SIGNAL(clicked(bool)), this,
             SLOT(onAdvancedStep(bool)));
     connect(ui->seedEdit, SIGNAL(textChanged(QString)), this,
             SLOT(onSeedEdit(QString)));
+    connect(ui->windowCheckbox, SIGNAL(clicked(bool)), this,
+            SLOT(onTimeWindow(bool)));
+    connect(ui->windowStartEdit, SIGNAL(textChanged(QString)), this,
+            SLOT(onWindowStartEdit(QString)));
+    connect(ui->windowEndEdit, SIGNAL(textChanged(QString)), this,
+            SLOT(onWindowEndEdit(QString)));
+    connect(ui->subsetCheckbox, SIGNAL(clicked(bool)), this,
+            SLOT(onTaskSubset(bool)));
+    connect(ui->subsetFilterEdit, SIGNAL(textChanged(QString)), this,
+            SLOT(onTaskFilterEdit(QString)));
+    connect(ui->subsetHopsSpin, SIGNAL(valueChanged(int)), this,
+            SLOT(onTaskHops(int)));
 
     setUIState();
 }
@@ -131,6 +155,42 @@ void ImportOptionsDialog::onIsend(bool coalesce)
     options->isendCoalescing = coalesce;
 }
 
+void ImportOptionsDialog::onCompact(bool compact)
+{
+    options->compactCallTrees = compact;
+    setUIState();
+}
+
+// Paging packs the calls first
+void ImportOptionsDialog::onPage(bool page)
+{
+    options->pageCallTrees = page;
+    if (page)
+        options->compactCallTrees = true;
+    setUIState();
+}
+
+void ImportOptionsDialog::onPageBudget(int budget)
+{
+    options->callTreeBudget = budget;
+}
+
+void ImportOptionsDialog::onKeepRecords(bool keep)
+{
+    options->keepRecords = keep;
+}
+
+void ImportOptionsDialog::onSnapshots(bool save)
+{
+    options->saveSnapshots = save;
+    setUIState();
+}
+
+void ImportOptionsDialog::onSnapshotLimit(int limit)
+{
+    options->snapshotCacheLimit = limit;
+}
+
 void ImportOptionsDialog::onMessageSize(bool enforce)
 {
     options->enforceMessageSizes = enforce;
@@ -160,6 +220,39 @@ void ImportOptionsDialog::onSeedEdit(const QString& text)
     }
 }
 
+void ImportOptionsDialog::onTimeWindow(bool window)
+{
+    options->timeWindow = window;
+    setUIState();
+}
+
+void ImportOptionsDialog::onWindowStartEdit(const QString& text)
+{
+    options->windowStart = text.toDouble();
+}
+
+// An empty end reads to the end of the trace
+void ImportOptionsDialog::onWindowEndEdit(const QString& text)
+{
+    options->windowEnd = text.toDouble();
+}
+
+void ImportOptionsDialog::onTaskSubset(bool subset)
+{
+    options->taskSubset = subset;
+    setUIState();
+}
+
+void ImportOptionsDialog::onTaskFilterEdit(const QString& text)
+{
+    options->taskFilter = text;
+}
+
+void ImportOptionsDialog::onTaskHops(int hops)
+{
+    options->taskHops = hops;
+}
+
 // Based on currently operational options, set the UI state to
 // something consistent (e.g., in certain modes other options are
 // unavailable)
@@ -172,6 +265,18 @@ void ImportOptionsDialog::setUIState()
     ui->globalMergeBox->setChecked(options->globalMerge);
     ui->clusterCheckbox->setChecked(options->cluster);
     ui->isendCheckbox->setChecked(options->isendCoalescing);
+    ui->compactCheckbox->setChecked(options->compactCallTrees);
+    ui->compactCheckbox->setEnabled(!options->pageCallTrees);
+    ui->pageCheckbox->setChecked(options->pageCallTrees);
+    ui->pageBudgetSpin->setValue(options->callTreeBudget);
+    ui->pageBudgetSpin->setEnabled(options->pageCallTrees);
+    // Packed traces never keep their records
+    ui->keepCheckbox->setChecked(options->keepRecords);
+    ui->keepCheckbox->setEnabled(!options->compactCallTrees
+                                 && !options->pageCallTrees);
+    ui->snapshotCheckbox->setChecked(options->saveSnapshots);
+    ui->snapshotLimitSpin->setValue(options->snapshotCacheLimit);
+    ui->snapshotLimitSpin->setEnabled(options->saveSnapshots);
     ui->messageSizeCheckbox->setChecked(options->enforceMessageSizes);
     ui->stepCheckbox->setChecked(options->advancedStepping);
 
@@ -197,6 +302,21 @@ void ImportOptionsDialog::setUIState()
     }
     ui->seedEdit->setEnabled(options->cluster);
 
+    ui->windowCheckbox->setChecked(options->timeWindow);
+    ui->windowStartEdit->setText(QString::number(options->windowStart));
+    if (options->windowEnd > options->windowStart)
+        ui->windowEndEdit->setText(QString::number(options->windowEnd));
+    else
+        ui->windowEndEdit->setText("");
+    ui->windowStartEdit->setEnabled(options->timeWindow);
+    ui->windowEndEdit->setEnabled(options->timeWindow);
+
+    ui->subsetCheckbox->setChecked(options->taskSubset);
+    ui->subsetFilterEdit->setText(options->taskFilter);
+    ui->subsetHopsSpin->setValue(options->taskHops);
+    ui->subsetFilterEdit->setEnabled(options->taskSubset);
+    ui->subsetHopsSpin->setEnabled(options->taskSubset);
+
     // Enable or Disable heuristic v. given partition
     if (options->partitionByFunction)
     {
@@ -53,11 +53,23 @@ public slots:
     void onLeapSkip(bool skip);
     void onGlobalMerge(bool merge);
     void onIsend(bool coalesce);
+    void onCompact(bool compact);
+    void onPage(bool page);
+    void onPageBudget(int budget);
+    void onKeepRecords(bool keep);
+    void onSnapshots(bool save);
+    void onSnapshotLimit(int limit);
     void onMessageSize(bool enforce);
     void onAdvancedStep(bool advanced);
     void onFunctionEdit(const QString& text);
     void onCluster(bool cluster);
     void onSeedEdit(const QString& text);
+    void onTimeWindow(bool window);
+    void onWindowStartEdit(const QString& text);
+    void onWindowEndEdit(const QString& text);
+    void onTaskSubset(bool subset);
+    void onTaskFilterEdit(const QString& text);
+    void onTaskHops(int hops);
 
 
 private:
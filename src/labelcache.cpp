@@ -0,0 +1,114 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+//
+// This file is part of Ravel.
+// Written by Kate Isaacs, kisaacs@acm.org, All rights reserved.
+// LLNL-CODE-663885
+//
+// For details, see https://github.com/scalability-llnl/ravel
+// Please also see the LICENSE file for our notice and the LGPL.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (as published by
+// the Free Software Foundation) version 2.1 dated February 1999.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the IMPLIED WARRANTY OF
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the terms and
+// conditions of the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//////////////////////////////////////////////////////////////////////////////
+#include "labelcache.h"
+#include "trace.h"
+#include "function.h"
+
+LabelCache::LabelCache()
+    : trace(NULL),
+      font(QFont()),
+      metrics(QFontMetrics(font)),
+      text_height(metrics.height()),
+      names(QVector<QString>()),
+      widths(QVector<int>()),
+      elided(QVector<QVector<QString> >())
+{
+}
+
+void LabelCache::setTrace(Trace * _trace)
+{
+    if (trace == _trace)
+        return;
+    trace = _trace;
+    clear();
+}
+
+void LabelCache::setFont(const QFont& _font)
+{
+    if (font == _font)
+        return;
+    font = _font;
+    metrics = QFontMetrics(font);
+    text_height = metrics.height();
+    clear();
+}
+
+void LabelCache::clear()
+{
+    names.clear();
+    widths.clear();
+    elided.clear();
+}
+
+QString LabelCache::label(int function, double width)
+{
+    if (function < 0)
+        return QString();
+    if (function >= widths.size() || widths.at(function) < 0)
+        layout(function);
+
+    if (widths.at(function) < width)
+        return names.at(function);
+
+    // Largest elided variant that still fits
+    int step = int(width - 1) / elideStep;
+    if (step < 1)
+        return QString();
+    QVector<QString>& variants = elided[function];
+    if (step >= variants.size())
+        variants.resize(step + 1);
+    if (variants.at(step).isNull())
+    {
+        QString text = metrics.elidedText(names.at(function), Qt::ElideRight,
+                                          step * elideStep);
+        // An ellipsis by itself says nothing
+        if (text.length() <= 1)
+            text = QString("");
+        variants[step] = text;
+    }
+    return variants.at(step);
+}
+
+void LabelCache::layout(int function)
+{
+    if (function >= widths.size())
+    {
+        int old_size = widths.size();
+        names.resize(function + 1);
+        widths.resize(function + 1);
+        elided.resize(function + 1);
+        for (int i = old_size; i < widths.size(); ++i)
+            widths[i] = -1;
+    }
+
+    Function * fxn = NULL;
+    if (trace)
+        fxn = trace->functions->value(function);
+    if (fxn)
+        names[function] = fxn->name;
+    else
+        names[function] = QString("");
+    widths[function] = metrics.width(names.at(function));
+}
@@ -0,0 +1,69 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+//
+// This file is part of Ravel.
+// Written by Kate Isaacs, kisaacs@acm.org, All rights reserved.
+// LLNL-CODE-663885
+//
+// For details, see https://github.com/scalability-llnl/ravel
+// Please also see the LICENSE file for our notice and the LGPL.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (as published by
+// the Free Software Foundation) version 2.1 dated February 1999.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the IMPLIED WARRANTY OF
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the terms and
+// conditions of the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//////////////////////////////////////////////////////////////////////////////
+#ifndef LABELCACHE_H
+#define LABELCACHE_H
+
+#include <QFont>
+#include <QFontMetrics>
+#include <QString>
+#include <QVector>
+
+class Trace;
+
+// Function name labels laid out once per font. Widths are kept in an array
+// by function id so deciding whether a name fits is a lookup, and names
+// too wide for their box are elided to a few fixed widths the first time
+// they are needed. A cache is not thread safe; each thread drawing labels
+// should have its own.
+class LabelCache
+{
+public:
+    LabelCache();
+
+    // Drops everything laid out for the previous trace or font
+    void setTrace(Trace * _trace);
+    void setFont(const QFont& _font);
+    void clear();
+
+    // The name of the function, elided if needed, that fits in width
+    // pixels, or an empty string if nothing useful fits
+    QString label(int function, double width);
+    int height() { return text_height; }
+
+private:
+    void layout(int function);
+
+    Trace * trace;
+    QFont font;
+    QFontMetrics metrics;
+    int text_height;
+    QVector<QString> names;
+    QVector<int> widths; // -1 until laid out
+    QVector<QVector<QString> > elided; // by function, then width step
+
+    static const int elideStep = 16; // pixels between elided variants
+};
+
+#endif // LABELCACHE_H
@@ -38,6 +38,9 @@
 #include "otfimportoptions.h"
 #include "visoptions.h"
 #include "visoptionsdialog.h"
+#include "profiledialog.h"
+#include "hotspotsdialog.h"
+#include "commevent.h"
 #include "otfimportfunctor.h"
 #include "otf2exportfunctor.h"
 
@@ -47,6 +50,7 @@
 #include "qtconcurrentrun.h"
 #include <iostream>
 #include <string>
+#include <algorithm>
 #include <QElapsedTimer>
 #include <QThread>
 #include <QProgressDialog>
@@ -66,6 +70,9 @@ MainWindow::MainWindow(QWidget *parent) :
     otfdialog(NULL),
     visoptions(new VisOptions()),
     visdialog(NULL),
+    profiledialog(NULL),
+    hotspotsdialog(NULL),
+    stepspan(15),
     activetracename(""),
     activetraces(QStack<QString>())
 {
@@ -139,13 +146,13 @@ MainWindow::MainWindow(QWidget *parent) :
             SLOT(selectTasks(QList<int>, Gnome*)));
 
     connect((clustervis), SIGNAL(focusGnome()), clustertreevis,
-            SLOT(repaint()));
+            SLOT(update()));
     connect((clustervis), SIGNAL(clusterChange()), clustertreevis,
             SLOT(clusterChanged()));
     connect((clustertreevis), SIGNAL(clusterChange()), clustervis,
             SLOT(clusterChanged()));
     connect((clustervis), SIGNAL(neighborChange(int)), clustertreevis,
-            SLOT(repaint()));
+            SLOT(update()));
 
     viswidgets.push_back(clustervis);
     viswidgets.push_back(clustertreevis);
@@ -178,6 +185,10 @@ MainWindow::MainWindow(QWidget *parent) :
     connect(ui->actionVisualization, SIGNAL(triggered()), this,
             SLOT(launchVisOptions()));
     ui->actionVisualization->setShortcut(QKeySequence(Qt::CTRL + Qt::Key_V));
+    connect(ui->actionReprocess, SIGNAL(triggered()), this,
+            SLOT(reprocessTrace()));
+    ui->actionReprocess->setShortcut(QKeySequence(Qt::CTRL + Qt::Key_R));
+    ui->actionReprocess->setEnabled(false);
 
 
     connect(ui->actionLogical_Steps, SIGNAL(triggered()), this,
@@ -197,6 +208,15 @@ MainWindow::MainWindow(QWidget *parent) :
     visactions.append(ui->actionPhysical_Time);
     visactions.append(ui->actionMetric_Overview);
 
+    connect(ui->actionProcessing_Profile, SIGNAL(triggered()), this,
+            SLOT(launchProcessingProfile()));
+    ui->actionProcessing_Profile->setEnabled(false);
+
+    connect(ui->actionHotspots, SIGNAL(triggered()), this,
+            SLOT(launchHotspots()));
+    ui->actionHotspots->setShortcut(QKeySequence(Qt::ALT + Qt::Key_H));
+    ui->actionHotspots->setEnabled(false);
+
     connect(ui->actionQuit, SIGNAL(triggered()), this, SLOT(close()));
     ui->actionQuit->setShortcut(QKeySequence(Qt::CTRL + Qt::Key_Q));
 
@@ -226,6 +246,8 @@ MainWindow::MainWindow(QWidget *parent) :
 MainWindow::~MainWindow()
 {
     delete otfdialog;
+    delete profiledialog;
+    delete hotspotsdialog;
     delete ui;
 }
 
@@ -233,6 +255,7 @@ MainWindow::~MainWindow()
 // constructor) to all of the rest
 void MainWindow::pushSteps(float start, float stop, bool jump)
 {
+    stepspan = stop - start;
     for(int i = 0; i < viswidgets.size(); i++)
     {
         viswidgets[i]->setSteps(start, stop, jump);
@@ -255,6 +278,17 @@ void MainWindow::selectTasks(QList<int> tasks, Gnome * gnome)
     }
 }
 
+// Centers the views on the chosen event at the current zoom and selects it
+void MainWindow::showHotspot(CommEvent * event, bool aggregate)
+{
+    float center = event->step;
+    if (aggregate)
+        center -= 1;
+    float start = std::max(center - stepspan / 2, 0.0f);
+    pushSteps(start, start + stepspan, true);
+    selectEvent(event, aggregate, false);
+}
+
 void MainWindow::launchOTFOptions()
 {
     delete otfdialog;
@@ -273,7 +307,25 @@ void MainWindow::launchVisOptions()
     visdialog->show();
 
     for(int i = 0; i < viswidgets.size(); i++)
-        viswidgets[i]->repaint();
+        viswidgets[i]->update();
+}
+
+void MainWindow::launchHotspots()
+{
+    delete hotspotsdialog;
+    hotspotsdialog = new HotspotsDialog(this, traces[activeTrace],
+                                        visoptions->metric);
+    connect(hotspotsdialog, SIGNAL(hotspotChosen(CommEvent *, bool)), this,
+            SLOT(showHotspot(CommEvent *, bool)));
+    hotspotsdialog->show();
+}
+
+void MainWindow::launchProcessingProfile()
+{
+    delete profiledialog;
+    profiledialog = new ProfileDialog(this, traces[activeTrace]->profile,
+                                      traces[activeTrace]->name);
+    profiledialog->show();
 }
 
 void MainWindow::saveCurrentTrace()
@@ -392,6 +444,110 @@ void MainWindow::importTrace(QString dataFileName){
     emit(operate(dataFileName));
 }
 
+// Rebuild the active trace with the current import options. Clustering
+// options are applied to the open trace, the other structure options
+// reuse the kept records and the rest need a new read.
+void MainWindow::reprocessTrace()
+{
+    if (activeTrace < 0)
+        return;
+
+    Trace * trace = traces[activeTrace];
+    otfoptions->origin = trace->options.origin;
+    if (otfoptions->origin == OTFImportOptions::OF_OTF2)
+        otfoptions->waitallMerge = false; // Not applicable
+
+    OTFImportOptions::ReprocessStage stage
+            = otfoptions->reprocessStage(trace->options);
+    if (stage == OTFImportOptions::RS_NONE)
+    {
+        QMessageBox msgBox;
+        msgBox.setText("The import options have not changed for this trace.");
+        msgBox.exec();
+        return;
+    }
+
+    if (stage == OTFImportOptions::RS_CLUSTER)
+    {
+        reclusterTrace(trace);
+        return;
+    }
+
+    activetracename = trace->name + " (reprocessed)";
+    if (stage == OTFImportOptions::RS_READ || !trace->rawtrace)
+    {
+        importTrace(trace->fullpath);
+        return;
+    }
+
+    progress = new QProgressDialog("Matching events...", "", 0, 0, this);
+    progress->setWindowTitle("Reprocessing Trace...");
+    progress->setCancelButton(0);
+    progress->show();
+
+    importThread = new QThread();
+    importWorker = new OTFImportFunctor(otfoptions);
+    importWorker->moveToThread(importThread);
+
+    // The new trace takes over the kept records
+    importWorker->setBase(trace->rawtrace);
+    trace->rawtrace = NULL;
+
+    connect(this, SIGNAL(operate(QString)), importWorker,
+            SLOT(doReprocess(QString)));
+    connect(importWorker, SIGNAL(switching()), this, SLOT(traceSwitch()));
+    connect(importWorker, SIGNAL(done(Trace *)), this,
+            SLOT(traceFinished(Trace *)));
+    connect(importWorker, SIGNAL(reportProgress(int, QString)), this,
+            SLOT(updateProgress(int, QString)));
+
+    importThread->start();
+    emit(operate(trace->fullpath));
+}
+
+// Cluster the open trace again in the background. The views let go of it
+// meanwhile since its gnomes are replaced.
+void MainWindow::reclusterTrace(Trace * trace)
+{
+    delete hotspotsdialog;
+    hotspotsdialog = NULL;
+    delete profiledialog;
+    profiledialog = NULL;
+    for (int i = 0; i < viswidgets.size(); i++)
+        viswidgets[i]->releaseTrace();
+
+    progress = new QProgressDialog("Clustering...", "", 0, 0, this);
+    progress->setWindowTitle("Reprocessing Trace...");
+    progress->setCancelButton(0);
+    progress->setWindowModality(Qt::WindowModal);
+    progress->show();
+
+    importThread = new QThread();
+    importWorker = new OTFImportFunctor(otfoptions);
+    importWorker->moveToThread(importThread);
+    importWorker->setTrace(trace);
+
+    connect(this, SIGNAL(operate(QString)), importWorker,
+            SLOT(doRecluster(QString)));
+    connect(importWorker, SIGNAL(done(Trace *)), this,
+            SLOT(traceReclustered(Trace *)));
+
+    importThread->start();
+    emit(operate(trace->fullpath));
+}
+
+void MainWindow::traceReclustered(Trace * trace)
+{
+    Q_UNUSED(trace);
+    progress->close();
+
+    delete importWorker;
+    delete progress;
+    delete importThread;
+
+    activeTraceChanged();
+}
+
 // Switch importing progress bar - something weird currently happens here
 void MainWindow::traceSwitch()
 {
@@ -442,11 +598,16 @@ void MainWindow::updateProgress(int portion, QString msg)
 // rather than a default... or not reset splitters at all
 void MainWindow::activeTraceChanged()
 {
+    // Hotspots point into the trace that was showing
+    delete hotspotsdialog;
+    hotspotsdialog = NULL;
+    stepspan = 15;
+
     for(int i = 0; i < viswidgets.size(); i++)
     {
         viswidgets[i]->setTrace(traces[activeTrace]);
         viswidgets[i]->processVis();
-        viswidgets[i]->repaint();
+        viswidgets[i]->update();
     }
     QList<int> splitter_sizes = ui->splitter->sizes();
     if (otfoptions->cluster)
@@ -466,6 +627,9 @@ void MainWindow::activeTraceChanged()
     ui->sideSplitter->setSizes(splitter_sizes);
     ui->actionClose->setEnabled(true);
     ui->actionSave->setEnabled(true);
+    ui->actionProcessing_Profile->setEnabled(true);
+    ui->actionHotspots->setEnabled(true);
+    ui->actionReprocess->setEnabled(true);
     ui->menuTraces->setEnabled(true);
 
     QList<QAction *> actions = ui->menuTraces->actions();
@@ -492,8 +656,18 @@ void MainWindow::closeTrace()
     Trace * trace = traces[activeTrace];
     traces.removeAt(activeTrace);
     ui->menuTraces->removeAction(ui->menuTraces->actions().at(activeTrace));
+
+    // Background drawing may still be reading it
+    for (int i = 0; i < viswidgets.size(); i++)
+        viswidgets[i]->cancelFrames();
     delete trace;
 
+    // The profile and hotspot dialogs may be showing the closed trace
+    delete profiledialog;
+    profiledialog = NULL;
+    delete hotspotsdialog;
+    hotspotsdialog = NULL;
+
     int index = -1;
     QString fallback = activetraces.pop();
     while (index < 0 && !activetraces.isEmpty())
@@ -517,6 +691,9 @@ void MainWindow::closeTrace()
     else // We must have no traces left
     {
         ui->menuTraces->setEnabled(false);
+        ui->actionProcessing_Profile->setEnabled(false);
+        ui->actionHotspots->setEnabled(false);
+        ui->actionReprocess->setEnabled(false);
     }
 }
 
@@ -33,12 +33,15 @@
 
 class Gnome;
 class Event;
+class CommEvent;
 class Trace;
 class OTFImportOptions;
 class ImportOptionsDialog;
 class VisWidget;
 class VisOptions;
 class VisOptionsDialog;
+class ProfileDialog;
+class HotspotsDialog;
 
 class QAction;
 class OTFImportFunctor;
@@ -64,16 +67,21 @@ public:
 public slots:
     void launchOTFOptions();
     void launchVisOptions();
+    void launchProcessingProfile();
+    void launchHotspots();
+    void reprocessTrace();
 
 
     // Signal relays
     void pushSteps(float start, float stop, bool jump = false);
     void selectEvent(Event * event, bool aggregate, bool overdraw);
     void selectTasks(QList<int> tasks, Gnome *gnome);
+    void showHotspot(CommEvent * event, bool aggregate);
 
     // Importing & Progress Bar
     void importOTFbyGUI();
     void traceFinished(Trace * trace);
+    void traceReclustered(Trace * trace);
     void updateProgress(int portion, QString msg);
     void traceSwitch();
 
@@ -101,6 +109,7 @@ signals:
 private:
     Ui::MainWindow *ui;
     void importTrace(QString dataFileName);
+    void reclusterTrace(Trace * trace);
     void activeTraceChanged();
     void linkSideSplitter();
     void linkMainSplitter();
@@ -128,6 +137,14 @@ private:
     VisOptions * visoptions;
     VisOptionsDialog * visdialog;
 
+    // Timings for the active trace
+    ProfileDialog * profiledialog;
+
+    // Worst events of the active trace, and the step span the views last
+    // showed so jumping to one keeps the zoom
+    HotspotsDialog * hotspotsdialog;
+    float stepspan;
+
     QString activetracename;
 
     QStack<QString> activetraces;
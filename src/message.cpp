@@ -25,7 +25,7 @@
 #include "message.h"
 #include "commevent.h"
 #include "p2pevent.h"
-#include "viswidget.h"
+#include "commdrawinterface.h"
 
 Message::Message(unsigned long long send, unsigned long long recv, int group)
     : CommBundle(), sendtime(send), recvtime(recv),
@@ -30,6 +30,9 @@
 #include "taskgroup.h"
 #include "function.h"
 #include "rpartition.h"
+#include "otf2writerattributes.h"
+#include <otf2/OTF2_Pthread_Locks.h>
+#include <QtConcurrent/QtConcurrentMap>
 #include <climits>
 #include <cmath>
 #include <iostream>
@@ -77,6 +80,7 @@ void OTF2Exporter::exportTrace(QString path, QString filename)
                                 OTF2_SUBSTRATE_POSIX, OTF2_COMPRESSION_NONE);
 
     OTF2_Archive_SetFlushCallbacks(archive, &flush_callbacks, NULL);
+    OTF2_Pthread_Archive_SetLockingCallbacks(archive, NULL);
     OTF2_Archive_SetSerialCollectiveCallbacks(archive);
     exportDefinitions();
     exportEvents();
@@ -88,27 +92,39 @@ void OTF2Exporter::exportEvents()
 {
     OTF2_Archive_OpenEvtFiles(archive);
 
+    // Writers are opened and closed here, only the writing itself is
+    // spread over the thread pool, one task per location
+    QVector<TaskExport> task_exports = QVector<TaskExport>();
     for (QMap<int, Task *>::Iterator task = trace->tasks->begin();
          task != trace->tasks->end(); ++task)
     {
-        exportTaskEvents(task.key());
+        TaskExport task_export;
+        task_export.roots = trace->roots->at(task.key());
+        task_export.writer = OTF2_Archive_GetEvtWriter(archive, task.key());
+        task_export.attributes = new OTF2WriterAttributes(attributeMap,
+                                                          trace->metrics);
+        task_exports.append(task_export);
+    }
+
+    QtConcurrent::blockingMap(task_exports, OTF2Exporter::exportTaskEvents);
+
+    for (QVector<TaskExport>::Iterator task_export = task_exports.begin();
+         task_export != task_exports.end(); ++task_export)
+    {
+        OTF2_Archive_CloseEvtWriter(archive, task_export->writer);
+        delete task_export->attributes;
     }
 
     OTF2_Archive_CloseEvtFiles(archive);
 }
 
-void OTF2Exporter::exportTaskEvents(int taskid)
+void OTF2Exporter::exportTaskEvents(TaskExport& task_export)
 {
-    QVector<Event *> * roots = trace->roots->at(taskid);
-    OTF2_EvtWriter * evt_writer = OTF2_Archive_GetEvtWriter(archive,
-                                                            taskid);
-    for (QVector<Event *>::Iterator root = roots->begin();
-         root != roots->end(); ++root)
+    for (QVector<Event *>::Iterator root = task_export.roots->begin();
+         root != task_export.roots->end(); ++root)
     {
-        (*root)->writeToOTF2(evt_writer, attributeMap);
+        (*root)->writeToOTF2(task_export.writer, task_export.attributes);
     }
-
-    OTF2_Archive_CloseEvtWriter(archive, evt_writer);
 }
 
 void OTF2Exporter::exportDefinitions()
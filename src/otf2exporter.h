@@ -28,8 +28,11 @@
 #include <otf2/otf2.h>
 #include <QString>
 #include <QMap>
+#include <QVector>
 
 class Trace;
+class Event;
+class OTF2WriterAttributes;
 
 class OTF2Exporter
 {
@@ -75,7 +78,14 @@ private:
     void exportTasks();
     void exportTaskGroups();
     void exportEvents();
-    void exportTaskEvents(int taskid);
+
+    // Everything one location's writer needs
+    struct TaskExport {
+        QVector<Event *> * roots;
+        OTF2_EvtWriter * writer;
+        OTF2WriterAttributes * attributes;
+    };
+    static void exportTaskEvents(TaskExport& task_export);
 
     QMap<QString, int> inverseStringMap;
     QMap<QString, int> * attributeMap;
@@ -24,9 +24,10 @@
 //////////////////////////////////////////////////////////////////////////////
 #include "otf2importer.h"
 #include <QString>
-#include <QElapsedTimer>
+#include "processingprofile.h"
 #include <iostream>
 #include <cmath>
+#include <climits>
 #include "general_util.h"
 #include "rawtrace.h"
 #include "commrecord.h"
@@ -50,6 +51,10 @@ OTF2Importer::OTF2Importer()
       sendcount(0),
       recvcount(0),
       enforceMessageSize(false),
+      windowed(false),
+      window_start(0),
+      window_end(ULLONG_MAX),
+      stubcount(0),
       options(new OTFImportOptions()),
       otfReader(NULL),
       global_def_callbacks(NULL),
@@ -64,6 +69,8 @@ OTF2Importer::OTF2Importer()
       commIndexMap(new QMap<OTF2_CommRef, int>()),
       regionIndexMap(new QMap<OTF2_RegionRef, int>()),
       locationIndexMap(new QMap<OTF2_LocationRef, int>()),
+      task_index(NULL),
+      partners(NULL),
       unmatched_recvs(new QVector<QLinkedList<CommRecord *> *>()),
       unmatched_sends(new QVector<QLinkedList<CommRecord *> *>()),
       unmatched_send_requests(new QVector<QLinkedList<CommRecord *> *>()),
@@ -225,11 +232,14 @@ OTF2Importer::~OTF2Importer()
     delete regionMap;
 
     // Don't delete members from OTF2Group, those becomes
-    // processes in kept communicators
+    // processes in kept communicators. Task subsets give the
+    // communicators their own lists instead.
     for (QMap<OTF2_GroupRef, OTF2Group *>::Iterator eitr
          = groupMap->begin();
          eitr != groupMap->end(); ++eitr)
     {
+        if (task_index)
+            delete eitr.value()->members;
         delete eitr.value();
     }
     delete groupMap;
@@ -242,21 +252,22 @@ OTF2Importer::~OTF2Importer()
     }
     delete commMap;
 
+    delete task_index;
+    delete partners;
     delete options;
 }
 
-RawTrace * OTF2Importer::importOTF2(const char* otf_file, bool _enforceMessageSize)
+RawTrace * OTF2Importer::importOTF2(const char* otf_file,
+                                    OTFImportOptions * import_options,
+                                    ProcessingProfile * profile)
 {
-    enforceMessageSize = _enforceMessageSize;
+    enforceMessageSize = import_options->enforceMessageSizes;
     entercount = 0;
     exitcount = 0;
     sendcount = 0;
     recvcount = 0;
 
-    QElapsedTimer traceTimer;
-    qint64 traceElapsed;
-
-    traceTimer.start();
+    ProfileScope scope(profile, "OTF Reading");
 
     // Setup
     otfReader = OTF2_Reader_Open(otf_file);
@@ -290,6 +301,23 @@ RawTrace * OTF2Importer::importOTF2(const char* otf_file, bool _enforceMessageSi
 
     processDefinitions();
 
+    // Window in converted time units. Saved traces were already processed,
+    // so they are always read whole.
+    windowed = import_options->timeWindow && from_saved_version.isEmpty();
+    if (windowed)
+    {
+        double scale = pow(10, second_magnitude);
+        window_start = import_options->windowStart * scale;
+        if (import_options->windowEnd > import_options->windowStart)
+            window_end = import_options->windowEnd * scale;
+        std::cout << "Reading window " << window_start << " - "
+                  << window_end << std::endl;
+    }
+
+    // Same for task subsets
+    if (import_options->taskSubset && from_saved_version.isEmpty())
+        selectTasks(otf_file, import_options);
+
     rawtrace = new RawTrace(num_processes);
     *(rawtrace->options) = *options;
     rawtrace->tasks = tasks;
@@ -391,6 +419,14 @@ RawTrace * OTF2Importer::importOTF2(const char* otf_file, bool _enforceMessageSi
 
     rawtrace->collectiveMap = collectiveMap;
 
+    if (windowed)
+    {
+        finishWindow();
+        int truncated = rawtrace->clipToWindow(window_start, window_end);
+        if (profile)
+            profile->setCounter("Truncated messages", truncated);
+    }
+
     OTF2_Reader_CloseGlobalEvtReader( otfReader, global_evt_reader );
     OTF2_Reader_CloseEvtFiles( otfReader );
     OTF2_Reader_Close( otfReader );
@@ -428,11 +464,16 @@ RawTrace * OTF2Importer::importOTF2(const char* otf_file, bool _enforceMessageSi
     std::cout << unmatched_send_count << " unmatched sends and "
               << unmatched_recv_count << " unmatched recvs." << std::endl;
 
-
-    traceElapsed = traceTimer.nsecsElapsed();
-    std::cout << "OTF Reading: ";
-    gu_printTime(traceElapsed);
-    std::cout << std::endl;
+    if (profile)
+    {
+        profile->setCounter("Unmatched sends", unmatched_send_count);
+        profile->setCounter("Unmatched receives", unmatched_recv_count);
+        if (task_index)
+        {
+            profile->setCounter("Selected tasks", num_processes);
+            profile->setCounter("Boundary messages", stubcount);
+        }
+    }
 
     return rawtrace;
 }
@@ -595,6 +636,236 @@ uint64_t OTF2Importer::convertTime(void* userData, OTF2_TimeStamp time)
 }
 
 
+int OTF2Importer::windowPosition(void * userData, unsigned long long time)
+{
+    OTF2Importer * importer = (OTF2Importer *) userData;
+    if (!importer->windowed)
+        return 0;
+    if (time < importer->window_start)
+        return -1;
+    if (time > importer->window_end)
+        return 1;
+    return 0;
+}
+
+CommRecord * OTF2Importer::windowMatch(void * userData, CommRecord * cr)
+{
+    bool send_out = windowPosition(userData, cr->send_time) < 0;
+    bool recv_out = windowPosition(userData, cr->recv_time) < 0;
+    if (send_out && recv_out)
+    {
+        delete cr;
+        return NULL;
+    }
+    if (send_out || recv_out)
+        cr->truncated = true;
+    return cr;
+}
+
+// Messages still unmatched lost their other end past the window. The ones
+// with neither end inside are not in the raw trace and go now, the rest
+// are marked for RawTrace::clipToWindow to remove.
+void OTF2Importer::finishWindow()
+{
+    for (int i = 0; i < num_processes; i++)
+    {
+        for (QLinkedList<CommRecord *>::Iterator cr = (*unmatched_sends)[i]->begin();
+             cr != (*unmatched_sends)[i]->end(); ++cr)
+        {
+            if (windowPosition(this, (*cr)->send_time) < 0)
+                delete *cr;
+            else
+                (*cr)->truncated = true;
+        }
+        (*unmatched_sends)[i]->clear();
+
+        for (QLinkedList<CommRecord *>::Iterator cr = (*unmatched_recvs)[i]->begin();
+             cr != (*unmatched_recvs)[i]->end(); ++cr)
+        {
+            if (windowPosition(this, (*cr)->recv_time) < 0)
+                delete *cr;
+            else
+                (*cr)->truncated = true;
+        }
+        (*unmatched_recvs)[i]->clear();
+
+        QLinkedList<CommRecord *>::Iterator request = (*unmatched_send_requests)[i]->begin();
+        while (request != (*unmatched_send_requests)[i]->end())
+        {
+            if ((*request)->truncated)
+                request = (*unmatched_send_requests)[i]->erase(request);
+            else
+                ++request;
+        }
+    }
+}
+
+int OTF2Importer::taskIndex(void * userData, int rank)
+{
+    QVector<int> * task_index = ((OTF2Importer *) userData)->task_index;
+    if (!task_index)
+        return rank;
+    if (rank < 0 || rank >= task_index->size())
+        return -1;
+    return task_index->at(rank);
+}
+
+void OTF2Importer::addStub(void * userData, CommRecord * cr, bool send)
+{
+    RawTrace * rawtrace = ((OTF2Importer *) userData)->rawtrace;
+    cr->stub = true;
+    if (send)
+        (*(rawtrace->messages))[cr->sender]->append(cr);
+    else
+        (*(rawtrace->messages_r))[cr->receiver]->append(cr);
+    ((OTF2Importer *) userData)->stubcount++;
+}
+
+// Narrow the import to the tasks named in the options and, if asked, their
+// message partners. The kept tasks are renumbered from zero in rank order
+// and only their locations are read.
+void OTF2Importer::selectTasks(const char * otf_file,
+                               OTFImportOptions * import_options)
+{
+    QSet<int> selected = RawTrace::parseTaskFilter(import_options->taskFilter,
+                                                   tasks, taskgroups);
+    if (selected.isEmpty())
+    {
+        std::cout << "No tasks match " << import_options->taskFilter.toStdString()
+                  << ", reading all tasks" << std::endl;
+        return;
+    }
+
+    if (import_options->taskHops > 0)
+    {
+        readPartners(otf_file);
+        RawTrace::addPartnerHops(selected, partners, import_options->taskHops);
+    }
+
+    task_index = new QVector<int>(tasks->isEmpty() ? 0 : tasks->lastKey() + 1, -1);
+    QMap<int, Task *> * subset = new QMap<int, Task *>();
+    for (QMap<int, Task *>::Iterator task = tasks->begin();
+         task != tasks->end(); ++task)
+    {
+        if (selected.contains(task.key()))
+        {
+            int index = subset->size();
+            (*task_index)[task.key()] = index;
+            task.value()->id = index;
+            subset->insert(index, task.value());
+        }
+        else
+        {
+            delete task.value();
+        }
+    }
+    delete tasks;
+    tasks = subset;
+    num_processes = tasks->size();
+
+    QMap<OTF2_LocationRef, int>::Iterator loc = locationIndexMap->begin();
+    while (loc != locationIndexMap->end())
+    {
+        int index = task_index->at(loc.value());
+        if (index < 0)
+        {
+            loc = locationIndexMap->erase(loc);
+        }
+        else
+        {
+            loc.value() = index;
+            ++loc;
+        }
+    }
+
+    // Communicators keep their rank order for the members we have
+    for (QMap<int, TaskGroup *>::Iterator tg = taskgroups->begin();
+         tg != taskgroups->end(); ++tg)
+    {
+        TaskGroup * t = tg.value();
+        QList<unsigned int> * members = new QList<unsigned int>();
+        t->taskorder->clear();
+        for (int i = 0; i < t->tasks->size(); i++)
+        {
+            int index = taskIndex(this, t->tasks->at(i));
+            if (index >= 0)
+            {
+                members->append(index);
+                t->taskorder->insert(index, i);
+            }
+        }
+        t->tasks = members; // Old list still belongs to the OTF2Group
+    }
+
+    std::cout << "Reading " << num_processes << " of " << task_index->size()
+              << " tasks" << std::endl;
+}
+
+// Cheap first pass over only the sends of every location to find the
+// message partners of each task
+void OTF2Importer::readPartners(const char * otf_file)
+{
+    partners = new QMap<int, QSet<int> >();
+
+    OTF2_Reader * reader = OTF2_Reader_Open(otf_file);
+    OTF2_Reader_SetSerialCollectiveCallbacks(reader);
+    OTF2_GlobalDefReader * global_def_reader = OTF2_Reader_GetGlobalDefReader(reader);
+    uint64_t definitions_read = 0;
+    OTF2_Reader_ReadAllGlobalDefinitions(reader, global_def_reader,
+                                         &definitions_read);
+
+    for (QMap<OTF2_LocationRef, int>::Iterator loc = locationIndexMap->begin();
+         loc != locationIndexMap->end(); ++loc)
+    {
+        OTF2_Reader_SelectLocation(reader, loc.key());
+    }
+
+    bool def_files_success = OTF2_Reader_OpenDefFiles(reader) == OTF2_SUCCESS;
+    OTF2_Reader_OpenEvtFiles(reader);
+    for (QMap<OTF2_LocationRef, int>::Iterator loc = locationIndexMap->begin();
+         loc != locationIndexMap->end(); ++loc)
+    {
+        if (def_files_success)
+        {
+            OTF2_DefReader * def_reader = OTF2_Reader_GetDefReader(reader, loc.key());
+            if (def_reader)
+            {
+                uint64_t def_reads = 0;
+                OTF2_Reader_ReadAllLocalDefinitions(reader, def_reader,
+                                                    &def_reads);
+                OTF2_Reader_CloseDefReader(reader, def_reader);
+            }
+        }
+        OTF2_Reader_GetEvtReader(reader, loc.key());
+    }
+    if (def_files_success)
+        OTF2_Reader_CloseDefFiles(reader);
+
+    std::cout << "Reading message partners" << std::endl;
+    OTF2_GlobalEvtReader * global_evt_reader = OTF2_Reader_GetGlobalEvtReader(reader);
+    OTF2_GlobalEvtReaderCallbacks * callbacks = OTF2_GlobalEvtReaderCallbacks_New();
+    OTF2_GlobalEvtReaderCallbacks_SetMpiSendCallback(callbacks,
+                                                     &OTF2Importer::callbackPartnerSend);
+    OTF2_GlobalEvtReaderCallbacks_SetMpiIsendCallback(callbacks,
+                                                      &OTF2Importer::callbackPartnerIsend);
+    OTF2_Reader_RegisterGlobalEvtCallbacks(reader, global_evt_reader,
+                                           callbacks, this);
+    OTF2_GlobalEvtReaderCallbacks_Delete(callbacks);
+
+    uint64_t events_read = 0;
+    OTF2_Reader_ReadAllGlobalEvents(reader, global_evt_reader, &events_read);
+
+    OTF2_Reader_CloseGlobalEvtReader(reader, global_evt_reader);
+    OTF2_Reader_CloseEvtFiles(reader);
+    OTF2_Reader_Close(reader);
+}
+
+void OTF2Importer::addPartner(int sender, int receiver)
+{
+    (*partners)[sender].insert(receiver);
+    (*partners)[receiver].insert(sender);
+}
+
 // May want to save globalOffset and traceLength for max and min
 OTF2_CallbackCode OTF2Importer::callbackDefClockProperties(void * userData,
                                                            uint64_t timerResolution,
@@ -723,11 +994,17 @@ OTF2_CallbackCode OTF2Importer::callbackEnter(OTF2_LocationRef locationID,
                                               OTF2_RegionRef region)
 {
     Q_UNUSED(attributeList);
+    uint64_t converted_time = convertTime(userData, time);
+    int window = windowPosition(userData, converted_time);
+    if (window > 0) // Events are in time order, nothing more to read
+        return OTF2_CALLBACK_INTERRUPT;
+    else if (window < 0)
+        return OTF2_CALLBACK_SUCCESS;
+
     int process = ((OTF2Importer *) userData)->locationIndexMap->value(locationID);
     int function = ((OTF2Importer *) userData)->regionIndexMap->value(region);
     ((*((((OTF2Importer*) userData)->rawtrace)->events))[process])->append(new EventRecord(process,
-                                                                                           convertTime(userData,
-                                                                                                       time),
+                                                                                           converted_time,
                                                                                            function,
                                                                                            true));
     return OTF2_CALLBACK_SUCCESS;
@@ -739,10 +1016,17 @@ OTF2_CallbackCode OTF2Importer::callbackLeave(OTF2_LocationRef locationID,
                                               OTF2_AttributeList * attributeList,
                                               OTF2_RegionRef region)
 {
+    uint64_t converted_time = convertTime(userData, time);
+    int window = windowPosition(userData, converted_time);
+    if (window > 0)
+        return OTF2_CALLBACK_INTERRUPT;
+    else if (window < 0)
+        return OTF2_CALLBACK_SUCCESS;
+
     int process = ((OTF2Importer *) userData)->locationIndexMap->value(locationID);
     int function = ((OTF2Importer *) userData)->regionIndexMap->value(region);
     EventRecord * er = new EventRecord(process,
-                                       convertTime(userData, time),
+                                       converted_time,
                                        function,
                                        false);
     ((*((((OTF2Importer*) userData)->rawtrace)->events))[process])->append(er);
@@ -780,6 +1064,52 @@ OTF2_CallbackCode OTF2Importer::callbackLeave(OTF2_LocationRef locationID,
 }
 
 
+// Partners are collected over the whole run, the window does not apply
+OTF2_CallbackCode OTF2Importer::callbackPartnerSend(OTF2_LocationRef locationID,
+                                                    OTF2_TimeStamp time,
+                                                    void * userData,
+                                                    OTF2_AttributeList * attributeList,
+                                                    uint32_t receiver,
+                                                    OTF2_CommRef communicator,
+                                                    uint32_t msgTag,
+                                                    uint64_t msgLength)
+{
+    Q_UNUSED(time);
+    Q_UNUSED(attributeList);
+    Q_UNUSED(msgTag);
+    Q_UNUSED(msgLength);
+
+    OTF2Importer * importer = (OTF2Importer *) userData;
+    OTF2Comm * comm = importer->commMap->value(communicator);
+    OTF2Group * group = importer->groupMap->value(comm->group);
+    importer->addPartner(importer->locationIndexMap->value(locationID),
+                         group->members->at(receiver));
+    return OTF2_CALLBACK_SUCCESS;
+}
+
+OTF2_CallbackCode OTF2Importer::callbackPartnerIsend(OTF2_LocationRef locationID,
+                                                     OTF2_TimeStamp time,
+                                                     void * userData,
+                                                     OTF2_AttributeList * attributeList,
+                                                     uint32_t receiver,
+                                                     OTF2_CommRef communicator,
+                                                     uint32_t msgTag,
+                                                     uint64_t msgLength,
+                                                     uint64_t requestID)
+{
+    Q_UNUSED(time);
+    Q_UNUSED(attributeList);
+    Q_UNUSED(communicator);
+    Q_UNUSED(msgTag);
+    Q_UNUSED(msgLength);
+    Q_UNUSED(requestID);
+
+    OTF2Importer * importer = (OTF2Importer *) userData;
+    importer->addPartner(importer->locationIndexMap->value(locationID), receiver);
+    return OTF2_CALLBACK_SUCCESS;
+}
+
+
 // Check if two comm records match
 // (one that already is a record, one that is just parts)
 bool OTF2Importer::compareComms(CommRecord * comm, unsigned int sender,
@@ -816,22 +1146,38 @@ OTF2_CallbackCode OTF2Importer::callbackMPISend(OTF2_LocationRef locationID,
     // Every time we find a send, check the unmatched recvs
     // to see if it has a match
     unsigned long long converted_time = convertTime(userData, time);
+    int window = windowPosition(userData, converted_time);
+    if (window > 0)
+        return OTF2_CALLBACK_INTERRUPT;
+
+    // Sends before the window are still matched so the receives inside it
+    // pair up correctly, but they are not kept
     int sender = ((OTF2Importer *) userData)->locationIndexMap->value(locationID);
     OTF2Comm * comm = ((OTF2Importer *) userData)->commMap->value(communicator);
     OTF2Group * group = ((OTF2Importer *) userData)->groupMap->value(comm->group);
     int world_receiver = group->members->at(receiver);
+    int taskgroup = ((OTF2Importer *) userData)->commIndexMap->value(communicator);
+    int receiver_task = taskIndex(userData, world_receiver);
+    if (receiver_task < 0)
+    {
+        if (window == 0)
+            addStub(userData, new CommRecord(sender, converted_time, world_receiver,
+                                             0, msgLength, msgTag, taskgroup),
+                    true);
+        return OTF2_CALLBACK_SUCCESS;
+    }
+
     CommRecord * cr = NULL;
     QLinkedList<CommRecord *> * unmatched = (*(((OTF2Importer *) userData)->unmatched_recvs))[sender];
     bool useSize = ((OTF2Importer *) userData)->enforceMessageSize;
     for (QLinkedList<CommRecord *>::Iterator itr = unmatched->begin();
          itr != unmatched->end(); ++itr)
     {
-        if (useSize ? OTF2Importer::compareComms((*itr), sender, world_receiver, msgTag, msgLength)
-                    : OTF2Importer::compareComms((*itr), sender, world_receiver, msgTag))
+        if (useSize ? OTF2Importer::compareComms((*itr), sender, receiver_task, msgTag, msgLength)
+                    : OTF2Importer::compareComms((*itr), sender, receiver_task, msgTag))
         {
             cr = *itr;
             cr->send_time = converted_time;
-            ((*((((OTF2Importer*) userData)->rawtrace)->messages))[sender])->append((cr));
             break;
         }
     }
@@ -842,12 +1188,15 @@ OTF2_CallbackCode OTF2Importer::callbackMPISend(OTF2_LocationRef locationID,
     if (cr)
     {
         (*(((OTF2Importer *) userData)->unmatched_recvs))[sender]->removeOne(cr);
+        if (window == 0)
+            ((*((((OTF2Importer*) userData)->rawtrace)->messages))[sender])->append((cr));
+        windowMatch(userData, cr);
     }
     else
     {
-        int taskgroup = ((OTF2Importer *) userData)->commIndexMap->value(communicator);
-        cr = new CommRecord(sender, converted_time, world_receiver, 0, msgLength, msgTag, taskgroup);
-        (*((((OTF2Importer*) userData)->rawtrace)->messages))[sender]->append(cr);
+        cr = new CommRecord(sender, converted_time, receiver_task, 0, msgLength, msgTag, taskgroup);
+        if (window == 0)
+            (*((((OTF2Importer*) userData)->rawtrace)->messages))[sender]->append(cr);
         (*(((OTF2Importer *) userData)->unmatched_sends))[sender]->append(cr);
     }
     return OTF2_CALLBACK_SUCCESS;
@@ -868,38 +1217,62 @@ OTF2_CallbackCode OTF2Importer::callbackMPIIsend(OTF2_LocationRef locationID,
     // Every time we find a send, check the unmatched recvs
     // to see if it has a match
     unsigned long long converted_time = convertTime(userData, time);
+    int window = windowPosition(userData, converted_time);
+    if (window > 0)
+        return OTF2_CALLBACK_INTERRUPT;
+
     int sender = ((OTF2Importer *) userData)->locationIndexMap->value(locationID);
+    int taskgroup = ((OTF2Importer *) userData)->commIndexMap->value(communicator);
+    int receiver_task = taskIndex(userData, receiver);
     CommRecord * cr = NULL;
-    QLinkedList<CommRecord *> * unmatched = (*(((OTF2Importer *) userData)->unmatched_recvs))[sender];
-    bool useSize = ((OTF2Importer *) userData)->enforceMessageSize;
-    for (QLinkedList<CommRecord *>::Iterator itr = unmatched->begin();
-         itr != unmatched->end(); ++itr)
-    {
-        if (useSize ? OTF2Importer::compareComms((*itr), sender, receiver, msgTag, msgLength)
-                    : OTF2Importer::compareComms((*itr), sender, receiver, msgTag))
-        {
-            cr = *itr;
-            cr->send_time = converted_time;
-            ((*((((OTF2Importer*) userData)->rawtrace)->messages))[sender])->append((cr));
-            break;
-        }
-    }
-
-    // If we did find a match, remove it from the unmatched.
-    // Otherwise, create a new unmatched send record
-    if (cr)
+    if (receiver_task < 0)
     {
-        (*(((OTF2Importer *) userData)->unmatched_recvs))[sender]->removeOne(cr);
+        // Stubs still want their completion time
+        if (window < 0)
+            return OTF2_CALLBACK_SUCCESS;
+        cr = new CommRecord(sender, converted_time, receiver, 0, msgLength,
+                            msgTag, taskgroup, requestID);
+        addStub(userData, cr, true);
     }
     else
     {
-        int taskgroup = ((OTF2Importer *) userData)->commIndexMap->value(communicator);
-        cr = new CommRecord(sender, converted_time, receiver, 0, msgLength,
-                            msgTag, taskgroup, requestID);
-        (*((((OTF2Importer*) userData)->rawtrace)->messages))[sender]->append(cr);
-        (*(((OTF2Importer *) userData)->unmatched_sends))[sender]->append(cr);
+        QLinkedList<CommRecord *> * unmatched = (*(((OTF2Importer *) userData)->unmatched_recvs))[sender];
+        bool useSize = ((OTF2Importer *) userData)->enforceMessageSize;
+        for (QLinkedList<CommRecord *>::Iterator itr = unmatched->begin();
+             itr != unmatched->end(); ++itr)
+        {
+            if (useSize ? OTF2Importer::compareComms((*itr), sender, receiver_task, msgTag, msgLength)
+                        : OTF2Importer::compareComms((*itr), sender, receiver_task, msgTag))
+            {
+                cr = *itr;
+                cr->send_time = converted_time;
+                break;
+            }
+        }
+
+        // If we did find a match, remove it from the unmatched.
+        // Otherwise, create a new unmatched send record
+        if (cr)
+        {
+            (*(((OTF2Importer *) userData)->unmatched_recvs))[sender]->removeOne(cr);
+            if (window == 0)
+                ((*((((OTF2Importer*) userData)->rawtrace)->messages))[sender])->append((cr));
+            windowMatch(userData, cr);
+        }
+        else
+        {
+            cr = new CommRecord(sender, converted_time, receiver_task, 0, msgLength,
+                                msgTag, taskgroup, requestID);
+            if (window == 0)
+                (*((((OTF2Importer*) userData)->rawtrace)->messages))[sender]->append(cr);
+            (*(((OTF2Importer *) userData)->unmatched_sends))[sender]->append(cr);
+        }
     }
 
+    // Completions only matter for sends we keep
+    if (window < 0)
+        return OTF2_CALLBACK_SUCCESS;
+
     // Also check the complete time stuff
     OTF2IsendComplete * complete = NULL;
     QLinkedList<OTF2IsendComplete *> * completes
@@ -939,6 +1312,12 @@ OTF2_CallbackCode OTF2Importer::callbackMPIIsendComplete(OTF2_LocationRef locati
 
     // Check to see if we have a matching send request
     unsigned long long converted_time = convertTime(userData, time);
+    int window = windowPosition(userData, converted_time);
+    if (window > 0)
+        return OTF2_CALLBACK_INTERRUPT;
+    else if (window < 0)
+        return OTF2_CALLBACK_SUCCESS;
+
     int sender = ((OTF2Importer *) userData)->locationIndexMap->value(locationID);
     CommRecord * cr = NULL;
     QLinkedList<CommRecord *> * unmatched = (*(((OTF2Importer *) userData)->unmatched_send_requests))[sender];
@@ -997,18 +1376,33 @@ OTF2_CallbackCode OTF2Importer::callbackMPIRecv(OTF2_LocationRef locationID,
 
     // Look for match in unmatched_sends
     unsigned long long converted_time = convertTime(userData, time);
+    int window = windowPosition(userData, converted_time);
+    if (window > 0)
+        return OTF2_CALLBACK_INTERRUPT;
+
     int receiver = ((OTF2Importer *) userData)->locationIndexMap->value(locationID);
     OTF2Comm * comm = ((OTF2Importer *) userData)->commMap->value(communicator);
     OTF2Group * group = ((OTF2Importer *) userData)->groupMap->value(comm->group);
     int world_sender = group->members->at(sender);
+    int taskgroup = ((OTF2Importer *) userData)->commIndexMap->value(communicator);
+    int sender_task = taskIndex(userData, world_sender);
+    if (sender_task < 0)
+    {
+        if (window == 0)
+            addStub(userData, new CommRecord(world_sender, 0, receiver, converted_time,
+                                             msgLength, msgTag, taskgroup),
+                    false);
+        return OTF2_CALLBACK_SUCCESS;
+    }
+
     CommRecord * cr = NULL;
-    QLinkedList<CommRecord *> * unmatched = (*(((OTF2Importer*) userData)->unmatched_sends))[world_sender];
+    QLinkedList<CommRecord *> * unmatched = (*(((OTF2Importer*) userData)->unmatched_sends))[sender_task];
     bool useSize = ((OTF2Importer *) userData)->enforceMessageSize;
     for (QLinkedList<CommRecord *>::Iterator itr = unmatched->begin();
          itr != unmatched->end(); ++itr)
     {
-        if (useSize ? OTF2Importer::compareComms((*itr), world_sender, receiver, msgTag, msgLength)
-                    : OTF2Importer::compareComms((*itr), world_sender, receiver, msgTag))
+        if (useSize ? OTF2Importer::compareComms((*itr), sender_task, receiver, msgTag, msgLength)
+                    : OTF2Importer::compareComms((*itr), sender_task, receiver, msgTag))
         {
             cr = *itr;
             cr->recv_time = converted_time;
@@ -1020,15 +1414,16 @@ OTF2_CallbackCode OTF2Importer::callbackMPIRecv(OTF2_LocationRef locationID,
     // a new unmatched recv record
     if (cr)
     {
-        (*(((OTF2Importer *) userData)->unmatched_sends))[world_sender]->removeOne(cr);
+        (*(((OTF2Importer *) userData)->unmatched_sends))[sender_task]->removeOne(cr);
+        cr = windowMatch(userData, cr);
     }
     else
     {
-        int taskgroup = ((OTF2Importer *) userData)->commIndexMap->value(communicator);
-        cr = new CommRecord(world_sender, 0, receiver, converted_time, msgLength, msgTag, taskgroup);
-        ((*(((OTF2Importer*) userData)->unmatched_recvs))[world_sender])->append(cr);
+        cr = new CommRecord(sender_task, 0, receiver, converted_time, msgLength, msgTag, taskgroup);
+        ((*(((OTF2Importer*) userData)->unmatched_recvs))[sender_task])->append(cr);
     }
-    (*((((OTF2Importer*) userData)->rawtrace)->messages_r))[receiver]->append(cr);
+    if (cr && window == 0)
+        (*((((OTF2Importer*) userData)->rawtrace)->messages_r))[receiver]->append(cr);
 
     return OTF2_CALLBACK_SUCCESS;
 }
@@ -1048,15 +1443,30 @@ OTF2_CallbackCode OTF2Importer::callbackMPIIrecv(OTF2_LocationRef locationID,
 
     // Look for match in unmatched_sends
     unsigned long long converted_time = convertTime(userData, time);
+    int window = windowPosition(userData, converted_time);
+    if (window > 0)
+        return OTF2_CALLBACK_INTERRUPT;
+
     int receiver = ((OTF2Importer *) userData)->locationIndexMap->value(locationID);
+    int taskgroup = ((OTF2Importer *) userData)->commIndexMap->value(communicator);
+    int sender_task = taskIndex(userData, sender);
+    if (sender_task < 0)
+    {
+        if (window == 0)
+            addStub(userData, new CommRecord(sender, 0, receiver, converted_time,
+                                             msgLength, msgTag, taskgroup),
+                    false);
+        return OTF2_CALLBACK_SUCCESS;
+    }
+
     CommRecord * cr = NULL;
-    QLinkedList<CommRecord *> * unmatched = (*(((OTF2Importer*) userData)->unmatched_sends))[sender];
+    QLinkedList<CommRecord *> * unmatched = (*(((OTF2Importer*) userData)->unmatched_sends))[sender_task];
     bool useSize = ((OTF2Importer *) userData)->enforceMessageSize;
     for (QLinkedList<CommRecord *>::Iterator itr = unmatched->begin();
          itr != unmatched->end(); ++itr)
     {
-        if (useSize ? OTF2Importer::compareComms((*itr), sender, receiver, msgTag, msgLength)
-                    : OTF2Importer::compareComms((*itr), sender, receiver, msgTag))
+        if (useSize ? OTF2Importer::compareComms((*itr), sender_task, receiver, msgTag, msgLength)
+                    : OTF2Importer::compareComms((*itr), sender_task, receiver, msgTag))
         {
             cr = *itr;
             cr->recv_time = converted_time;
@@ -1068,15 +1478,16 @@ OTF2_CallbackCode OTF2Importer::callbackMPIIrecv(OTF2_LocationRef locationID,
     // a new unmatched recv record
     if (cr)
     {
-        (*(((OTF2Importer *) userData)->unmatched_sends))[sender]->removeOne(cr);
+        (*(((OTF2Importer *) userData)->unmatched_sends))[sender_task]->removeOne(cr);
+        cr = windowMatch(userData, cr);
     }
     else
     {
-        int taskgroup = ((OTF2Importer *) userData)->commIndexMap->value(communicator);
-        cr = new CommRecord(sender, 0, receiver, converted_time, msgLength, msgTag, taskgroup);
-        ((*(((OTF2Importer*) userData)->unmatched_recvs))[sender])->append(cr);
+        cr = new CommRecord(sender_task, 0, receiver, converted_time, msgLength, msgTag, taskgroup);
+        ((*(((OTF2Importer*) userData)->unmatched_recvs))[sender_task])->append(cr);
     }
-    (*((((OTF2Importer*) userData)->rawtrace)->messages_r))[receiver]->append(cr);
+    if (cr && window == 0)
+        (*((((OTF2Importer*) userData)->rawtrace)->messages_r))[receiver]->append(cr);
 
     return OTF2_CALLBACK_SUCCESS;
 }
@@ -1092,8 +1503,13 @@ OTF2_CallbackCode OTF2Importer::callbackMPICollectiveBegin(OTF2_LocationRef loca
     Q_UNUSED(locationID);
     Q_UNUSED(attributeList);
 
-    int process = ((OTF2Importer *) userData)->locationIndexMap->value(locationID);
+    // Collectives before the window are kept until they are matched up,
+    // RawTrace::clipToWindow drops them
     uint64_t converted_time = convertTime(userData, time);
+    if (windowPosition(userData, converted_time) > 0)
+        return OTF2_CALLBACK_INTERRUPT;
+
+    int process = ((OTF2Importer *) userData)->locationIndexMap->value(locationID);
     ((OTF2Importer *) userData)->collective_begins->at(process)->append(converted_time);
     return OTF2_CALLBACK_SUCCESS;
 }
@@ -1113,9 +1529,13 @@ OTF2_CallbackCode OTF2Importer::callbackMPICollectiveEnd(OTF2_LocationRef locati
     Q_UNUSED(sizeReceived);
     //Q_UNUSED(time);
 
+    uint64_t converted_time = convertTime(userData, time);
+    if (windowPosition(userData, converted_time) > 0)
+        return OTF2_CALLBACK_INTERRUPT;
+
     int process = ((OTF2Importer *) userData)->locationIndexMap->value(locationID);
 
-    ((OTF2Importer *) userData)->collective_fragments->at(process)->append(new OTF2CollectiveFragment(convertTime(userData, time),
+    ((OTF2Importer *) userData)->collective_fragments->at(process)->append(new OTF2CollectiveFragment(converted_time,
                                                                                                       collectiveOp,
                                                                                                       communicator,
                                                                                                       root));
@@ -1144,13 +1564,18 @@ void OTF2Importer::processCollectives()
             // Look through fragment list of other members of communicator for
             // matching fragments
             QList<uint32_t> * members = groupMap->value(commMap->value(fragment->comm)->group)->members;
-            for (QList<uint32_t>::Iterator process = members->begin();
-                 process != members->end(); ++process)
+            for (QList<uint32_t>::Iterator member = members->begin();
+                 member != members->end(); ++member)
             {
+                // Members outside a task subset were not read
+                int process = taskIndex(this, *member);
+                if (process < 0)
+                    continue;
+
                 OTF2CollectiveFragment * match = NULL;
                 for (QLinkedList<OTF2CollectiveFragment *>::Iterator cf
-                     = collective_fragments->at(*process)->begin();
-                     cf != collective_fragments->at(*process)->end(); ++cf)
+                     = collective_fragments->at(process)->begin();
+                     cf != collective_fragments->at(process)->end(); ++cf)
                 {
                     // A match!
                     if ((*cf)->op == fragment->op
@@ -1162,24 +1587,29 @@ void OTF2Importer::processCollectives()
                     }
                 }
 
-                if (!match)
+                // Members cut off by the end of a time window are expected
+                if (!match && windowed)
+                {
+                    continue;
+                }
+                else if (!match)
                 {
                     std::cout << "Error, no matching collective found for";
                     std::cout << " collective type " << int(fragment->op);
                     std::cout << " on communicator ";
                     std::cout << stringMap->value(commMap->value(fragment->comm)->name).toStdString().c_str();
-                    std::cout << " for process " << *process << std::endl;
+                    std::cout << " for process " << *member << std::endl;
                 }
                 else
                 {
                     // It's kind of weird that I can't expect the fragments to be in order
                     // but I have to rely on the begin_times being in order... we'll see
                     // if they actually work out.
-                    uint64_t begin_time = collective_begins->at(*process)->takeFirst();
-                    collective_fragments->at(*process)->removeOne(match);
+                    uint64_t begin_time = collective_begins->at(process)->takeFirst();
+                    collective_fragments->at(process)->removeOne(match);
 
-                    collectiveMap->at(*process)->insert(begin_time, cr);
-                    rawtrace->collectiveBits->at(*process)->append(new RawTrace::CollectiveBit(begin_time, cr));
+                    collectiveMap->at(process)->insert(begin_time, cr);
+                    rawtrace->collectiveBits->at(process)->append(new RawTrace::CollectiveBit(begin_time, cr));
                 }
             }
 
@@ -30,9 +30,11 @@
 #include <QString>
 #include <QMap>
 #include <QVector>
+#include <QSet>
 
 class CommRecord;
 class RawTrace;
+class ProcessingProfile;
 class Function;
 class Task;
 class TaskGroup;
@@ -46,7 +48,9 @@ class OTF2Importer
 public:
     OTF2Importer();
     ~OTF2Importer();
-    RawTrace * importOTF2(const char* otf_file, bool _enforceMessageSize);
+    RawTrace * importOTF2(const char* otf_file,
+                          OTFImportOptions * import_options,
+                          ProcessingProfile * profile = NULL);
 
     class OTF2Attribute {
     public:
@@ -301,6 +305,26 @@ public:
 
 
 
+    // First pass callbacks, only collecting who sends to whom
+    static OTF2_CallbackCode callbackPartnerSend(OTF2_LocationRef locationID,
+                                                 OTF2_TimeStamp time,
+                                                 void * userData,
+                                                 OTF2_AttributeList * attributeList,
+                                                 uint32_t receiver,
+                                                 OTF2_CommRef communicator,
+                                                 uint32_t msgTag,
+                                                 uint64_t msgLength);
+    static OTF2_CallbackCode callbackPartnerIsend(OTF2_LocationRef locationID,
+                                                  OTF2_TimeStamp time,
+                                                  void * userData,
+                                                  OTF2_AttributeList * attributeList,
+                                                  uint32_t receiver,
+                                                  OTF2_CommRef communicator,
+                                                  uint32_t msgTag,
+                                                  uint64_t msgLength,
+                                                  uint64_t requestID);
+
+
     // Match comm record of sender and receiver to find both times
     static bool compareComms(CommRecord * comm, unsigned int sender,
                              unsigned int receiver, unsigned int tag,
@@ -311,6 +335,18 @@ public:
 
     static uint64_t convertTime(void* userData, OTF2_TimeStamp time);
 
+    // Where a converted time falls against the import window:
+    // -1 before it, 0 inside it, 1 past it
+    static int windowPosition(void * userData, unsigned long long time);
+    // Marks a message matched across the window start as truncated, or
+    // deletes it and returns NULL if neither end is inside
+    static CommRecord * windowMatch(void * userData, CommRecord * cr);
+
+    // Task a trace rank was imported as, -1 if it is outside the subset
+    static int taskIndex(void * userData, int rank);
+    // Keeps the imported end of a message whose partner is outside the subset
+    static void addStub(void * userData, CommRecord * cr, bool send);
+
     QString from_saved_version;
     unsigned long long int ticks_per_second;
     unsigned long long int time_offset;
@@ -329,8 +365,16 @@ private:
     void setDefCallbacks();
     void setEvtCallbacks();
     void processCollectives();
+    void finishWindow();
+    void selectTasks(const char * otf_file, OTFImportOptions * import_options);
+    void readPartners(const char * otf_file);
+    void addPartner(int sender, int receiver);
 
     bool enforceMessageSize;
+    bool windowed;
+    unsigned long long window_start;
+    unsigned long long window_end;
+    int stubcount;
 
     OTFImportOptions * options;
     OTF2_Reader * otfReader;
@@ -348,6 +392,8 @@ private:
     QMap<OTF2_CommRef, int> * commIndexMap;
     QMap<OTF2_RegionRef, int> * regionIndexMap;
     QMap<OTF2_LocationRef, int> * locationIndexMap;
+    QVector<int> * task_index; // rank to imported task, NULL for all tasks
+    QMap<int, QSet<int> > * partners;
 
     QVector<QLinkedList<CommRecord *> *> * unmatched_recvs;
     QVector<QLinkedList<CommRecord *> *> * unmatched_sends;
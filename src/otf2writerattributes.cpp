@@ -0,0 +1,53 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+//
+// This file is part of Ravel.
+// Written by Kate Isaacs, kisaacs@acm.org, All rights reserved.
+// LLNL-CODE-663885
+//
+// For details, see https://github.com/scalability-llnl/ravel
+// Please also see the LICENSE file for our notice and the LGPL.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (as published by
+// the Free Software Foundation) version 2.1 dated February 1999.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the IMPLIED WARRANTY OF
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the terms and
+// conditions of the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//////////////////////////////////////////////////////////////////////////////
+#include "otf2writerattributes.h"
+#include <QtAlgorithms>
+
+OTF2WriterAttributes::OTF2WriterAttributes(QMap<QString, int> * attributeMap,
+                                           QList<QString> * metrics)
+    : phase_id(attributeMap->value("phase")),
+      step_id(attributeMap->value("step")),
+      metric_names(QVector<QString>()),
+      metric_ids(QVector<OTF2_AttributeRef>()),
+      aggregate_ids(QVector<OTF2_AttributeRef>()),
+      attribute_list(OTF2_AttributeList_New())
+{
+    QList<QString> sorted = *metrics;
+    qSort(sorted);
+    for (QList<QString>::Iterator metric = sorted.begin();
+         metric != sorted.end(); ++metric)
+    {
+        if (!attributeMap->contains(*metric))
+            continue;
+        metric_names.append(*metric);
+        metric_ids.append(attributeMap->value(*metric));
+        aggregate_ids.append(attributeMap->value(*metric + "_agg"));
+    }
+}
+
+OTF2WriterAttributes::~OTF2WriterAttributes()
+{
+    OTF2_AttributeList_Delete(attribute_list);
+}
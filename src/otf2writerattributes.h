@@ -0,0 +1,56 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+//
+// This file is part of Ravel.
+// Written by Kate Isaacs, kisaacs@acm.org, All rights reserved.
+// LLNL-CODE-663885
+//
+// For details, see https://github.com/scalability-llnl/ravel
+// Please also see the LICENSE file for our notice and the LGPL.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (as published by
+// the Free Software Foundation) version 2.1 dated February 1999.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the IMPLIED WARRANTY OF
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the terms and
+// conditions of the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//////////////////////////////////////////////////////////////////////////////
+#ifndef OTF2WRITERATTRIBUTES_H
+#define OTF2WRITERATTRIBUTES_H
+
+#include <QVector>
+#include <QString>
+#include <QMap>
+#include <QList>
+#include <otf2/otf2.h>
+
+// Attribute ids for one OTF2 event writer, resolved once from the
+// exporter's attribute map, plus an attribute list reused by every
+// leave record the writer emits. Each writer gets its own so writers
+// can run on different threads.
+class OTF2WriterAttributes
+{
+public:
+    OTF2WriterAttributes(QMap<QString, int> * attributeMap,
+                         QList<QString> * metrics);
+    ~OTF2WriterAttributes();
+
+    OTF2_AttributeRef phase_id;
+    OTF2_AttributeRef step_id;
+
+    // Sorted by name to walk alongside CommEvent::metrics
+    QVector<QString> metric_names;
+    QVector<OTF2_AttributeRef> metric_ids;
+    QVector<OTF2_AttributeRef> aggregate_ids;
+
+    OTF2_AttributeList * attribute_list;
+};
+
+#endif // OTF2WRITERATTRIBUTES_H
@@ -23,7 +23,6 @@
 // Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 //////////////////////////////////////////////////////////////////////////////
 #include "otfconverter.h"
-#include <QElapsedTimer>
 #include <QStack>
 #include <QSet>
 #include <cmath>
@@ -47,6 +46,11 @@
 #include "p2pevent.h"
 #include "message.h"
 #include "collectiveevent.h"
+#include "packedcalls.h"
+#include "processingprofile.h"
+#include "task.h"
+#include "taskgroup.h"
+#include "otfcollective.h"
 
 
 const QString OTFConverter::collectives_string
@@ -56,7 +60,8 @@ const QString OTFConverter::collectives_string
       + QString("MPI_AllgathervMPI_GathervMPI_Scatterv");
 
 OTFConverter::OTFConverter()
-    : rawtrace(NULL), trace(NULL), options(NULL), phaseFunction(-1)
+    : rawtrace(NULL), trace(NULL), options(NULL), phaseFunction(-1),
+      profile(NULL), keep_rawtrace(false), collective_copies(NULL)
 {
 }
 
@@ -69,10 +74,13 @@ Trace * OTFConverter::importOTF(QString filename, OTFImportOptions *_options)
     // Keep track of options
     options = _options;
 
+    // The trace takes this over in convert()
+    profile = new ProcessingProfile();
+
     // Start with the rawtrace similar to what we got from PARAVER
     OTFImporter * importer = new OTFImporter();
     rawtrace = importer->importOTF(filename.toStdString().c_str(),
-                                   options->enforceMessageSizes);
+                                   options, profile);
     emit(finishRead());
 
     convert();
@@ -87,10 +95,13 @@ Trace * OTFConverter::importOTF2(QString filename, OTFImportOptions *_options)
     // Keep track of options
     options = _options;
 
+    // The trace takes this over in convert()
+    profile = new ProcessingProfile();
+
     // Start with the rawtrace similar to what we got from PARAVER
     OTF2Importer * importer = new OTF2Importer();
     rawtrace = importer->importOTF2(filename.toStdString().c_str(),
-                                    options->enforceMessageSizes);
+                                    options, profile);
     emit(finishRead());
 
     convert();
@@ -100,26 +111,55 @@ Trace * OTFConverter::importOTF2(QString filename, OTFImportOptions *_options)
     return trace;
 }
 
+// Run matching again over records kept from an earlier import. The base
+// is reset and reused, the definitions and collective records are always
+// copied for the new trace. The base is freed afterwards unless the
+// options still keep records.
+Trace * OTFConverter::reconvert(RawTrace * base, OTFImportOptions * _options)
+{
+    options = _options;
+    profile = new ProcessingProfile();
+    rawtrace = base;
+    rawtrace->resetMatching();
+    keep_rawtrace = options->keepsRecords();
+
+    convert();
+    return trace;
+}
+
 void OTFConverter::convert()
 {
     // Time the rest of this
-    QElapsedTimer traceTimer;
-    qint64 traceElapsed;
-    traceTimer.start();
+    ProfileScope scope(profile, "Event/Message Matching");
     trace = new Trace(rawtrace->num_tasks);
+    delete trace->profile;
+    trace->profile = profile;
     trace->units = rawtrace->second_magnitude;
 
-    // Start setting up new Trace
-    delete trace->functions;
-    trace->functions = rawtrace->functions;
-    delete trace->functionGroups;
-    trace->tasks = rawtrace->tasks;
-    trace->functionGroups = rawtrace->functionGroups;
-    trace->collectives = rawtrace->collectives;
-    trace->collectiveMap = rawtrace->collectiveMap;
+    // Saved traces are already matched, nothing to keep
+    if (rawtrace->options->origin == OTFImportOptions::OF_SAVE_OTF2)
+        keep_rawtrace = false;
 
-    trace->taskgroups = rawtrace->taskgroups;
-    trace->collective_definitions = rawtrace->collective_definitions;
+    // Start setting up new Trace. A base kept from an earlier import owns
+    // its definitions and frees them with itself, so the trace needs
+    // copies even when the base is not kept again.
+    if (keep_rawtrace || rawtrace->owns_definitions)
+    {
+        copyDefinitions();
+    }
+    else
+    {
+        delete trace->functions;
+        trace->functions = rawtrace->functions;
+        delete trace->functionGroups;
+        trace->tasks = rawtrace->tasks;
+        trace->functionGroups = rawtrace->functionGroups;
+        trace->collectives = rawtrace->collectives;
+        trace->collectiveMap = rawtrace->collectiveMap;
+
+        trace->taskgroups = rawtrace->taskgroups;
+        trace->collective_definitions = rawtrace->collective_definitions;
+    }
 
     // Find the MPI Group key
     for (QMap<int, QString>::Iterator fxnGroup = trace->functionGroups->begin();
@@ -191,13 +231,99 @@ void OTFConverter::convert()
         qSort((*cr)->events->begin(), (*cr)->events->end(), eventTaskLessThan);
     }
 
-    traceElapsed = traceTimer.nsecsElapsed();
-    std::cout << "Event/Message Matching: ";
-    gu_printTime(traceElapsed);
-    std::cout << std::endl;
+    int num_events = 0;
+    for (int i = 0; i < trace->num_tasks; i++)
+        num_events += trace->events->at(i)->size();
+    int num_messages = 0;
+    for (int i = 0; i < rawtrace->messages->size(); i++)
+        num_messages += rawtrace->messages->at(i)->size();
+    profile->setCounter("Tasks", trace->num_tasks);
+    profile->setCounter("Events", num_events);
+    profile->setCounter("Messages", num_messages);
+
+    // The trace holds on to the matched records so it can be reprocessed
+    if (keep_rawtrace)
+    {
+        rawtrace->owns_definitions = true;
+        trace->rawtrace = rawtrace;
+    }
+    else
+    {
+        delete rawtrace;
+    }
+    delete collective_copies;
+    collective_copies = NULL;
+}
 
+// Give the trace its own definitions so the kept rawtrace stays untouched
+void OTFConverter::copyDefinitions()
+{
+    for (QMap<int, Function *>::Iterator fxn = rawtrace->functions->begin();
+         fxn != rawtrace->functions->end(); ++fxn)
+    {
+        trace->functions->insert(fxn.key(), new Function(fxn.value()->name,
+                                                         fxn.value()->group));
+    }
+    *(trace->functionGroups) = *(rawtrace->functionGroups);
 
-    delete rawtrace;
+    trace->tasks = new QMap<int, Task *>();
+    for (QMap<int, Task *>::Iterator task = rawtrace->tasks->begin();
+         task != rawtrace->tasks->end(); ++task)
+    {
+        trace->tasks->insert(task.key(), new Task(task.value()->id,
+                                                  task.value()->name));
+    }
+
+    trace->taskgroups = new QMap<int, TaskGroup *>();
+    for (QMap<int, TaskGroup *>::Iterator tg = rawtrace->taskgroups->begin();
+         tg != rawtrace->taskgroups->end(); ++tg)
+    {
+        TaskGroup * group = new TaskGroup(tg.value()->id, tg.value()->name);
+        *(group->tasks) = *(tg.value()->tasks);
+        *(group->taskorder) = *(tg.value()->taskorder);
+        trace->taskgroups->insert(tg.key(), group);
+    }
+
+    trace->collective_definitions = new QMap<int, OTFCollective *>();
+    for (QMap<int, OTFCollective *>::Iterator def
+         = rawtrace->collective_definitions->begin();
+         def != rawtrace->collective_definitions->end(); ++def)
+    {
+        trace->collective_definitions->insert(def.key(),
+                                              new OTFCollective(def.value()->id,
+                                                                def.value()->type,
+                                                                def.value()->name));
+    }
+
+    // Collective records gather events, so each trace needs new ones
+    collective_copies = new QMap<CollectiveRecord *, CollectiveRecord *>();
+    trace->collectives = new QMap<unsigned long long, CollectiveRecord *>();
+    for (QMap<unsigned long long, CollectiveRecord *>::Iterator cr
+         = rawtrace->collectives->begin();
+         cr != rawtrace->collectives->end(); ++cr)
+    {
+        CollectiveRecord * copy = new CollectiveRecord(cr.value()->matchingId,
+                                                       cr.value()->root,
+                                                       cr.value()->collective,
+                                                       cr.value()->taskgroup);
+        trace->collectives->insert(cr.key(), copy);
+        collective_copies->insert(cr.value(), copy);
+    }
+
+    trace->collectiveMap = new QVector<QMap<unsigned long long, CollectiveRecord *> *>();
+    for (int i = 0; i < rawtrace->collectiveMap->size(); i++)
+    {
+        QMap<unsigned long long, CollectiveRecord *> * task_map
+                = new QMap<unsigned long long, CollectiveRecord *>();
+        QMap<unsigned long long, CollectiveRecord *> * raw_map
+                = rawtrace->collectiveMap->at(i);
+        for (QMap<unsigned long long, CollectiveRecord *>::Iterator cr
+             = raw_map->begin(); cr != raw_map->end(); ++cr)
+        {
+            task_map->insert(cr.key(), collective_copies->value(cr.value()));
+        }
+        trace->collectiveMap->append(task_map);
+    }
 }
 
 void OTFConverter::makeSingletonPartition(CommEvent * evt)
@@ -211,6 +337,73 @@ void OTFConverter::makeSingletonPartition(CommEvent * evt)
 
 // Determine events as blocks of matching enter and exit,
 // link them into a call tree
+// The run of calls waiting at depth, packed from its records. A lone call
+// with nothing below is made an Event instead as packing would not save
+// anything. Either way it goes in the task's events, which own it.
+Event * OTFConverter::takeRun(QVector<EventRecord *> * event_list,
+                              QVector<int> * run_first,
+                              QVector<int> * run_last, int depth)
+{
+    if (depth >= run_first->size() || run_first->at(depth) < 0)
+        return NULL;
+
+    int first = run_first->at(depth);
+    int last = run_last->at(depth);
+    (*run_first)[depth] = -1;
+
+    EventRecord * bgn = event_list->at(first);
+    Event * run = NULL;
+    if (last == first + 1)
+    {
+        run = new Event(bgn->time, event_list->at(last)->time, bgn->value,
+                        bgn->task);
+        run->depth = depth;
+    }
+    else
+    {
+        run = packRecords(event_list, first, last, depth);
+    }
+    (*(trace->events))[bgn->task]->append(run);
+    return run;
+}
+
+// Calls are packed in the order they enter, but their exits are only
+// known once the whole run is read
+PackedCalls * OTFConverter::packRecords(QVector<EventRecord *> * event_list,
+                                        int first, int last, int depth)
+{
+    QVector<PackedCalls::Call> calls = QVector<PackedCalls::Call>();
+    QStack<int> open = QStack<int>();
+    for (int i = first; i <= last; ++i)
+    {
+        EventRecord * record = event_list->at(i);
+        if (record->enter)
+        {
+            PackedCalls::Call call = PackedCalls::Call();
+            call.enter = record->time;
+            call.exit = record->time;
+            call.function = record->value;
+            call.depth = depth + open.size();
+            open.push(calls.size());
+            calls.append(call);
+        }
+        else if (!open.isEmpty())
+        {
+            calls[open.pop()].exit = record->time;
+        }
+    }
+
+    PackedCalls * packed = new PackedCalls(NULL, event_list->at(first)->task,
+                                           depth);
+    for (QVector<PackedCalls::Call>::Iterator call = calls.begin();
+         call != calls.end(); ++call)
+    {
+        packed->appendCall(call->enter, call->exit, call->function,
+                           call->depth);
+    }
+    return packed;
+}
+
 void OTFConverter::matchEvents()
 {
     // We can handle each set of events separately
@@ -219,6 +412,13 @@ void OTFConverter::matchEvents()
     // Keep track of how many commsbelow we have at each depth
     QMap<int, int> commsbelow = QMap<int, int>();
 
+    // When packing call trees, calls with no comms below are not made into
+    // Events. Each depth keeps the record span of its latest run of them
+    // until a caller or sibling that is kept needs it packed.
+    QStack<int> begins = QStack<int>();
+    QVector<int> run_first = QVector<int>();
+    QVector<int> run_last = QVector<int>();
+
     // Keep track of the counters at that time
     QStack<CounterRecord *> * counterstack = new QStack<CounterRecord *>();
     QMap<unsigned int, CounterRecord *> * lastcounters = new QMap<unsigned int, CounterRecord *>();
@@ -298,12 +498,14 @@ void OTFConverter::matchEvents()
         QList<P2PEvent *> * isends = new QList<P2PEvent *>();
         int sindex = 0, rindex = 0;
         CommEvent * prev = NULL;
+        run_first.fill(-1);
         for (QVector<EventRecord *>::Iterator evt = event_list->begin();
              evt != event_list->end(); ++evt)
         {
             if (!((*evt)->enter)) // End of a subroutine
             {
                 EventRecord * bgn = stack->pop();
+                int bgn_index = begins.pop();
 
                 // This is definitely not an isend, so finish coalescing any pending isends
                 if (options->isendCoalescing && bgn->value != isend_index && isends->size() > 0)
@@ -341,6 +543,8 @@ void OTFConverter::matchEvents()
                             && (*evt)->time >= collective_bits->at(collective_index)->time)
                     {
                         cr = collective_bits->at(collective_index)->cr;
+                        if (collective_copies)
+                            cr = collective_copies->value(cr);
                         collective_index++;
                     }
 
@@ -424,7 +628,10 @@ void OTFConverter::matchEvents()
                 {
                     QVector<Message *> * msgs = new QVector<Message *>();
                     CommRecord * crec = sendlist->at(sindex);
-                    if (!(crec->message))
+
+                    // Sends to a task outside an imported subset stay as
+                    // a send with no message so stepping still sees them
+                    if (!(crec->message) && !crec->stub)
                     {
                         crec->message = new Message(crec->send_time,
                                                     crec->recv_time,
@@ -434,31 +641,34 @@ void OTFConverter::matchEvents()
                     }
                     if (crec->send_complete > max_complete)
                         max_complete = crec->send_complete;
-                    msgs->append(crec->message);
-                    crec->message->sender = new P2PEvent(bgn->time, (*evt)->time,
+                    if (crec->message)
+                        msgs->append(crec->message);
+                    P2PEvent * send_event = new P2PEvent(bgn->time, (*evt)->time,
                                                          bgn->value,
                                                          bgn->task, phase,
                                                          msgs);
+                    if (crec->message)
+                        crec->message->sender = send_event;
 
                     if (isendflag)
-                        isends->append(crec->message->sender);
+                        isends->append(send_event);
 
 
-                    crec->message->sender->comm_prev = prev;
+                    send_event->comm_prev = prev;
                     if (prev)
-                        prev->comm_next = crec->message->sender;
-                    prev = crec->message->sender;
+                        prev->comm_next = send_event;
+                    prev = send_event;
 
-                    counter_index = advanceCounters(crec->message->sender,
+                    counter_index = advanceCounters(send_event,
                                                     counterstack,
                                                     counters, counter_index,
                                                     lastcounters);
 
-                    e = crec->message->sender;
+                    e = send_event;
                     if (options->partitionByFunction)
-                        commevents->append(crec->message->sender);
+                        commevents->append(send_event);
                     else if (!(options->isendCoalescing && isendflag))
-                        makeSingletonPartition(crec->message->sender);
+                        makeSingletonPartition(send_event);
                     sindex++;
 
                     spartcounter++;
@@ -481,6 +691,12 @@ void OTFConverter::matchEvents()
                            && bgn->time <= recvlist->at(rindex)->recv_time)
                     {
                         crec = recvlist->at(rindex);
+                        rindex++;
+
+                        // Receives from outside an imported subset add
+                        // no message, the receive may end up with none
+                        if (crec->stub)
+                            continue;
                         if (!(crec->message))
                         {
                             crec->message = new Message(crec->send_time,
@@ -490,38 +706,37 @@ void OTFConverter::matchEvents()
                             crec->message->size = crec->size;
                         }
                         msgs->append(crec->message);
-                        rindex++;
                     }
-                    msgs->at(0)->receiver = new P2PEvent(bgn->time, (*evt)->time,
+                    P2PEvent * recv_event = new P2PEvent(bgn->time, (*evt)->time,
                                                          bgn->value,
                                                          bgn->task, phase,
                                                          msgs);
-                    for (int i = 1; i < msgs->size(); i++)
+                    for (int i = 0; i < msgs->size(); i++)
                     {
-                        msgs->at(i)->receiver = msgs->at(0)->receiver;
+                        msgs->at(i)->receiver = recv_event;
                     }
-                    msgs->at(0)->receiver->is_recv = true;
+                    recv_event->is_recv = true;
 
-                    msgs->at(0)->receiver->comm_prev = prev;
+                    recv_event->comm_prev = prev;
                     if (prev)
-                        prev->comm_next = msgs->at(0)->receiver;
-                    prev = msgs->at(0)->receiver;
+                        prev->comm_next = recv_event;
+                    prev = recv_event;
 
                     if (options->partitionByFunction)
-                        commevents->append(msgs->at(0)->receiver);
+                        commevents->append(recv_event);
                     else
-                        makeSingletonPartition(msgs->at(0)->receiver);
+                        makeSingletonPartition(recv_event);
 
                     rpartcounter++;
 
                     commsbelow.insert(depth, commsbelow.value(depth) + 1); // + msgs->size() ?
 
-                    counter_index = advanceCounters(msgs->at(0)->receiver,
+                    counter_index = advanceCounters(recv_event,
                                                     counterstack,
                                                     counters, counter_index,
                                                     lastcounters);
 
-                    e = msgs->at(0)->receiver;
+                    e = recv_event;
 
                     if (!options->partitionByFunction)
                     {
@@ -559,8 +774,12 @@ void OTFConverter::matchEvents()
                 }
                 else // Non-com event
                 {
-                    e = new Event(bgn->time, (*evt)->time, bgn->value,
-                                  bgn->task);
+                    if (!options->compactCallTrees
+                        || commsbelow.value(depth+1) > 0)
+                    {
+                        e = new Event(bgn->time, (*evt)->time, bgn->value,
+                                      bgn->task);
+                    }
 
                     // Stop by Waitall/Testall
                     if (!options->partitionByFunction)
@@ -569,7 +788,7 @@ void OTFConverter::matchEvents()
                         if (max_complete > 0)
                         {
                             // This contains the max complete time, end the group
-                            if (e->enter <= max_complete && e->exit >= max_complete
+                            if (bgn->time <= max_complete && (*evt)->time >= max_complete
                                     && sendgroup->size() > 0)
                             {
                                 waitallgroups->append(sendgroup);
@@ -608,14 +827,42 @@ void OTFConverter::matchEvents()
                 }
 
                 depth--;
+                if ((*evt)->time > endtime)
+                    endtime = (*evt)->time;
+
+                // Left to be packed with its siblings, anything waiting
+                // below it is part of it
+                if (!e)
+                {
+                    while (run_first.size() < depth + 2)
+                    {
+                        run_first.append(-1);
+                        run_last.append(-1);
+                    }
+                    if (run_first[depth] < 0)
+                        run_first[depth] = bgn_index;
+                    run_last[depth] = evt - event_list->begin();
+                    run_first[depth + 1] = -1;
+                    continue;
+                }
+
+                Event * run = takeRun(event_list, &run_first, &run_last,
+                                      depth);
+                Event * inner = takeRun(event_list, &run_first, &run_last,
+                                        depth + 1);
+                if (inner)
+                    bgn->children.append(inner);
+
                 e->depth = depth;
+                if (depth == 0 && run)
+                    (*(trace->roots))[(*evt)->task]->append(run);
                 if (depth == 0 && !isendflag)
                     (*(trace->roots))[(*evt)->task]->append(e);
 
-                if (e->exit > endtime)
-                    endtime = e->exit;
                 if (!stack->isEmpty())
                 {
+                    if (run)
+                        stack->top()->children.append(run);
                     stack->top()->children.append(e);
                 }
                 for (QList<Event *>::Iterator child = bgn->children.begin();
@@ -648,6 +895,7 @@ void OTFConverter::matchEvents()
                 }
                 depth++;
                 stack->push(*evt);
+                begins.push(evt - event_list->begin());
                 while (counters->size() > counter_index
                        && counters->at(counter_index)->time == (*evt)->time)
                 {
@@ -684,6 +932,10 @@ void OTFConverter::matchEvents()
             delete isends;
         }
 
+        Event * run = takeRun(event_list, &run_first, &run_last, 0);
+        if (run)
+            (*(trace->roots))[run->task]->append(run);
+
         // Deal with unclosed trace issues
         // We assume these events are not communication
         while (!stack->isEmpty())
@@ -692,8 +944,16 @@ void OTFConverter::matchEvents()
             endtime = std::max(endtime, bgn->time);
             Event * e = new Event(bgn->time, endtime, bgn->value,
                           bgn->task);
+            Event * inner = takeRun(event_list, &run_first, &run_last, depth);
+            if (inner)
+                bgn->children.append(inner);
             if (!stack->isEmpty())
             {
+                // Siblings packed before it keep their place ahead of it
+                Event * run = takeRun(event_list, &run_first, &run_last,
+                                      depth - 1);
+                if (run)
+                    stack->top()->children.append(run);
                 stack->top()->children.append(e);
             }
             for (QList<Event *>::Iterator child = bgn->children.begin();
@@ -708,6 +968,7 @@ void OTFConverter::matchEvents()
 
         // Prepare for next task
         stack->clear();
+        begins.clear();
         sendgroup->clear();
     }
     delete stack;
@@ -29,16 +29,21 @@
 #include <QString>
 #include <QMap>
 #include <QStack>
+#include <QVector>
 
 class RawTrace;
 class OTFImporter;
 class OTF2Importer;
 class OTFImportOptions;
 class Trace;
+class ProcessingProfile;
 class Partition;
+class Event;
 class CommEvent;
+class PackedCalls;
 class CounterRecord;
 class EventRecord;
+class CollectiveRecord;
 
 // Uses the raw records read from the OTF:
 // - switches point events into durational events
@@ -53,13 +58,25 @@ public:
     Trace * importOTF(QString filename, OTFImportOptions * _options);
     Trace * importOTF2(QString filename, OTFImportOptions * _options);
 
+    // Keep the raw records on the trace so it can be reprocessed
+    void setKeepRawTrace(bool keep) { keep_rawtrace = keep; }
+    // New unprocessed trace from the raw records kept by an earlier one,
+    // which takes them over
+    Trace * reconvert(RawTrace * base, OTFImportOptions * _options);
+
 signals:
     void finishRead();
     void matchingUpdate(int, QString);
 
 private:
     void convert();
+    void copyDefinitions();
     void matchEvents();
+    Event * takeRun(QVector<EventRecord *> * event_list,
+                    QVector<int> * run_first, QVector<int> * run_last,
+                    int depth);
+    PackedCalls * packRecords(QVector<EventRecord *> * event_list,
+                              int first, int last, int depth);
     void matchEventsSaved();
     void makeSingletonPartition(CommEvent * evt);
     void addToSavedPartition(CommEvent * evt, int partition);
@@ -73,6 +90,9 @@ private:
     Trace * trace;
     OTFImportOptions * options;
     int phaseFunction;
+    ProcessingProfile * profile; // Handed to the trace once it exists
+    bool keep_rawtrace;
+    QMap<CollectiveRecord *, CollectiveRecord *> * collective_copies;
 
     static const int event_match_portion = 24;
     static const int message_match_portion = 0;
@@ -24,9 +24,10 @@
 //////////////////////////////////////////////////////////////////////////////
 #include "otfimporter.h"
 #include <QString>
-#include <QElapsedTimer>
+#include "processingprofile.h"
 #include <iostream>
 #include <cmath>
+#include <climits>
 #include "general_util.h"
 #include "task.h"
 #include "rawtrace.h"
@@ -38,6 +39,7 @@
 #include "counterrecord.h"
 #include "taskgroup.h"
 #include "otfcollective.h"
+#include "otfimportoptions.h"
 #include "otf.h"
 
 OTFImporter::OTFImporter()
@@ -50,11 +52,18 @@ OTFImporter::OTFImporter()
       sendcount(0),
       recvcount(0),
       enforceMessageSize(false),
+      windowed(false),
+      window_anchored(false),
+      window_start(0),
+      window_end(ULLONG_MAX),
+      stubcount(0),
       fileManager(NULL),
       otfReader(NULL),
       handlerArray(NULL),
       unmatched_recvs(new QVector<QLinkedList<CommRecord *> *>()),
       unmatched_sends(new QVector<QLinkedList<CommRecord *> *>()),
+      task_index(NULL),
+      partners(NULL),
       rawtrace(NULL),
       tasks(NULL),
       functionGroups(NULL),
@@ -100,20 +109,22 @@ OTFImporter::~OTFImporter()
         *eitr = NULL;
     }
     delete unmatched_sends;
+
+    delete task_index;
+    delete partners;
 }
 
-RawTrace * OTFImporter::importOTF(const char* otf_file, bool _enforceMessageSize)
+RawTrace * OTFImporter::importOTF(const char* otf_file,
+                                  OTFImportOptions * import_options,
+                                  ProcessingProfile * profile)
 {
-    enforceMessageSize = _enforceMessageSize;
+    enforceMessageSize = import_options->enforceMessageSizes;
     entercount = 0;
     exitcount = 0;
     sendcount = 0;
     recvcount = 0;
 
-    QElapsedTimer traceTimer;
-    qint64 traceElapsed;
-
-    traceTimer.start();
+    ProfileScope scope(profile, "OTF Reading");
 
     fileManager = OTF_FileManager_open(1);
     otfReader = OTF_Reader_open(otf_file, fileManager);
@@ -132,6 +143,21 @@ RawTrace * OTFImporter::importOTF(const char* otf_file, bool _enforceMessageSize
     std::cout << "Reading definitions" << std::endl;
     OTF_Reader_readDefinitions(otfReader, handlerArray);
 
+    // Window in converted time units, relative until the first event.
+    // OTF_Reader_setTimeInterval would hide the sends before the window
+    // that receives inside it must match, so filtering is done here.
+    windowed = import_options->timeWindow;
+    if (windowed)
+    {
+        double scale = pow(10, second_magnitude);
+        window_start = import_options->windowStart * scale;
+        if (import_options->windowEnd > import_options->windowStart)
+            window_end = import_options->windowEnd * scale;
+    }
+
+    if (import_options->taskSubset)
+        selectTasks(otf_file, import_options);
+
     rawtrace = new RawTrace(num_processes);
     rawtrace->tasks = tasks;
     rawtrace->second_magnitude = second_magnitude;
@@ -170,6 +196,14 @@ RawTrace * OTFImporter::importOTF(const char* otf_file, bool _enforceMessageSize
 
     rawtrace->collectiveMap = collectiveMap;
 
+    if (windowed)
+    {
+        finishWindow();
+        int truncated = rawtrace->clipToWindow(window_start, window_end);
+        if (profile)
+            profile->setCounter("Truncated messages", truncated);
+    }
+
     OTF_HandlerArray_close(handlerArray);
     OTF_Reader_close(otfReader);
     OTF_FileManager_close(fileManager);
@@ -206,11 +240,16 @@ RawTrace * OTFImporter::importOTF(const char* otf_file, bool _enforceMessageSize
     std::cout << unmatched_send_count << " unmatched sends and "
               << unmatched_recv_count << " unmatched recvs." << std::endl;
 
-
-    traceElapsed = traceTimer.nsecsElapsed();
-    std::cout << "OTF Reading: ";
-    gu_printTime(traceElapsed);
-    std::cout << std::endl;
+    if (profile)
+    {
+        profile->setCounter("Unmatched sends", unmatched_send_count);
+        profile->setCounter("Unmatched receives", unmatched_recv_count);
+        if (task_index)
+        {
+            profile->setCounter("Selected tasks", num_processes);
+            profile->setCounter("Boundary messages", stubcount);
+        }
+    }
 
     return rawtrace;
 }
@@ -319,6 +358,200 @@ uint64_t OTFImporter::convertTime(void* userData, uint64_t time)
             * ((OTFImporter *) userData)->time_conversion_factor;
 }
 
+int OTFImporter::windowPosition(void * userData, unsigned long long time)
+{
+    OTFImporter * importer = (OTFImporter *) userData;
+    if (!importer->windowed)
+        return 0;
+
+    // Events arrive in time order, so the first one is the trace start
+    if (!importer->window_anchored)
+    {
+        importer->window_start += time;
+        if (importer->window_end < ULLONG_MAX - time)
+            importer->window_end += time;
+        importer->window_anchored = true;
+    }
+
+    if (time < importer->window_start)
+        return -1;
+    if (time > importer->window_end)
+        return 1;
+    return 0;
+}
+
+CommRecord * OTFImporter::windowMatch(void * userData, CommRecord * cr)
+{
+    bool send_out = windowPosition(userData, cr->send_time) < 0;
+    bool recv_out = windowPosition(userData, cr->recv_time) < 0;
+    if (send_out && recv_out)
+    {
+        delete cr;
+        return NULL;
+    }
+    if (send_out || recv_out)
+        cr->truncated = true;
+    return cr;
+}
+
+// Messages still unmatched lost their other end past the window. The ones
+// with neither end inside are not in the raw trace and go now, the rest
+// are marked for RawTrace::clipToWindow to remove.
+void OTFImporter::finishWindow()
+{
+    for (int i = 0; i < num_processes; i++)
+    {
+        for (QLinkedList<CommRecord *>::Iterator cr = (*unmatched_sends)[i]->begin();
+             cr != (*unmatched_sends)[i]->end(); ++cr)
+        {
+            if (windowPosition(this, (*cr)->send_time) < 0)
+                delete *cr;
+            else
+                (*cr)->truncated = true;
+        }
+        (*unmatched_sends)[i]->clear();
+
+        for (QLinkedList<CommRecord *>::Iterator cr = (*unmatched_recvs)[i]->begin();
+             cr != (*unmatched_recvs)[i]->end(); ++cr)
+        {
+            if (windowPosition(this, (*cr)->recv_time) < 0)
+                delete *cr;
+            else
+                (*cr)->truncated = true;
+        }
+        (*unmatched_recvs)[i]->clear();
+    }
+}
+
+int OTFImporter::taskIndex(void * userData, int rank)
+{
+    QVector<int> * task_index = ((OTFImporter *) userData)->task_index;
+    if (!task_index)
+        return rank;
+    if (rank < 0 || rank >= task_index->size())
+        return -1;
+    return task_index->at(rank);
+}
+
+void OTFImporter::addStub(void * userData, CommRecord * cr, bool send)
+{
+    RawTrace * rawtrace = ((OTFImporter *) userData)->rawtrace;
+    cr->stub = true;
+    if (send)
+        (*(rawtrace->messages))[cr->sender]->append(cr);
+    else
+        (*(rawtrace->messages_r))[cr->receiver]->append(cr);
+    ((OTFImporter *) userData)->stubcount++;
+}
+
+// Narrow the import to the tasks named in the options and, if asked, their
+// message partners. The kept tasks are renumbered from zero in rank order
+// and only their streams are read.
+void OTFImporter::selectTasks(const char * otf_file,
+                              OTFImportOptions * import_options)
+{
+    QSet<int> selected = RawTrace::parseTaskFilter(import_options->taskFilter,
+                                                   tasks, taskgroups);
+    if (selected.isEmpty())
+    {
+        std::cout << "No tasks match " << import_options->taskFilter.toStdString()
+                  << ", reading all tasks" << std::endl;
+        return;
+    }
+
+    if (import_options->taskHops > 0)
+    {
+        readPartners(otf_file);
+        RawTrace::addPartnerHops(selected, partners, import_options->taskHops);
+    }
+
+    task_index = new QVector<int>(tasks->isEmpty() ? 0 : tasks->lastKey() + 1, -1);
+    QMap<int, Task *> * subset = new QMap<int, Task *>();
+    OTF_Reader_setProcessStatusAll(otfReader, 0);
+    for (QMap<int, Task *>::Iterator task = tasks->begin();
+         task != tasks->end(); ++task)
+    {
+        if (selected.contains(task.key()))
+        {
+            int index = subset->size();
+            (*task_index)[task.key()] = index;
+            task.value()->id = index;
+            subset->insert(index, task.value());
+            OTF_Reader_setProcessStatus(otfReader, task.key() + 1, 1);
+        }
+        else
+        {
+            delete task.value();
+        }
+    }
+    delete tasks;
+    tasks = subset;
+    num_processes = tasks->size();
+
+    // Communicators keep their rank order for the members we have
+    for (QMap<int, TaskGroup *>::Iterator tg = taskgroups->begin();
+         tg != taskgroups->end(); ++tg)
+    {
+        TaskGroup * t = tg.value();
+        QList<unsigned int> * members = new QList<unsigned int>();
+        t->taskorder->clear();
+        for (int i = 0; i < t->tasks->size(); i++)
+        {
+            int index = taskIndex(this, t->tasks->at(i));
+            if (index >= 0)
+            {
+                members->append(index);
+                t->taskorder->insert(index, i);
+            }
+        }
+        delete t->tasks;
+        t->tasks = members;
+    }
+
+    std::cout << "Reading " << num_processes << " of " << task_index->size()
+              << " tasks" << std::endl;
+}
+
+// Cheap first pass over only the send records of every stream to find the
+// message partners of each task
+void OTFImporter::readPartners(const char * otf_file)
+{
+    partners = new QMap<int, QSet<int> >();
+
+    std::cout << "Reading message partners" << std::endl;
+    OTF_Reader * reader = OTF_Reader_open(otf_file, fileManager);
+    OTF_HandlerArray * handlers = OTF_HandlerArray_open();
+    OTF_HandlerArray_setHandler(handlers,
+                                (OTF_FunctionPointer*) &OTFImporter::handlePartnerSend,
+                                OTF_SEND_RECORD);
+    OTF_HandlerArray_setFirstHandlerArg(handlers, this, OTF_SEND_RECORD);
+    OTF_Reader_readEvents(reader, handlers);
+    OTF_HandlerArray_close(handlers);
+    OTF_Reader_close(reader);
+}
+
+void OTFImporter::addPartner(int sender, int receiver)
+{
+    (*partners)[sender].insert(receiver);
+    (*partners)[receiver].insert(sender);
+}
+
+// Partners are collected over the whole run, the window does not apply
+int OTFImporter::handlePartnerSend(void * userData, uint64_t time,
+                                   uint32_t sender, uint32_t receiver,
+                                   uint32_t group, uint32_t type,
+                                   uint32_t length, uint32_t source)
+{
+    Q_UNUSED(time);
+    Q_UNUSED(group);
+    Q_UNUSED(type);
+    Q_UNUSED(length);
+    Q_UNUSED(source);
+
+    ((OTFImporter *) userData)->addPartner(sender - 1, receiver - 1);
+    return 0;
+}
+
 int OTFImporter::handleDefTimerResolution(void* userData, uint32_t stream,
                                           uint64_t ticksPerSecond)
 {
@@ -390,11 +623,21 @@ int OTFImporter::handleEnter(void * userData, uint64_t time, uint32_t function,
                              uint32_t process, uint32_t source)
 {
     Q_UNUSED(source);
-    ((*((((OTFImporter*) userData)->rawtrace)->events))[process - 1])->append(new EventRecord(process - 1,
-                                                                                              convertTime(userData,
-                                                                                                          time),
-                                                                                              function,
-                                                                                              true));
+    time = convertTime(userData, time);
+    int window = windowPosition(userData, time);
+    if (window > 0) // Events are in time order, nothing more to read
+        return OTF_RETURN_ABORT;
+    else if (window < 0)
+        return 0;
+
+    int task = taskIndex(userData, process - 1);
+    if (task < 0)
+        return 0;
+
+    ((*((((OTFImporter*) userData)->rawtrace)->events))[task])->append(new EventRecord(task,
+                                                                                       time,
+                                                                                       function,
+                                                                                       true));
     return 0;
 }
 
@@ -402,11 +645,21 @@ int OTFImporter::handleLeave(void * userData, uint64_t time, uint32_t function,
                              uint32_t process, uint32_t source)
 {
     Q_UNUSED(source);
-    ((*((((OTFImporter*) userData)->rawtrace)->events))[process - 1])->append(new EventRecord(process - 1,
-                                                                                              convertTime(userData,
-                                                                                                          time),
-                                                                                              function,
-                                                                                              false));
+    time = convertTime(userData, time);
+    int window = windowPosition(userData, time);
+    if (window > 0)
+        return OTF_RETURN_ABORT;
+    else if (window < 0)
+        return 0;
+
+    int task = taskIndex(userData, process - 1);
+    if (task < 0)
+        return 0;
+
+    ((*((((OTFImporter*) userData)->rawtrace)->events))[task])->append(new EventRecord(task,
+                                                                                       time,
+                                                                                       function,
+                                                                                       false));
     return 0;
 }
 
@@ -442,18 +695,36 @@ int OTFImporter::handleSend(void * userData, uint64_t time, uint32_t sender,
     // Every time we find a send, check the unmatched recvs
     // to see if it has a match
     time = convertTime(userData, time);
+    int window = windowPosition(userData, time);
+    if (window > 0)
+        return OTF_RETURN_ABORT;
+
+    int sender_task = taskIndex(userData, sender - 1);
+    int receiver_task = taskIndex(userData, receiver - 1);
+    if (sender_task < 0)
+        return 0;
+    if (receiver_task < 0)
+    {
+        if (window == 0)
+            addStub(userData, new CommRecord(sender_task, time, receiver - 1, 0,
+                                             length, type, group),
+                    true);
+        return 0;
+    }
+
+    // Sends before the window are still matched so the receives inside it
+    // pair up correctly, but they are not kept
     CommRecord * cr = NULL;
-    QLinkedList<CommRecord *> * unmatched = (*(((OTFImporter *) userData)->unmatched_recvs))[sender - 1];
+    QLinkedList<CommRecord *> * unmatched = (*(((OTFImporter *) userData)->unmatched_recvs))[sender_task];
     bool useSize = ((OTFImporter *) userData)->enforceMessageSize;
     for (QLinkedList<CommRecord *>::Iterator itr = unmatched->begin();
          itr != unmatched->end(); ++itr)
     {
-        if (useSize ? OTFImporter::compareComms((*itr), sender, receiver, type, length)
-                    : OTFImporter::compareComms((*itr), sender, receiver, type))
+        if (useSize ? OTFImporter::compareComms((*itr), sender_task, receiver_task, type, length)
+                    : OTFImporter::compareComms((*itr), sender_task, receiver_task, type))
         {
             cr = *itr;
             cr->send_time = time;
-            ((*((((OTFImporter*) userData)->rawtrace)->messages))[sender - 1])->append((cr));
             break;
         }
     }
@@ -463,13 +734,17 @@ int OTFImporter::handleSend(void * userData, uint64_t time, uint32_t sender,
     // Otherwise, create a new unmatched send record
     if (cr)
     {
-        (*(((OTFImporter *) userData)->unmatched_recvs))[sender - 1]->removeOne(cr);
+        (*(((OTFImporter *) userData)->unmatched_recvs))[sender_task]->removeOne(cr);
+        if (window == 0)
+            ((*((((OTFImporter*) userData)->rawtrace)->messages))[sender_task])->append((cr));
+        windowMatch(userData, cr);
     }
     else
     {
-        cr = new CommRecord(sender - 1, time, receiver - 1, 0, length, type, group);
-        (*((((OTFImporter*) userData)->rawtrace)->messages))[sender - 1]->append(cr);
-        (*(((OTFImporter *) userData)->unmatched_sends))[sender - 1]->append(cr);
+        cr = new CommRecord(sender_task, time, receiver_task, 0, length, type, group);
+        if (window == 0)
+            (*((((OTFImporter*) userData)->rawtrace)->messages))[sender_task]->append(cr);
+        (*(((OTFImporter *) userData)->unmatched_sends))[sender_task]->append(cr);
     }
     return 0;
 }
@@ -483,14 +758,31 @@ int OTFImporter::handleRecv(void * userData, uint64_t time, uint32_t receiver,
 
     // Look for match in unmatched_sends
     time = convertTime(userData, time);
+    int window = windowPosition(userData, time);
+    if (window > 0)
+        return OTF_RETURN_ABORT;
+
+    int sender_task = taskIndex(userData, sender - 1);
+    int receiver_task = taskIndex(userData, receiver - 1);
+    if (receiver_task < 0)
+        return 0;
+    if (sender_task < 0)
+    {
+        if (window == 0)
+            addStub(userData, new CommRecord(sender - 1, 0, receiver_task, time,
+                                             length, type, group),
+                    false);
+        return 0;
+    }
+
     CommRecord * cr = NULL;
-    QLinkedList<CommRecord *> * unmatched = (*(((OTFImporter*) userData)->unmatched_sends))[sender - 1];
+    QLinkedList<CommRecord *> * unmatched = (*(((OTFImporter*) userData)->unmatched_sends))[sender_task];
     bool useSize = ((OTFImporter *) userData)->enforceMessageSize;
     for (QLinkedList<CommRecord *>::Iterator itr = unmatched->begin();
          itr != unmatched->end(); ++itr)
     {
-        if (useSize ? OTFImporter::compareComms((*itr), sender -1, receiver -1, type, length)
-                    : OTFImporter::compareComms((*itr), sender -1, receiver -1, type))
+        if (useSize ? OTFImporter::compareComms((*itr), sender_task, receiver_task, type, length)
+                    : OTFImporter::compareComms((*itr), sender_task, receiver_task, type))
         {
             cr = *itr;
             cr->recv_time = time;
@@ -502,14 +794,16 @@ int OTFImporter::handleRecv(void * userData, uint64_t time, uint32_t receiver,
     // a new unmatched recv record
     if (cr)
     {
-        (*(((OTFImporter *) userData)->unmatched_sends))[sender - 1]->removeOne(cr);
+        (*(((OTFImporter *) userData)->unmatched_sends))[sender_task]->removeOne(cr);
+        cr = windowMatch(userData, cr);
     }
     else
     {
-        cr = new CommRecord(sender - 1, 0, receiver - 1, time, length, type, group);
-        ((*(((OTFImporter*) userData)->unmatched_recvs))[sender - 1])->append(cr);
+        cr = new CommRecord(sender_task, 0, receiver_task, time, length, type, group);
+        ((*(((OTFImporter*) userData)->unmatched_recvs))[sender_task])->append(cr);
     }
-    (*((((OTFImporter*) userData)->rawtrace)->messages_r))[receiver - 1]->append(cr);
+    if (cr && window == 0)
+        (*((((OTFImporter*) userData)->rawtrace)->messages_r))[receiver_task]->append(cr);
 
     return 0;
 }
@@ -518,8 +812,19 @@ int OTFImporter::handleCounter(void * userData, uint64_t time,
                                uint32_t process, uint32_t counter,
                                uint64_t value)
 {
-    CounterRecord * cr = new CounterRecord(counter, convertTime(userData, time), value);
-    (*((((OTFImporter *) userData)->rawtrace)->counter_records))[process - 1]->append(cr);
+    time = convertTime(userData, time);
+    int window = windowPosition(userData, time);
+    if (window > 0)
+        return OTF_RETURN_ABORT;
+    else if (window < 0)
+        return 0;
+
+    int task = taskIndex(userData, process - 1);
+    if (task < 0)
+        return 0;
+
+    CounterRecord * cr = new CounterRecord(counter, time, value);
+    (*((((OTFImporter *) userData)->rawtrace)->counter_records))[task]->append(cr);
     return 0;
 }
 
@@ -594,9 +899,21 @@ int OTFImporter::handleBeginCollectiveOperation(void * userData, uint64_t time,
     Q_UNUSED(sent); // Data volume received
     Q_UNUSED(received); // Data volume sent
 
+    // Collectives before the window are kept, RawTrace::clipToWindow
+    // drops any that do not have all of their members inside it
+    time = convertTime(userData, time);
+    if (windowPosition(userData, time) > 0)
+        return OTF_RETURN_ABORT;
+
+    int task = taskIndex(userData, process - 1);
+    if (task < 0)
+        return 0;
+
     // Convert rootProc to 0..p-1 space if it truly is a root and not unrooted value
     if (rootProc > 0)
         rootProc--;
+    if (taskIndex(userData, rootProc) >= 0)
+        rootProc = taskIndex(userData, rootProc);
 
     // Create collective record if it doesn't yet exist
     if (!(*(((OTFImporter *) userData)->collectives)).contains(matchingId))
@@ -607,9 +924,8 @@ int OTFImporter::handleBeginCollectiveOperation(void * userData, uint64_t time,
     CollectiveRecord * cr = (*(((OTFImporter *) userData)->collectives))[matchingId];
 
     // Map process/time to the collective record
-    time = convertTime(userData, time);
-    (*(*(((OTFImporter *) userData)->collectiveMap))[process - 1])[time] = cr;
-    ((OTFImporter *) userData)->rawtrace->collectiveBits->at(process - 1)->append(new RawTrace::CollectiveBit(time, cr));
+    (*(*(((OTFImporter *) userData)->collectiveMap))[task])[time] = cr;
+    ((OTFImporter *) userData)->rawtrace->collectiveBits->at(task)->append(new RawTrace::CollectiveBit(time, cr));
 
     return 0;
 }
@@ -28,6 +28,8 @@
 #include <QMap>
 #include <QLinkedList>
 #include <QString>
+#include <QSet>
+#include <QVector>
 #include <stdint.h>
 #include "otf.h"
 
@@ -39,6 +41,8 @@ class OTFCollective;
 class Counter;
 class CollectiveRecord;
 class RawTrace;
+class ProcessingProfile;
+class OTFImportOptions;
 
 // Use OTF API to get records
 class OTFImporter
@@ -46,7 +50,9 @@ class OTFImporter
 public:
     OTFImporter();
     ~OTFImporter();
-    RawTrace * importOTF(const char* otf_file, bool _enforceMessageSize);
+    RawTrace * importOTF(const char* otf_file,
+                         OTFImportOptions * import_options,
+                         ProcessingProfile * profile = NULL);
 
     // Handlers per OTF
     static int handleDefTimerResolution(void * userData, uint32_t stream,
@@ -101,6 +107,12 @@ public:
                                             uint64_t matchingId,
                                             OTF_KeyValueList * list);
 
+    // First pass handler, only collecting who sends to whom
+    static int handlePartnerSend(void * userData, uint64_t time,
+                                 uint32_t sender, uint32_t receiver,
+                                 uint32_t group, uint32_t type,
+                                 uint32_t length, uint32_t source);
+
     // Match comm record of sender and receiver to find both times
     static bool compareComms(CommRecord * comm, unsigned int sender,
                              unsigned int receiver, unsigned int tag,
@@ -111,6 +123,18 @@ public:
 
     static uint64_t convertTime(void* userData, uint64_t time);
 
+    // Where a converted time falls against the import window:
+    // -1 before it, 0 inside it, 1 past it
+    static int windowPosition(void * userData, unsigned long long time);
+    // Marks a message matched across the window start as truncated, or
+    // deletes it and returns NULL if neither end is inside
+    static CommRecord * windowMatch(void * userData, CommRecord * cr);
+
+    // Task a trace rank was imported as, -1 if it is outside the subset
+    static int taskIndex(void * userData, int rank);
+    // Keeps the imported end of a message whose partner is outside the subset
+    static void addStub(void * userData, CommRecord * cr, bool send);
+
     unsigned long long int ticks_per_second;
     double time_conversion_factor;
     int num_processes;
@@ -123,8 +147,17 @@ public:
 
 private:
     void setHandlers();
+    void finishWindow();
+    void selectTasks(const char * otf_file, OTFImportOptions * import_options);
+    void readPartners(const char * otf_file);
+    void addPartner(int sender, int receiver);
 
     bool enforceMessageSize;
+    bool windowed;
+    bool window_anchored; // OTF times are absolute, see windowPosition
+    unsigned long long window_start;
+    unsigned long long window_end;
+    int stubcount;
 
     OTF_FileManager * fileManager;
     OTF_Reader * otfReader;
@@ -133,6 +166,9 @@ private:
     QVector<QLinkedList<CommRecord *> *> * unmatched_recvs;
     QVector<QLinkedList<CommRecord *> *> * unmatched_sends;
 
+    QVector<int> * task_index; // rank to imported task, NULL for all tasks
+    QMap<int, QSet<int> > * partners;
+
     RawTrace * rawtrace;
     QMap<int, Task *> * tasks;
     QMap<int, QString> * functionGroups;
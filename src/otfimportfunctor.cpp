@@ -30,10 +30,12 @@
 #include "otfconverter.h"
 #include "otfimportoptions.h"
 #include "otf2importer.h"
+#include "tracesnapshot.h"
 
 OTFImportFunctor::OTFImportFunctor(OTFImportOptions * _options)
     : options(_options),
-      trace(NULL)
+      trace(NULL),
+      base(NULL)
 {
 }
 
@@ -45,21 +47,36 @@ void OTFImportFunctor::doImportOTF2(QString dataFileName)
 
     traceTimer.start();
 
-    OTFConverter * importer = new OTFConverter();
-    connect(importer, SIGNAL(finishRead()), this, SLOT(finishInitialRead()));
-    connect(importer, SIGNAL(matchingUpdate(int, QString)), this,
-            SLOT(updateMatching(int, QString)));
-    Trace* trace = importer->importOTF2(dataFileName, options);
-    delete importer;
+    // A snapshot from an earlier import skips reading and stepping
+    TraceSnapshot snapshot(dataFileName, options);
+    Trace* trace = snapshot.load();
+    bool from_snapshot = (trace != NULL);
+    if (!from_snapshot)
+    {
+        OTFConverter * importer = new OTFConverter();
+        connect(importer, SIGNAL(finishRead()), this, SLOT(finishInitialRead()));
+        connect(importer, SIGNAL(matchingUpdate(int, QString)), this,
+                SLOT(updateMatching(int, QString)));
+        importer->setKeepRawTrace(options->keepsRecords());
+        trace = importer->importOTF2(dataFileName, options);
+        delete importer;
+    }
     connect(trace, SIGNAL(updatePreprocess(int, QString)), this,
             SLOT(updatePreprocess(int, QString)));
     connect(trace, SIGNAL(updateClustering(int)), this,
             SLOT(updateClustering(int)));
     connect(trace, SIGNAL(startClustering()), this, SLOT(switchProgress()));
-    if (trace->options.origin == OTFImportOptions::OF_SAVE_OTF2)
+    if (from_snapshot
+        || trace->options.origin == OTFImportOptions::OF_SAVE_OTF2)
+    {
         trace->preprocessFromSaved();
+    }
     else
+    {
         trace->preprocess(options);
+        if (options->saveSnapshots)
+            snapshot.save(trace);
+    }
 
     traceElapsed = traceTimer.nsecsElapsed();
     std::cout << "Total trace: ";
@@ -77,12 +94,62 @@ void OTFImportFunctor::doImportOTF(QString dataFileName)
 
     traceTimer.start();
 
+    // A snapshot from an earlier import skips reading and stepping
+    TraceSnapshot snapshot(dataFileName, options);
+    Trace* trace = snapshot.load();
+    bool from_snapshot = (trace != NULL);
+    if (!from_snapshot)
+    {
+        OTFConverter * importer = new OTFConverter();
+        connect(importer, SIGNAL(finishRead()), this, SLOT(finishInitialRead()));
+        connect(importer, SIGNAL(matchingUpdate(int, QString)), this,
+                SLOT(updateMatching(int, QString)));
+        importer->setKeepRawTrace(options->keepsRecords());
+        trace = importer->importOTF(dataFileName, options);
+        delete importer;
+    }
+    connect(trace, SIGNAL(updatePreprocess(int, QString)), this,
+            SLOT(updatePreprocess(int, QString)));
+    connect(trace, SIGNAL(updateClustering(int)), this,
+            SLOT(updateClustering(int)));
+    connect(trace, SIGNAL(startClustering()), this, SLOT(switchProgress()));
+    if (from_snapshot)
+    {
+        trace->preprocessFromSaved();
+    }
+    else
+    {
+        trace->preprocess(options);
+        if (options->saveSnapshots)
+            snapshot.save(trace);
+    }
+
+    traceElapsed = traceTimer.nsecsElapsed();
+    std::cout << "Total trace: ";
+    gu_printTime(traceElapsed);
+    std::cout << std::endl;
+
+    emit(done(trace));
+}
+
+// Redo matching and structure extraction on the kept records with the
+// current options, skipping the read of the archive
+void OTFImportFunctor::doReprocess(QString dataFileName)
+{
+    std::cout << "Reprocessing " << dataFileName.toStdString().c_str() << std::endl;
+    QElapsedTimer traceTimer;
+    qint64 traceElapsed;
+
+    traceTimer.start();
+
     OTFConverter * importer = new OTFConverter();
-    connect(importer, SIGNAL(finishRead()), this, SLOT(finishInitialRead()));
     connect(importer, SIGNAL(matchingUpdate(int, QString)), this,
             SLOT(updateMatching(int, QString)));
-    Trace* trace = importer->importOTF(dataFileName, options);
+    Trace * trace = importer->reconvert(base, options);
     delete importer;
+    base = NULL;
+    trace->fullpath = dataFileName;
+
     connect(trace, SIGNAL(updatePreprocess(int, QString)), this,
             SLOT(updatePreprocess(int, QString)));
     connect(trace, SIGNAL(updateClustering(int)), this,
@@ -90,8 +157,42 @@ void OTFImportFunctor::doImportOTF(QString dataFileName)
     connect(trace, SIGNAL(startClustering()), this, SLOT(switchProgress()));
     trace->preprocess(options);
 
+    if (options->saveSnapshots)
+    {
+        TraceSnapshot snapshot(dataFileName, options);
+        snapshot.save(trace);
+    }
+
     traceElapsed = traceTimer.nsecsElapsed();
-    std::cout << "Total trace: ";
+    std::cout << "Total reprocess: ";
+    gu_printTime(traceElapsed);
+    std::cout << std::endl;
+
+    emit(done(trace));
+}
+
+// Cluster the open trace again with the current clustering options. It
+// keeps its partitions and steps.
+void OTFImportFunctor::doRecluster(QString dataFileName)
+{
+    std::cout << "Reclustering " << dataFileName.toStdString().c_str() << std::endl;
+    QElapsedTimer traceTimer;
+    qint64 traceElapsed;
+
+    traceTimer.start();
+
+    connect(trace, SIGNAL(updateClustering(int)), this,
+            SLOT(updateClustering(int)));
+    trace->recluster(options);
+
+    if (options->saveSnapshots)
+    {
+        TraceSnapshot snapshot(dataFileName, options);
+        snapshot.save(trace);
+    }
+
+    traceElapsed = traceTimer.nsecsElapsed();
+    std::cout << "Total recluster: ";
     gu_printTime(traceElapsed);
     std::cout << std::endl;
 
@@ -30,6 +30,7 @@
 
 class Trace;
 class OTFImportOptions;
+class RawTrace;
 
 // Handle signaling for progress bar
 class OTFImportFunctor : public QObject
@@ -38,10 +39,14 @@ class OTFImportFunctor : public QObject
 public:
     OTFImportFunctor(OTFImportOptions * _options);
     Trace * getTrace() { return trace; }
+    void setBase(RawTrace * _base) { base = _base; }
+    void setTrace(Trace * _trace) { trace = _trace; }
 
 public slots:
     void doImportOTF(QString dataFileName);
     void doImportOTF2(QString dataFileName);
+    void doReprocess(QString dataFileName);
+    void doRecluster(QString dataFileName);
     void finishInitialRead();
     void updateMatching(int portion, QString msg);
     void updatePreprocess(int portion, QString msg);
@@ -57,6 +62,7 @@ signals:
 private:
     OTFImportOptions * options;
     Trace * trace;
+    RawTrace * base; // Kept records to reprocess from
 };
 
 #endif // OTFIMPORTFUNCTOR_H
@@ -38,6 +38,18 @@ OTFImportOptions::OTFImportOptions(bool _waitall, bool _leap, bool _skip,
       seedClusters(false),
       clusterSeed(0),
       advancedStepping(true),
+      timeWindow(false),
+      windowStart(0),
+      windowEnd(0),
+      taskSubset(false),
+      taskFilter(""),
+      taskHops(0),
+      compactCallTrees(false),
+      pageCallTrees(false),
+      callTreeBudget(256),
+      keepRecords(true),
+      saveSnapshots(true),
+      snapshotCacheLimit(4096),
       partitionFunction(_fxn),
       origin(OF_NONE)
 {
@@ -59,6 +71,15 @@ QList<QString> OTFImportOptions::getOptionNames()
     names.append("option_seedClusters");
     names.append("option.clusterSeed");
     names.append("option.advancedStepping");
+    names.append("option_timeWindow");
+    names.append("option_windowStart");
+    names.append("option_windowEnd");
+    names.append("option_taskSubset");
+    names.append("option_taskFilter");
+    names.append("option_taskHops");
+    names.append("option_compactCallTrees");
+    names.append("option_pageCallTrees");
+    names.append("option_callTreeBudget");
     return names;
 }
 
@@ -90,6 +111,24 @@ QString OTFImportOptions::getOptionValue(QString option)
         return QString::number(clusterSeed);
     else if (option == "option.advancedStepping")
         return advancedStepping ? "true" : "";
+    else if (option == "option_timeWindow")
+        return timeWindow ? "true" : "";
+    else if (option == "option_windowStart")
+        return QString::number(windowStart, 'g', 12);
+    else if (option == "option_windowEnd")
+        return QString::number(windowEnd, 'g', 12);
+    else if (option == "option_taskSubset")
+        return taskSubset ? "true" : "";
+    else if (option == "option_taskFilter")
+        return taskFilter;
+    else if (option == "option_taskHops")
+        return QString::number(taskHops);
+    else if (option == "option_compactCallTrees")
+        return compactCallTrees ? "true" : "";
+    else if (option == "option_pageCallTrees")
+        return pageCallTrees ? "true" : "";
+    else if (option == "option_callTreeBudget")
+        return QString::number(callTreeBudget);
     else
         return "";
 }
@@ -122,4 +161,68 @@ void OTFImportOptions::setOption(QString option, QString value)
         clusterSeed = value.toLong();
     else if (option == "option_advancedStepping")
         advancedStepping = value.size();
+    else if (option == "option_timeWindow")
+        timeWindow = value.size();
+    else if (option == "option_windowStart")
+        windowStart = value.toDouble();
+    else if (option == "option_windowEnd")
+        windowEnd = value.toDouble();
+    else if (option == "option_taskSubset")
+        taskSubset = value.size();
+    else if (option == "option_taskFilter")
+        taskFilter = value;
+    else if (option == "option_taskHops")
+        taskHops = value.toInt();
+    else if (option == "option_compactCallTrees")
+        compactCallTrees = value.size();
+    else if (option == "option_pageCallTrees")
+        pageCallTrees = value.size();
+    else if (option == "option_callTreeBudget")
+        callTreeBudget = value.toInt();
+}
+
+// Packing and paging are there to save memory, holding every read
+// record next to the packed calls would undo that
+bool OTFImportOptions::keepsRecords()
+{
+    return keepRecords && !compactCallTrees && !pageCallTrees;
+}
+
+// Options used while reading change which records exist, the rest only
+// change what is built from the matched records. Stepping rescales the
+// counters on the events and may merge partitions, so any change before
+// clustering starts again from matching.
+OTFImportOptions::ReprocessStage
+OTFImportOptions::reprocessStage(const OTFImportOptions& previous)
+{
+    if (timeWindow != previous.timeWindow
+        || (timeWindow && (windowStart != previous.windowStart
+                           || windowEnd != previous.windowEnd))
+        || taskSubset != previous.taskSubset
+        || (taskSubset && (taskFilter != previous.taskFilter
+                           || taskHops != previous.taskHops))
+        || enforceMessageSizes != previous.enforceMessageSizes)
+        return RS_READ;
+
+    if (waitallMerge != previous.waitallMerge
+        || callerMerge != previous.callerMerge
+        || leapMerge != previous.leapMerge
+        || leapSkip != previous.leapSkip
+        || partitionByFunction != previous.partitionByFunction
+        || (partitionByFunction
+            && partitionFunction != previous.partitionFunction)
+        || globalMerge != previous.globalMerge
+        || isendCoalescing != previous.isendCoalescing
+        || advancedStepping != previous.advancedStepping
+        || compactCallTrees != previous.compactCallTrees
+        || pageCallTrees != previous.pageCallTrees
+        || (pageCallTrees && callTreeBudget != previous.callTreeBudget))
+        return RS_STRUCTURE;
+
+    if (cluster != previous.cluster
+        || seedClusters != previous.seedClusters
+        || (seedClusters && clusterSeed != previous.clusterSeed))
+        return RS_CLUSTER;
+
+    return RS_NONE;
 }
@@ -45,6 +45,11 @@ public:
 
     enum OriginFormat { OF_NONE, OF_SAVE_OTF2, OF_OTF2, OF_OTF, OF_CHARM };
 
+    // How much work changing from previous to these options needs
+    enum ReprocessStage { RS_NONE, RS_CLUSTER, RS_STRUCTURE, RS_READ };
+    ReprocessStage reprocessStage(const OTFImportOptions& previous);
+    bool keepsRecords();
+
     bool waitallMerge; // use waitall heuristic
     bool callerMerge; // merge for common callers
     bool leapMerge; // merge to complete leaps
@@ -60,6 +65,23 @@ public:
 
     bool advancedStepping; // send structure over receives
 
+    bool timeWindow; // only import [windowStart, windowEnd]
+    double windowStart; // seconds from the start of the trace
+    double windowEnd;
+
+    bool taskSubset; // only import the tasks named by taskFilter
+    QString taskFilter; // ranks and ranges like "0-15,32" or a communicator
+    int taskHops; // also import message partners this many hops out
+
+    bool compactCallTrees; // pack the calls with no communication below
+    bool pageCallTrees; // and keep the packed calls on disk
+    int callTreeBudget; // MB of paged calls held in memory
+
+    // How the viewer holds on to its work, not part of a trace's options
+    bool keepRecords; // keep the read records to reprocess without reading
+    bool saveSnapshots; // write a snapshot after processing
+    int snapshotCacheLimit; // MB the snapshot cache may use
+
     OriginFormat origin;
     QString partitionFunction;
 
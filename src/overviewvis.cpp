@@ -100,14 +100,14 @@ void OverviewVis::setSteps(float start, float stop, bool jump)
     */
 
     if (!closed)
-        repaint();
+        update();
 }
 
 void OverviewVis::resizeEvent(QResizeEvent * event) {
     visProcessed = false;
     VisWidget::resizeEvent(event);
     processVis();
-    repaint();
+    update();
 }
 
 // Functions for brushing
@@ -115,13 +115,13 @@ void OverviewVis::mousePressEvent(QMouseEvent * event) {
     startCursor = event->x() - border;
     stopCursor = startCursor;
     mousePressed = true;
-    repaint();
+    update();
 }
 
 void OverviewVis::mouseMoveEvent(QMouseEvent * event) {
     if (mousePressed) {
         stopCursor = event->x() - border;
-        repaint();
+        update();
     }
 }
 
@@ -133,7 +133,7 @@ void OverviewVis::mouseReleaseEvent(QMouseEvent * event) {
         startCursor = stopCursor;
         stopCursor = tmp;
     }
-    repaint();
+    update();
 
     // PreVis int timespan = maxTime - minTime;
     int width = size().width() - 2 * border;
@@ -177,8 +177,8 @@ void OverviewVis::setTrace(Trace * t)
     VisWidget::setTrace(t);
     cacheMetric = options->metric;
     maxStep = trace->global_max_step;
-    minTime = ULLONG_MAX;
-    maxTime = 0;
+    minTime = trace->min_time;
+    maxTime = trace->max_time;
     //unsigned long long init_time = ULLONG_MAX;
     //unsigned long long finalize_time = 0;
     // Maybe we should have this be by step instead? We'll see. Right now it
@@ -233,8 +233,8 @@ void OverviewVis::setTrace(Trace * t)
 
 
 // Calculate what the heights should be for the metrics
-// TODO: Save this stuff per step somewhere and have that be accessed as needed
-// rather than iterating through everything
+// The per-step totals are cached in the trace, so this only rebins them
+// to the current width.
 void OverviewVis::processVis()
 {
     // Don't do anything if there's no trace available
@@ -245,66 +245,30 @@ void OverviewVis::processVis()
     int stepspan = maxStep + 1;
     stepWidth = width / 1.0 / stepspan;
     int start_int, stop_int;
-    QString metric = options->metric;
+    QVector<double> * totals = trace->metricStepTotals(options->metric);
     //stepPositions = QVector<std::pair<int, int> >(maxStep+1, std::pair<int, int>(width + 1, -1));
-    for (QList<Partition *>::Iterator part = trace->partitions->begin();
-         part != trace->partitions->end(); ++part)
+
+    // For each step, we figure out which cursor positions it spans and then
+    // we accumulate height over those based on the step's metric total
+    for (int step = 0; step < totals->size(); ++step)
     {
-        for (QMap<int, QList<CommEvent *> *>::Iterator event_list
-             = (*part)->events->begin();
-             event_list != (*part)->events->end(); ++event_list)
+        double value = totals->at(step);
+        if (value <= 0)
+            continue;
+
+        // start and stop are the cursor positions
+        float start = (width - 1) * (step / 1.0 / stepspan);
+        float stop = start + stepWidth;
+        start_int = static_cast<int>(start);
+        stop_int = static_cast<int>(stop);
+
+        heights[start_int] += value * (start - start_int);
+        if (stop_int != start_int) {
+            heights[stop_int] += value * (stop - stop_int);
+        }
+        for (int i = start_int + 1; i < stop_int; i++)
         {
-            // For each event, we figure out which steps it spans and then we
-            // accumulate height over those steps based on the event's metric
-            // value
-            for (QList<CommEvent *>::Iterator evt = (event_list.value())->begin();
-                 evt != (event_list.value())->end(); ++evt)
-            {
-                // start and stop are the cursor positions
-                float start = (width - 1) * (((*evt)->step) / 1.0 / stepspan);
-                float stop = start + stepWidth;
-                start_int = static_cast<int>(start);
-                stop_int = static_cast<int>(stop);
-
-                if ((*evt)->hasMetric(metric) && (*evt)->getMetric(metric)> 0)
-                {
-                    heights[start_int] += (*evt)->getMetric(metric)
-                                          * (start - start_int);
-                    if (stop_int != start_int) {
-                        heights[stop_int] += (*evt)->getMetric(metric)
-                                             * (stop - stop_int);
-                    }
-                    for (int i = start_int + 1; i < stop_int; i++)
-                    {
-                        heights[i] += (*evt)->getMetric(metric);
-                    }
-
-                }
-
-                // again for the aggregate
-                if ((*evt)->step == 0)
-                    continue;
-                start = (width - 1) * (((*evt)->step - 1) / 1.0 / stepspan);
-                stop = start + stepWidth;
-                start_int = static_cast<int>(start);
-                stop_int = static_cast<int>(stop); // start_int + i_step_width;
-
-                if ((*evt)->hasMetric(metric)
-                        && (*evt)->getMetric(metric, true)> 0)
-                {
-                    heights[start_int] += (*evt)->getMetric(metric, true)
-                                          * (start - start_int);
-                    if (stop_int != start_int)
-                    {
-                        heights[stop_int] += (*evt)->getMetric(metric, true)
-                                             * (stop - stop_int);
-                    }
-                    for (int i = start_int + 1; i < stop_int; i++)
-                    {
-                        heights[i] += (*evt)->getMetric(metric, true);
-                    }
-                }
-            }
+            heights[i] += value;
         }
     }
     float minLateness = FLT_MAX;
@@ -95,12 +95,7 @@ P2PEvent::P2PEvent(QList<P2PEvent *> * _subevents)
 
 P2PEvent::~P2PEvent()
 {
-    for (QVector<Message *>::Iterator itr = messages->begin();
-         itr != messages->end(); ++itr)
-    {
-            delete *itr;
-            *itr = NULL;
-    }
+    // Messages are shared by both ends so the trace frees them
     delete messages;
 
     if (subevents)
@@ -275,8 +270,7 @@ void P2PEvent::set_stride_relationships(CommEvent * base)
 
     if (task_next && task_next->partition == partition)
     {
-        stride_children->insert(task_next);
-        task_next->stride_parents->insert(this);
+        addStrideChild(task_next);
     }
 }
 
@@ -403,7 +397,7 @@ QList<int> P2PEvent::neighborTasks()
 
 // Here between the enter and leave we know we have no children as normal,
 // but we do have subevents. So we want to write those as the correct time.
-void P2PEvent::writeToOTF2(OTF2_EvtWriter * writer, QMap<QString, int> * attributeMap)
+void P2PEvent::writeToOTF2(OTF2_EvtWriter * writer, OTF2WriterAttributes * attributes)
 {
     writeOTF2Enter(writer);
 
@@ -412,7 +406,7 @@ void P2PEvent::writeToOTF2(OTF2_EvtWriter * writer, QMap<QString, int> * attribu
         for (QList<P2PEvent *>::Iterator sub = subevents->begin();
              sub != subevents->end(); ++sub)
         {
-            (*sub)->writeToOTF2(writer, attributeMap);
+            (*sub)->writeToOTF2(writer, attributes);
         }
     }
 
@@ -448,5 +442,5 @@ void P2PEvent::writeToOTF2(OTF2_EvtWriter * writer, QMap<QString, int> * attribu
 
     }
 
-    writeOTF2Leave(writer, attributeMap);
+    writeOTF2Leave(writer, attributes);
 }
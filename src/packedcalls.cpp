@@ -0,0 +1,242 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+//
+// This file is part of Ravel.
+// Written by Kate Isaacs, kisaacs@acm.org, All rights reserved.
+// LLNL-CODE-663885
+//
+// For details, see https://github.com/scalability-llnl/ravel
+// Please also see the LICENSE file for our notice and the LGPL.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (as published by
+// the Free Software Foundation) version 2.1 dated February 1999.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the IMPLIED WARRANTY OF
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the terms and
+// conditions of the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//////////////////////////////////////////////////////////////////////////////
+#include "packedcalls.h"
+#include "callstore.h"
+#include <QStack>
+
+static void writeVarint(QByteArray& data, unsigned long long value)
+{
+    while (value >= 0x80)
+    {
+        data.append(char((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    data.append(char(value));
+}
+
+static unsigned long long readVarint(const char * data, int length, int& pos)
+{
+    unsigned long long value = 0;
+    int shift = 0;
+    while (pos < length && shift < 64)
+    {
+        unsigned char byte = data[pos++];
+        value |= static_cast<unsigned long long>(byte & 0x7f) << shift;
+        if (!(byte & 0x80))
+            break;
+        shift += 7;
+    }
+    return value;
+}
+
+PackedCalls::PackedCalls(Event * _caller, int _task, int _depth)
+    : Event(0, 0, -1, _task),
+      data(QByteArray()),
+      count(0),
+      store(NULL),
+      page(-1),
+      last_enter(0),
+      loose(new QMap<QPair<unsigned long long, int>, Event *>())
+{
+    caller = _caller;
+    depth = _depth;
+}
+
+PackedCalls::PackedCalls(unsigned long long _enter, unsigned long long _exit,
+                         int _task, int _depth)
+    : Event(_enter, _exit, -1, _task),
+      data(QByteArray()),
+      count(0),
+      store(NULL),
+      page(-1),
+      last_enter(_enter),
+      loose(new QMap<QPair<unsigned long long, int>, Event *>())
+{
+    depth = _depth;
+}
+
+PackedCalls::~PackedCalls()
+{
+    qDeleteAll(*loose);
+    delete loose;
+}
+
+void PackedCalls::append(Event * root)
+{
+    appendCall(root->enter, root->exit, root->function, root->depth);
+    for (QVector<Event *>::Iterator child = root->callees->begin();
+         child != root->callees->end(); ++child)
+    {
+        append(*child);
+    }
+}
+
+void PackedCalls::appendCall(unsigned long long call_enter,
+                             unsigned long long call_exit,
+                             int call_function, int call_depth)
+{
+    if (count == 0)
+    {
+        enter = call_enter;
+        last_enter = call_enter;
+    }
+
+    writeVarint(data, call_enter - last_enter);
+    writeVarint(data, call_exit - call_enter);
+    writeVarint(data, call_function);
+    writeVarint(data, call_depth - depth);
+
+    last_enter = call_enter;
+    if (call_exit > exit)
+        exit = call_exit;
+    ++count;
+}
+
+QByteArray PackedCalls::bytes()
+{
+    if (store)
+        return store->load(page);
+    return data;
+}
+
+void PackedCalls::setBytes(const QByteArray& _data, int _count)
+{
+    data = _data;
+    count = _count;
+    store = NULL;
+    page = -1;
+}
+
+// Left in memory if the store cannot take them
+void PackedCalls::pageOut(CallStore * _store)
+{
+    if (store || data.isEmpty())
+        return;
+
+    page = _store->store(data);
+    if (page < 0)
+        return;
+
+    store = _store;
+    data = QByteArray();
+}
+
+void PackedCalls::decode(QVector<Call> * calls, unsigned long long start,
+                         unsigned long long stop)
+{
+    QByteArray records = bytes();
+    const char * raw = records.constData();
+    int length = records.size();
+    int pos = 0;
+    unsigned long long call_enter = enter;
+
+    // Where the latest call at each level went in calls, -2 if skipped
+    QVector<int> latest = QVector<int>();
+    for (int i = 0; i < count && pos < length; ++i)
+    {
+        Call call = Call();
+        call_enter += readVarint(raw, length, pos);
+        call.enter = call_enter;
+        call.exit = call_enter + readVarint(raw, length, pos);
+        call.function = readVarint(raw, length, pos);
+        int level = readVarint(raw, length, pos);
+        call.depth = depth + level;
+
+        // Every call after this one enters later still
+        if (call.enter > stop)
+            break;
+
+        latest.resize(level + 1);
+        if (level > 0)
+            call.parent = latest[level - 1];
+        if (call.parent == -2 || call.exit < start)
+        {
+            latest[level] = -2;
+            continue;
+        }
+
+        latest[level] = calls->size();
+        calls->append(call);
+    }
+}
+
+// The deepest call holding the time, as an Event for the GUI to select
+Event * PackedCalls::findChild(unsigned long long time)
+{
+    if (time < enter || time > exit)
+        return NULL;
+
+    QVector<Call> calls = QVector<Call>();
+    decode(&calls, time, time);
+    if (calls.isEmpty())
+        return NULL; // Between the calls, so it is the caller's time
+
+    return looseEvent(calls, calls.size() - 1);
+}
+
+Event * PackedCalls::looseEvent(const QVector<Call>& calls, int index)
+{
+    const Call& call = calls.at(index);
+    QPair<unsigned long long, int> key(call.enter, call.depth);
+    if (loose->contains(key))
+        return loose->value(key);
+
+    Event * evt = new Event(call.enter, call.exit, call.function, task);
+    evt->depth = call.depth;
+    if (call.parent >= 0)
+        evt->caller = looseEvent(calls, call.parent);
+    else
+        evt->caller = caller;
+    loose->insert(key, evt);
+    return evt;
+}
+
+void PackedCalls::writeToOTF2(OTF2_EvtWriter * writer,
+                              OTF2WriterAttributes * attributes)
+{
+    Q_UNUSED(attributes);
+    QVector<Call> calls = QVector<Call>();
+    decode(&calls);
+
+    // A call is left once the next call is not below it
+    QStack<int> open = QStack<int>();
+    for (int i = 0; i < calls.size(); ++i)
+    {
+        while (!open.isEmpty()
+               && calls.at(open.top()).depth >= calls.at(i).depth)
+        {
+            const Call& done = calls.at(open.pop());
+            OTF2_EvtWriter_Leave(writer, NULL, done.exit, done.function);
+        }
+        OTF2_EvtWriter_Enter(writer, NULL, calls.at(i).enter,
+                             calls.at(i).function);
+        open.push(i);
+    }
+    while (!open.isEmpty())
+    {
+        const Call& done = calls.at(open.pop());
+        OTF2_EvtWriter_Leave(writer, NULL, done.exit, done.function);
+    }
+}
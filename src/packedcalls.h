@@ -0,0 +1,102 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+//
+// This file is part of Ravel.
+// Written by Kate Isaacs, kisaacs@acm.org, All rights reserved.
+// LLNL-CODE-663885
+//
+// For details, see https://github.com/scalability-llnl/ravel
+// Please also see the LICENSE file for our notice and the LGPL.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (as published by
+// the Free Software Foundation) version 2.1 dated February 1999.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the IMPLIED WARRANTY OF
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the terms and
+// conditions of the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//////////////////////////////////////////////////////////////////////////////
+#ifndef PACKEDCALLS_H
+#define PACKEDCALLS_H
+
+#include "event.h"
+#include <QByteArray>
+#include <QVector>
+#include <QMap>
+#include <QPair>
+#include <climits>
+
+class CallStore;
+
+// Stands in a call tree for a run of sibling calls with no communication
+// anywhere below them. The calls are kept as variable length records in
+// preorder rather than as Events: the enter time as a difference from the
+// previous call's, the duration, the function and the depth below the run.
+// The stub spans the run and has no function or callees of its own.
+class PackedCalls : public Event
+{
+public:
+    PackedCalls(Event * _caller, int _task, int _depth);
+    PackedCalls(unsigned long long _enter, unsigned long long _exit,
+                int _task, int _depth);
+    ~PackedCalls();
+
+    // One call as read back out
+    class Call {
+    public:
+        Call()
+            : enter(0), exit(0), function(-1), depth(-1), parent(-1) {}
+
+        unsigned long long enter;
+        unsigned long long exit;
+        int function;
+        int depth;
+        int parent; // index of its caller in the decoded calls, -1 for the run
+    };
+
+    // Calls must be added in preorder, starting at the stub's depth
+    void append(Event * root);
+    void appendCall(unsigned long long call_enter,
+                    unsigned long long call_exit,
+                    int call_function, int call_depth);
+
+    // Appends the calls overlapping [start, stop], callers before callees.
+    // A call is only listed when its caller is.
+    void decode(QVector<Call> * calls, unsigned long long start = 0,
+                unsigned long long stop = ULLONG_MAX);
+
+    // Replace the records wholesale, as when reading a snapshot
+    int size() { return count; }
+    QByteArray bytes();
+    void setBytes(const QByteArray& _data, int _count);
+
+    // Move the records to the store, they are loaded back to decode.
+    // Nothing more can be appended after.
+    void pageOut(CallStore * _store);
+    bool isPagedOut() { return store; }
+
+    bool isPacked() { return true; }
+    Event * findChild(unsigned long long time);
+    void writeToOTF2(OTF2_EvtWriter * writer,
+                     OTF2WriterAttributes * attributes);
+
+private:
+    Event * looseEvent(const QVector<Call>& calls, int index);
+
+    QByteArray data;
+    int count;
+    CallStore * store; // holds the records instead of data when set
+    int page;
+    unsigned long long last_enter; // for the next difference
+
+    // Events made for lookups from the GUI, owned here, by enter and depth
+    QMap<QPair<unsigned long long, int>, Event *> * loose;
+};
+
+#endif // PACKEDCALLS_H
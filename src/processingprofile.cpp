@@ -0,0 +1,179 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+//
+// This file is part of Ravel.
+// Written by Kate Isaacs, kisaacs@acm.org, All rights reserved.
+// LLNL-CODE-663885
+//
+// For details, see https://github.com/scalability-llnl/ravel
+// Please also see the LICENSE file for our notice and the LGPL.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (as published by
+// the Free Software Foundation) version 2.1 dated February 1999.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the IMPLIED WARRANTY OF
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the terms and
+// conditions of the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//////////////////////////////////////////////////////////////////////////////
+#include "processingprofile.h"
+#include "general_util.h"
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QJsonDocument>
+
+ProcessingProfile::ProcessingProfile()
+    : phases(QList<Phase>()),
+      counters(QList<Counter>()),
+      echo(true),
+      clock(QElapsedTimer()),
+      depth(0)
+{
+    clock.start();
+}
+
+int ProcessingProfile::beginPhase(QString name)
+{
+    phases.append(Phase(name, depth, clock.nsecsElapsed()));
+    depth++;
+    return phases.size() - 1;
+}
+
+void ProcessingProfile::endPhase(int phase)
+{
+    if (phase < 0 || phase >= phases.size() || phases[phase].duration >= 0)
+        return;
+
+    Phase& ended = phases[phase];
+    ended.duration = clock.nsecsElapsed() - ended.start;
+    ended.peak_memory = gu_peakMemory();
+    depth = ended.depth;
+
+    if (echo)
+    {
+        std::cout << ended.name.toStdString().c_str() << ": ";
+        gu_printTime(ended.duration);
+        std::cout << std::endl;
+    }
+}
+
+int ProcessingProfile::counterIndex(QString name)
+{
+    for (int i = 0; i < counters.size(); i++)
+        if (counters[i].name == name)
+            return i;
+    counters.append(Counter(name));
+    return counters.size() - 1;
+}
+
+void ProcessingProfile::setCounter(QString name, qint64 value)
+{
+    counters[counterIndex(name)].value = value;
+}
+
+void ProcessingProfile::addToCounter(QString name, qint64 amount)
+{
+    counters[counterIndex(name)].value += amount;
+}
+
+qint64 ProcessingProfile::getCounter(QString name)
+{
+    for (int i = 0; i < counters.size(); i++)
+        if (counters[i].name == name)
+            return counters[i].value;
+    return 0;
+}
+
+QByteArray ProcessingProfile::toJson()
+{
+    QJsonArray phase_array;
+    for (QList<Phase>::Iterator phase = phases.begin(); phase != phases.end();
+         ++phase)
+    {
+        QJsonObject entry;
+        entry["name"] = phase->name;
+        entry["depth"] = phase->depth;
+        entry["start_seconds"] = phase->start * 1e-9;
+        entry["seconds"] = phase->duration * 1e-9;
+        entry["peak_rss_bytes"] = double(phase->peak_memory);
+        phase_array.append(entry);
+    }
+
+    QJsonObject counter_object;
+    for (QList<Counter>::Iterator counter = counters.begin();
+         counter != counters.end(); ++counter)
+    {
+        counter_object[counter->name] = double(counter->value);
+    }
+
+    QJsonObject profile;
+    profile["phases"] = phase_array;
+    profile["counters"] = counter_object;
+    profile["peak_rss_bytes"] = double(gu_peakMemory());
+    return QJsonDocument(profile).toJson();
+}
+
+QByteArray ProcessingProfile::toChromeTrace()
+{
+    QJsonArray events;
+    for (QList<Phase>::Iterator phase = phases.begin(); phase != phases.end();
+         ++phase)
+    {
+        if (phase->duration < 0)
+            continue;
+
+        // Complete events in microseconds
+        QJsonObject entry;
+        entry["name"] = phase->name;
+        entry["cat"] = QString("ravel");
+        entry["ph"] = QString("X");
+        entry["ts"] = phase->start / 1000.0;
+        entry["dur"] = phase->duration / 1000.0;
+        entry["pid"] = 1;
+        entry["tid"] = 1;
+        QJsonObject args;
+        args["peak_rss_bytes"] = double(phase->peak_memory);
+        entry["args"] = args;
+        events.append(entry);
+
+        // Memory as a counter track
+        QJsonObject memory;
+        memory["name"] = QString("Peak RSS");
+        memory["ph"] = QString("C");
+        memory["ts"] = (phase->start + phase->duration) / 1000.0;
+        memory["pid"] = 1;
+        QJsonObject memory_args;
+        memory_args["bytes"] = double(phase->peak_memory);
+        memory["args"] = memory_args;
+        events.append(memory);
+    }
+
+    // Counters are totals, so they go in the metadata
+    QJsonObject counter_object;
+    for (QList<Counter>::Iterator counter = counters.begin();
+         counter != counters.end(); ++counter)
+    {
+        counter_object[counter->name] = double(counter->value);
+    }
+
+    QJsonObject process_name;
+    process_name["name"] = QString("process_name");
+    process_name["ph"] = QString("M");
+    process_name["pid"] = 1;
+    QJsonObject name_args;
+    name_args["name"] = QString("Ravel");
+    process_name["args"] = name_args;
+    events.append(process_name);
+
+    QJsonObject trace;
+    trace["traceEvents"] = events;
+    trace["displayTimeUnit"] = QString("ms");
+    trace["metadata"] = counter_object;
+    return QJsonDocument(trace).toJson();
+}
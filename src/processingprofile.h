@@ -0,0 +1,99 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+//
+// This file is part of Ravel.
+// Written by Kate Isaacs, kisaacs@acm.org, All rights reserved.
+// LLNL-CODE-663885
+//
+// For details, see https://github.com/scalability-llnl/ravel
+// Please also see the LICENSE file for our notice and the LGPL.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (as published by
+// the Free Software Foundation) version 2.1 dated February 1999.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the IMPLIED WARRANTY OF
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the terms and
+// conditions of the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//////////////////////////////////////////////////////////////////////////////
+#ifndef PROCESSINGPROFILE_H
+#define PROCESSINGPROFILE_H
+
+#include <QString>
+#include <QList>
+#include <QByteArray>
+#include <QElapsedTimer>
+
+// Timings, counts and memory high-water marks gathered while a trace is
+// read and processed. Phases nest in the order they are begun. Not thread
+// safe, phases are expected to come from the processing thread only.
+class ProcessingProfile
+{
+public:
+    ProcessingProfile();
+
+    class Phase {
+    public:
+        Phase(QString _name = "", int _depth = 0, qint64 _start = 0)
+            : name(_name), depth(_depth), start(_start), duration(-1),
+              peak_memory(0) {}
+
+        QString name;
+        int depth; // nesting level, 0 for outermost
+        qint64 start; // ns since the profile began
+        qint64 duration; // ns, -1 while running
+        qint64 peak_memory; // process high-water bytes when it ended
+    };
+
+    class Counter {
+    public:
+        Counter(QString _name = "", qint64 _value = 0)
+            : name(_name), value(_value) {}
+
+        QString name;
+        qint64 value;
+    };
+
+    int beginPhase(QString name);
+    void endPhase(int phase);
+    void setCounter(QString name, qint64 value);
+    void addToCounter(QString name, qint64 amount);
+    qint64 getCounter(QString name);
+
+    // Plain JSON with phases and counters
+    QByteArray toJson();
+    // Chrome trace event format for chrome://tracing or Perfetto
+    QByteArray toChromeTrace();
+
+    QList<Phase> phases;
+    QList<Counter> counters;
+    bool echo; // print each phase as it ends like the old timing log
+
+private:
+    int counterIndex(QString name);
+
+    QElapsedTimer clock;
+    int depth;
+};
+
+// Times a phase for as long as it is in scope
+class ProfileScope
+{
+public:
+    ProfileScope(ProcessingProfile * _profile, QString name)
+        : profile(_profile),
+          phase(_profile ? _profile->beginPhase(name) : -1) {}
+    ~ProfileScope() { if (profile) profile->endPhase(phase); }
+
+private:
+    ProcessingProfile * profile;
+    int phase;
+};
+
+#endif // PROCESSINGPROFILE_H
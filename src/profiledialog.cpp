@@ -0,0 +1,136 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+//
+// This file is part of Ravel.
+// Written by Kate Isaacs, kisaacs@acm.org, All rights reserved.
+// LLNL-CODE-663885
+//
+// For details, see https://github.com/scalability-llnl/ravel
+// Please also see the LICENSE file for our notice and the LGPL.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (as published by
+// the Free Software Foundation) version 2.1 dated February 1999.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the IMPLIED WARRANTY OF
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the terms and
+// conditions of the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//////////////////////////////////////////////////////////////////////////////
+#include "profiledialog.h"
+#include "ui_profiledialog.h"
+#include "processingprofile.h"
+#include <QTreeWidgetItem>
+#include <QFileDialog>
+#include <QFile>
+#include <QMessageBox>
+
+ProfileDialog::ProfileDialog(QWidget *parent, ProcessingProfile * _profile,
+                             QString _name)
+    : QDialog(parent),
+    ui(new Ui::ProfileDialog),
+    profile(_profile),
+    name(_name)
+{
+    ui->setupUi(this);
+
+    connect(ui->jsonButton, SIGNAL(clicked()), this, SLOT(exportJson()));
+    connect(ui->chromeButton, SIGNAL(clicked()), this,
+            SLOT(exportChromeTrace()));
+
+    setWindowTitle("Processing Profile - " + name);
+    setUIState();
+}
+
+ProfileDialog::~ProfileDialog()
+{
+    delete ui;
+}
+
+void ProfileDialog::setUIState()
+{
+    ui->phaseTree->clear();
+    ui->counterTree->clear();
+    if (!profile)
+        return;
+
+    // Phases are stored in begin order, so a phase's parent is the last
+    // phase seen one level up
+    QList<QTreeWidgetItem *> parents;
+    for (QList<ProcessingProfile::Phase>::Iterator phase
+         = profile->phases.begin(); phase != profile->phases.end(); ++phase)
+    {
+        QStringList columns;
+        columns << phase->name;
+        if (phase->duration >= 0)
+            columns << QString::number(phase->duration / 1e9, 'f', 3);
+        else
+            columns << "running";
+        columns << QString::number(phase->peak_memory / (1024.0 * 1024.0),
+                                   'f', 1);
+
+        QTreeWidgetItem * item;
+        while (parents.size() > phase->depth)
+            parents.removeLast();
+        if (parents.isEmpty())
+            item = new QTreeWidgetItem(ui->phaseTree, columns);
+        else
+            item = new QTreeWidgetItem(parents.last(), columns);
+        item->setTextAlignment(1, Qt::AlignRight);
+        item->setTextAlignment(2, Qt::AlignRight);
+        parents.append(item);
+    }
+    ui->phaseTree->expandAll();
+    for (int i = 0; i < ui->phaseTree->columnCount(); i++)
+        ui->phaseTree->resizeColumnToContents(i);
+
+    for (QList<ProcessingProfile::Counter>::Iterator counter
+         = profile->counters.begin(); counter != profile->counters.end();
+         ++counter)
+    {
+        QStringList columns;
+        columns << counter->name << QString::number(counter->value);
+        QTreeWidgetItem * item = new QTreeWidgetItem(ui->counterTree, columns);
+        item->setTextAlignment(1, Qt::AlignRight);
+    }
+    ui->counterTree->resizeColumnToContents(0);
+}
+
+void ProfileDialog::exportJson()
+{
+    if (profile)
+        writeFile(tr("Export Processing Profile"), ".profile.json",
+                  profile->toJson());
+}
+
+void ProfileDialog::exportChromeTrace()
+{
+    if (profile)
+        writeFile(tr("Export Chrome Trace"), ".trace.json",
+                  profile->toChromeTrace());
+}
+
+void ProfileDialog::writeFile(QString caption, QString suffix,
+                              QByteArray contents)
+{
+    QString filename = QFileDialog::getSaveFileName(this, caption,
+                                                    name + suffix,
+                                                    tr("JSON Files (*.json)"));
+    if (filename.isEmpty())
+        return;
+
+    QFile file(filename);
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        QMessageBox::warning(this, caption,
+                             "Could not write " + filename + ".");
+        return;
+    }
+    file.write(contents);
+    file.close();
+}
@@ -0,0 +1,137 @@
+##########################################################################
+# Copyright (c) 2014, Lawrence Livermore National Security, LLC.
+# Produced at the Lawrence Livermore National Laboratory.
+#
+# This file is part of Ravel.
+# Written by Kate Isaacs, kisaacs@acm.org, All rights reserved.
+# LLNL-CODE-663885
+#
+# For details, see https://github.com/scalability-llnl/ravel
+# Please also see the LICENSE file for our notice and the LGPL.
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License (as published by
+# the Free Software Foundation) version 2.1 dated February 1999.
+# 
+# This program is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the IMPLIED WARRANTY OF
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the terms and
+# conditions of the GNU General Public License for more details.
+# 
+# You should have received a copy of the GNU Lesser General Public License
+# along with this program; if not, write to the Free Software Foundation,
+# Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+##########################################################################
+# Processing core and libraries shared by ravel-batch and ravel-bench,
+# the same files as RavelCore_SOURCES in CMakeLists.txt
+SOURCES  += \
+    trace.cpp \
+    event.cpp \
+    message.cpp \
+    function.cpp \
+    otfimporter.cpp \
+    rawtrace.cpp \
+    otfconverter.cpp \
+    otfimportoptions.cpp \
+    gnome.cpp \
+    exchangegnome.cpp \
+    collectiverecord.cpp \
+    partitioncluster.cpp \
+    clusterevent.cpp \
+    rpartition.cpp \
+    otfcollective.cpp \
+    commevent.cpp \
+    p2pevent.cpp \
+    collectiveevent.cpp \
+    commdrawinterface.cpp \
+    counter.cpp \
+    counterrecord.cpp \
+    otf2importer.cpp \
+    task.cpp \
+    clustertask.cpp \
+    taskgroup.cpp \
+    otf2exporter.cpp \
+    stepindex.cpp \
+    timepyramid.cpp \
+    hotspotindex.cpp \
+    packedcalls.cpp \
+    callstore.cpp \
+    stridegraph.cpp \
+    tracesnapshot.cpp \
+    otf2writerattributes.cpp \
+    processingprofile.cpp \
+    commrecord.cpp \
+    eventrecord.cpp \
+    colormap.cpp \
+    visoptions.cpp
+
+HEADERS += \
+    trace.h \
+    event.h \
+    message.h \
+    function.h \
+    otfimporter.h \
+    rawtrace.h \
+    otfconverter.h \
+    otfimportoptions.h \
+    gnome.h \
+    exchangegnome.h \
+    collectiverecord.h \
+    partitioncluster.h \
+    clusterevent.h \
+    rpartition.h \
+    otfcollective.h \
+    commevent.h \
+    p2pevent.h \
+    collectiveevent.h \
+    commdrawinterface.h \
+    counter.h \
+    counterrecord.h \
+    otf2importer.h \
+    task.h \
+    clustertask.h \
+    taskgroup.h \
+    otf2exporter.h \
+    stepindex.h \
+    timepyramid.h \
+    hotspotindex.h \
+    packedcalls.h \
+    callstore.h \
+    stridegraph.h \
+    tracesnapshot.h \
+    otf2writerattributes.h \
+    processingprofile.h \
+    hitgrid.h \
+    commrecord.h \
+    eventrecord.h \
+    colormap.h \
+    visoptions.h \
+    general_util.h \
+    commbundle.h
+
+HOME = $$system(echo $HOME)
+
+unix:!macx: LIBS += -lotf -lz
+
+unix: INCLUDEPATH += $${HOME}/opt/include
+unix: DEPENDPATH += $${HOME}/opt/include
+
+unix:!macx: INCLUDEPATH += /opt/otf2/include
+unix:!macx: DEPENDPATH += /opt/otf2/include
+
+unix:!macx: LIBS += -L/opt/otf2/lib -lotf2
+
+macx: LIBS += -lz
+macx: LIBS += -L$${HOME}/opt/lib -lopen-trace-format -lotf2
+
+macx: INCLUDEPATH += $${HOME}/opt/include/open-trace-format/
+macx: DEPENDPATH += $${HOME}/opt/include/open-trace-format/
+
+macx: INCLUDEPATH += $${HOME}/opt/include/otf2/
+macx: DEPENDPATH += $${HOME}/opt/include/otf2/
+
+unix:!macx: LIBS += -L$${HOME}/opt/lib -lmuster
+
+macx: LIBS += -L$${HOME}/opt/muster/lib -lmuster
+macx: INCLUDEPATH += $${HOME}/opt/muster/include
+macx: DEPENDPATH += $${HOME}/opt/muster/include
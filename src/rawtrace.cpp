@@ -34,6 +34,11 @@
 #include "counter.h"
 #include "counterrecord.h"
 #include "otfimportoptions.h"
+#include <QSet>
+#include <QStringList>
+#include <QStack>
+#include <iostream>
+#include <algorithm>
 
 
 RawTrace::RawTrace(int nt)
@@ -55,15 +60,20 @@ RawTrace::RawTrace(int nt)
       second_magnitude(1),
       from_saved_version(""),
       metric_names(NULL),
-      metric_units(NULL)
+      metric_units(NULL),
+      owns_definitions(false)
 {
 
 }
 
 // Note we do not delete the function/functionGroup map because
-// we know that will get passed to the processed trace
+// we know that will get passed to the processed trace, unless
+// this was kept for reprocessing and the traces got copies
 RawTrace::~RawTrace()
 {
+    if (owns_definitions)
+        deleteDefinitions();
+
     for (QVector<QVector<EventRecord *> *>::Iterator eitr = events->begin();
          eitr != events->end(); ++eitr)
     {
@@ -78,6 +88,21 @@ RawTrace::~RawTrace()
     }
     delete events;
 
+    // Receives from outside a task subset have no send to own them,
+    // check them before the sends are freed
+    for (QVector<QVector<CommRecord *> *>::Iterator eitr = messages_r->begin();
+         eitr != messages_r->end(); ++eitr)
+    {
+        for (QVector<CommRecord *>::Iterator itr = (*eitr)->begin();
+             itr != (*eitr)->end(); ++itr)
+        {
+            if ((*itr)->stub)
+                delete *itr;
+        }
+        delete *eitr;
+    }
+    delete messages_r;
+
     for (QVector<QVector<CommRecord *> *>::Iterator eitr = messages->begin();
          eitr != messages->end(); ++eitr)
     {
@@ -91,7 +116,6 @@ RawTrace::~RawTrace()
         *eitr = NULL;
     }
     delete messages;
-    delete messages_r;
 
     for (QVector<QVector<CollectiveBit *> *>::Iterator eitr = collectiveBits->begin();
          eitr != collectiveBits->end(); ++eitr)
@@ -114,3 +138,256 @@ RawTrace::~RawTrace()
     if (metric_units)
         delete metric_units;
 }
+
+void RawTrace::deleteDefinitions()
+{
+    for (QMap<int, Function *>::Iterator fxn = functions->begin();
+         fxn != functions->end(); ++fxn)
+        delete fxn.value();
+    delete functions;
+    delete functionGroups;
+
+    for (QMap<int, Task *>::Iterator task = tasks->begin();
+         task != tasks->end(); ++task)
+        delete task.value();
+    delete tasks;
+
+    for (QMap<int, TaskGroup *>::Iterator tg = taskgroups->begin();
+         tg != taskgroups->end(); ++tg)
+        delete tg.value();
+    delete taskgroups;
+
+    for (QMap<int, OTFCollective *>::Iterator cdef = collective_definitions->begin();
+         cdef != collective_definitions->end(); ++cdef)
+        delete cdef.value();
+    delete collective_definitions;
+
+    for (QMap<unsigned long long, CollectiveRecord *>::Iterator cr = collectives->begin();
+         cr != collectives->end(); ++cr)
+        delete cr.value();
+    delete collectives;
+
+    for (QVector<QMap<unsigned long long, CollectiveRecord *> *>::Iterator cmap
+         = collectiveMap->begin(); cmap != collectiveMap->end(); ++cmap)
+        delete *cmap;
+    delete collectiveMap;
+}
+
+void RawTrace::resetMatching()
+{
+    for (QVector<QVector<EventRecord *> *>::Iterator event_list = events->begin();
+         event_list != events->end(); ++event_list)
+    {
+        for (QVector<EventRecord *>::Iterator evt = (*event_list)->begin();
+             evt != (*event_list)->end(); ++evt)
+        {
+            (*evt)->children.clear();
+        }
+    }
+
+    for (int i = 0; i < num_tasks; i++)
+    {
+        for (QVector<CommRecord *>::Iterator cr = messages->at(i)->begin();
+             cr != messages->at(i)->end(); ++cr)
+        {
+            (*cr)->message = NULL;
+        }
+        for (QVector<CommRecord *>::Iterator cr = messages_r->at(i)->begin();
+             cr != messages_r->at(i)->end(); ++cr)
+        {
+            (*cr)->message = NULL;
+        }
+    }
+}
+
+int RawTrace::clipToWindow(unsigned long long start, unsigned long long end)
+{
+    // Calls open at the window start show up as leaves with no enter. The
+    // innermost is found first, so each new one goes in front. Calls still
+    // open at the end are closed there.
+    for (QVector<QVector<EventRecord *> *>::Iterator event_list
+         = events->begin(); event_list != events->end(); ++event_list)
+    {
+        QVector<EventRecord *> opened = QVector<EventRecord *>();
+        QStack<EventRecord *> stack = QStack<EventRecord *>();
+        for (QVector<EventRecord *>::Iterator evt = (*event_list)->begin();
+             evt != (*event_list)->end(); ++evt)
+        {
+            if ((*evt)->enter)
+                stack.push(*evt);
+            else if (!stack.isEmpty())
+                stack.pop();
+            else
+                opened.prepend(new EventRecord((*evt)->task, start,
+                                               (*evt)->value, true));
+        }
+
+        while (!stack.isEmpty())
+        {
+            EventRecord * bgn = stack.pop();
+            (*event_list)->append(new EventRecord(bgn->task, end, bgn->value,
+                                                  false));
+        }
+
+        if (!opened.isEmpty())
+            **event_list = opened + **event_list;
+    }
+
+    // A collective is kept only if all of its members were inside
+    QMap<CollectiveRecord *, int> members = QMap<CollectiveRecord *, int>();
+    QSet<CollectiveRecord *> dropped = QSet<CollectiveRecord *>();
+    for (QVector<QVector<CollectiveBit *> *>::Iterator bits
+         = collectiveBits->begin(); bits != collectiveBits->end(); ++bits)
+    {
+        for (QVector<CollectiveBit *>::Iterator bit = (*bits)->begin();
+             bit != (*bits)->end(); ++bit)
+        {
+            members[(*bit)->cr] += 1;
+            if ((*bit)->time < start || (*bit)->time > end)
+                dropped.insert((*bit)->cr);
+        }
+    }
+    for (QMap<CollectiveRecord *, int>::Iterator cr = members.begin();
+         cr != members.end(); ++cr)
+    {
+        TaskGroup * group = taskgroups->value(cr.key()->taskgroup);
+        if (group && cr.value() < group->tasks->size())
+            dropped.insert(cr.key());
+    }
+
+    if (!dropped.isEmpty())
+    {
+        for (int i = 0; i < collectiveBits->size(); i++)
+        {
+            QVector<CollectiveBit *> * bits = collectiveBits->at(i);
+            QVector<CollectiveBit *> kept = QVector<CollectiveBit *>();
+            for (QVector<CollectiveBit *>::Iterator bit = bits->begin();
+                 bit != bits->end(); ++bit)
+            {
+                if (dropped.contains((*bit)->cr))
+                {
+                    collectiveMap->at(i)->remove((*bit)->time);
+                    delete *bit;
+                }
+                else
+                {
+                    kept.append(*bit);
+                }
+            }
+            *bits = kept;
+        }
+
+        for (QSet<CollectiveRecord *>::Iterator cr = dropped.begin();
+             cr != dropped.end(); ++cr)
+        {
+            collectives->remove((*cr)->matchingId);
+            delete *cr;
+        }
+    }
+
+    // The importers mark messages with an end outside the window
+    QSet<CommRecord *> truncated = QSet<CommRecord *>();
+    for (int i = 0; i < num_tasks; i++)
+    {
+        QVector<CommRecord *> kept = QVector<CommRecord *>();
+        for (QVector<CommRecord *>::Iterator crec = messages->at(i)->begin();
+             crec != messages->at(i)->end(); ++crec)
+        {
+            if ((*crec)->truncated)
+                truncated.insert(*crec);
+            else
+                kept.append(*crec);
+        }
+        *(messages->at(i)) = kept;
+
+        kept.clear();
+        for (QVector<CommRecord *>::Iterator crec = messages_r->at(i)->begin();
+             crec != messages_r->at(i)->end(); ++crec)
+        {
+            if ((*crec)->truncated)
+                truncated.insert(*crec);
+            else
+                kept.append(*crec);
+        }
+        *(messages_r->at(i)) = kept;
+    }
+    for (QSet<CommRecord *>::Iterator crec = truncated.begin();
+         crec != truncated.end(); ++crec)
+    {
+        delete *crec;
+    }
+
+    std::cout << "Time window dropped " << truncated.size() << " messages and "
+              << dropped.size() << " collectives." << std::endl;
+    return truncated.size();
+}
+
+QSet<int> RawTrace::parseTaskFilter(QString filter,
+                                    QMap<int, Task *> * tasks,
+                                    QMap<int, TaskGroup *> * taskgroups)
+{
+    QSet<int> selected = QSet<int>();
+    if (tasks->isEmpty())
+        return selected;
+
+    // Ranges stop at the last rank so huge ones don't fill the set
+    int last_task = tasks->lastKey();
+    QStringList pieces = filter.split(",", QString::SkipEmptyParts);
+    bool numeric = !pieces.isEmpty();
+    for (QStringList::Iterator piece = pieces.begin();
+         piece != pieces.end() && numeric; ++piece)
+    {
+        QStringList bounds = piece->trimmed().split("-");
+        bool first_ok = false, last_ok = false;
+        int first = bounds.first().toInt(&first_ok);
+        int last = bounds.last().toInt(&last_ok);
+        if (bounds.size() > 2 || !first_ok || !last_ok || first < 0)
+            numeric = false;
+        else
+            for (int task = first; task <= std::min(last, last_task); task++)
+                if (tasks->contains(task))
+                    selected.insert(task);
+    }
+    if (numeric)
+        return selected;
+
+    // Not a rank list, look for a communicator of that name
+    selected.clear();
+    for (QMap<int, TaskGroup *>::Iterator tg = taskgroups->begin();
+         tg != taskgroups->end(); ++tg)
+    {
+        if (tg.value()->name == filter.trimmed())
+        {
+            for (QList<unsigned int>::Iterator task = tg.value()->tasks->begin();
+                 task != tg.value()->tasks->end(); ++task)
+                if (tasks->contains(*task))
+                    selected.insert(*task);
+            break;
+        }
+    }
+    return selected;
+}
+
+void RawTrace::addPartnerHops(QSet<int>& tasks,
+                              QMap<int, QSet<int> > * partners,
+                              int hops)
+{
+    QSet<int> frontier = tasks;
+    for (int hop = 0; hop < hops && !frontier.isEmpty(); hop++)
+    {
+        QSet<int> next = QSet<int>();
+        for (QSet<int>::Iterator task = frontier.begin();
+             task != frontier.end(); ++task)
+        {
+            QSet<int> task_partners = partners->value(*task);
+            for (QSet<int>::Iterator partner = task_partners.begin();
+                 partner != task_partners.end(); ++partner)
+            {
+                if (!tasks.contains(*partner))
+                    next.insert(*partner);
+            }
+        }
+        tasks.unite(next);
+        frontier = next;
+    }
+}
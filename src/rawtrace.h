@@ -28,6 +28,7 @@
 #include <QString>
 #include <QMap>
 #include <QVector>
+#include <QSet>
 #include <stdint.h>
 
 class CollectiveRecord;
@@ -49,6 +50,25 @@ public:
     RawTrace(int nt);
     ~RawTrace();
 
+    // Clear the links to events and messages a conversion left on the
+    // records, so a kept raw trace can be converted again
+    void resetMatching();
+
+    // Fix up the edges of a time-windowed import, returns the number of
+    // truncated messages dropped
+    int clipToWindow(unsigned long long start, unsigned long long end);
+
+    // Tasks named by a task subset filter, either ranks and ranges such
+    // as "0-15,32" or the name of a communicator. Only tasks that exist
+    // are returned, so it is empty if nothing matches.
+    static QSet<int> parseTaskFilter(QString filter,
+                                     QMap<int, Task *> * tasks,
+                                     QMap<int, TaskGroup *> * taskgroups);
+    // Grow a task subset by its message partners, hops rounds out
+    static void addPartnerHops(QSet<int>& tasks,
+                               QMap<int, QSet<int> > * partners,
+                               int hops);
+
     class CollectiveBit {
     public:
         CollectiveBit(uint64_t _time, CollectiveRecord * _cr)
@@ -78,6 +98,12 @@ public:
     QString from_saved_version;
     QList<QString> * metric_names;
     QMap<QString, QString> * metric_units;
+
+    // Set when kept for reprocessing, traces then get their own copies
+    bool owns_definitions;
+
+private:
+    void deleteDefinitions();
 };
 
 #endif // RAWTRACE_H
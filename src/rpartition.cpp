@@ -29,7 +29,9 @@
 #include "event.h"
 #include "commevent.h"
 #include "collectiverecord.h"
+#include "collectiveevent.h"
 #include "clustertask.h"
+#include "stridegraph.h"
 #include "general_util.h"
 
 Partition::Partition()
@@ -55,7 +57,8 @@ Partition::Partition()
       cluster_vectors(new QMap<int, QVector<long long int> *>()),
       cluster_step_starts(new QMap<int, int>()),
       debug_mark(false),
-      free_recvs(NULL)
+      free_recvs(NULL),
+      stride_graph(NULL)
 {
     group->insert(this); // We are always in our own group
 }
@@ -83,6 +86,7 @@ Partition::~Partition()
     }
     delete cluster_vectors;
     delete cluster_step_starts;
+    delete stride_graph;
 }
 
 // Call when we are sure we want to delete events held in this partition
@@ -246,6 +250,7 @@ void Partition::basic_step()
     }
 
     // Set up stride graph
+    stride_graph = new StrideGraph();
     for (QMap<int, QList<CommEvent *> *>::Iterator event_list = events->begin();
          event_list != events->end(); ++event_list)
     {
@@ -256,29 +261,62 @@ void Partition::basic_step()
         }
     }
 
-    // Set stride values
-    int current_stride, max_stride = 0;
-    QList<CollectiveRecord *> toDelete = QList<CollectiveRecord *>();
-    while (collectives->size())
+    QList<CommEvent *> stride_events = QList<CommEvent *>();
+    for (QSet<CollectiveRecord *>::Iterator cr = collectives->begin();
+         cr != collectives->end(); ++cr)
+    {
+        for (QList<CollectiveEvent *>::Iterator evt = (*cr)->events->begin();
+             evt != (*cr)->events->end(); ++evt)
+        {
+            stride_events.append(*evt);
+        }
+    }
+    stride_graph->build(stride_events);
+
+    // Set stride values. Each collective waits on the collectives before
+    // it and is set as soon as the last of them is.
+    QMap<CollectiveRecord *, int> unresolved = QMap<CollectiveRecord *, int>();
+    QList<CollectiveRecord *> ready = QList<CollectiveRecord *>();
+    for (QSet<CollectiveRecord *>::Iterator cr = collectives->begin();
+         cr != collectives->end(); ++cr)
     {
-        // Set the stride values if possible
-        for (QSet<CollectiveRecord *>::Iterator cr = collectives->begin();
-             cr != collectives->end(); ++cr)
+        int parents = 0;
+        for (QList<CollectiveEvent *>::Iterator evt = (*cr)->events->begin();
+             evt != (*cr)->events->end(); ++evt)
         {
-            current_stride = (*cr)->set_basic_strides();
-            if (current_stride > max_stride)
-                max_stride = current_stride;
-            if (current_stride)
-                toDelete.append(*cr);
+            int index = stride_graph->indexOf(*evt);
+            parents += stride_graph->lastParent(index)
+                       - stride_graph->firstParent(index);
         }
+        unresolved[*cr] = parents;
+        if (!parents)
+            ready.append(*cr);
+    }
 
-        // Delete ones we found
-        for (QList<CollectiveRecord *>::Iterator cr = toDelete.begin();
-             cr != toDelete.end(); ++cr)
+    int current_stride, max_stride = 0;
+    while (!ready.isEmpty())
+    {
+        CollectiveRecord * cr = ready.takeFirst();
+        current_stride = cr->set_basic_strides(stride_graph);
+        if (current_stride > max_stride)
+            max_stride = current_stride;
+
+        for (QList<CollectiveEvent *>::Iterator evt = cr->events->begin();
+             evt != cr->events->end(); ++evt)
         {
-            collectives->remove(*cr);
+            int index = stride_graph->indexOf(*evt);
+            for (int edge = stride_graph->firstChild(index);
+                 edge < stride_graph->lastChild(index); ++edge)
+            {
+                CommEvent * child = stride_graph->node(stride_graph->child(edge));
+                CollectiveRecord * child_cr = child->getCollective();
+                if (--unresolved[child_cr] == 0)
+                    ready.append(child_cr);
+            }
         }
     }
+    delete stride_graph;
+    stride_graph = NULL;
     delete collectives;
 
     // Inflate P2P Events between collectives
@@ -439,9 +477,10 @@ void Partition::step()
     // Build send+collective graph
     // Send dependencies go right through their receives until they find a send
     // Collectives are dependent to the rest of the collective set
-    // We use stride_parents & stride_children to create this graph
+    // We collect the edges into stride_graph for this partition
     // We set up by looking for children only and having the parents set
     // the children links
+    stride_graph = new StrideGraph();
     QList<CommEvent *> * stride_events = new QList<CommEvent *>();
     QList<CommEvent *> * recv_events = new QList<CommEvent *>();
     for (QMap<int, QList<CommEvent *> *>::Iterator event_list = events->begin();
@@ -576,74 +615,20 @@ void Partition::step()
 
 int Partition::set_stride_dag(QList<CommEvent *> * stride_events)
 {
-    QSet<CommEvent *> * current_events = new QSet<CommEvent*>();
-    QSet<CommEvent *> * next_events = new QSet<CommEvent *>();
-    // Find first stride
-    for (QList<CommEvent *>::Iterator evt = stride_events->begin();
-         evt != stride_events->end(); ++evt)
-    {
-        if ((*evt)->stride_parents->isEmpty())
-        {
-            (*evt)->stride = 0;
-            for (QSet<CommEvent *>::Iterator child = (*evt)->stride_children->begin();
-                 child != (*evt)->stride_children->end(); ++child)
-            {
-                current_events->insert(*child);
-            }
-        }
-    }
-
-    bool parentFlag;
-    int stride;
-    int max_stride = 0;
-    while (!current_events->isEmpty())
-    {
-        for (QSet<CommEvent *>::Iterator evt = current_events->begin();
-             evt != current_events->end(); ++evt)
-        {
-            parentFlag = true;
-            stride = -1;
-            for (QSet<CommEvent *>::Iterator parent = (*evt)->stride_parents->begin();
-                 parent != (*evt)->stride_parents->end(); ++parent)
-            {
-                if ((*parent)->stride < 0)
-                {
-                    next_events->insert(*parent);
-                    parentFlag = false;
-                    break;
-                }
-                else
-                {
-                    stride = std::max(stride, (*parent)->stride);
-                }
-            }
-
-            if (!parentFlag)
-                continue;
-
-            (*evt)->stride = stride + 1; // 1 over the max parent
-            if ((*evt)->stride > max_stride)
-                max_stride = (*evt)->stride;
-
-            // Add children to next_events
-            for (QSet<CommEvent *>::Iterator child = (*evt)->stride_children->begin();
-                 child != (*evt)->stride_children->end(); ++child)
-            {
-                if ((*child)->stride < 0)
-                    next_events->insert(*child);
-            }
-        }
-
-        delete current_events;
-        current_events = next_events;
-        next_events = new QSet<CommEvent *>();
-    }
-
-    delete current_events;
-    delete next_events;
+    stride_graph->build(*stride_events);
+    int max_stride = stride_graph->assignStrides();
+    delete stride_graph;
+    stride_graph = NULL;
     return max_stride;
 }
 
+// Edges come in while stepping sets up and are dropped otherwise
+void Partition::addStrideEdge(CommEvent * parent, CommEvent * child)
+{
+    if (stride_graph)
+        stride_graph->addEdge(parent, child);
+}
+
 void Partition::makeClusterVectors(QString metric)
 {
     // Clean up old
@@ -35,6 +35,7 @@ class Gnome;
 class Event;
 class CommEvent;
 class ClusterTask;
+class StrideGraph;
 
 class Partition
 {
@@ -46,6 +47,7 @@ public:
     void sortEvents();
     void step();
     void basic_step();
+    void addStrideEdge(CommEvent * parent, CommEvent * child);
 
     // Based on step
     bool operator<(const Partition &);
@@ -113,6 +115,7 @@ private:
     int set_stride_dag(QList<CommEvent *> *stride_events);
 
     QList<CommEvent *> * free_recvs;
+    StrideGraph * stride_graph; // Only while stepping
 
 };
 
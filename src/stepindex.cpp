@@ -0,0 +1,151 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+//
+// This file is part of Ravel.
+// Written by Kate Isaacs, kisaacs@acm.org, All rights reserved.
+// LLNL-CODE-663885
+//
+// For details, see https://github.com/scalability-llnl/ravel
+// Please also see the LICENSE file for our notice and the LGPL.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (as published by
+// the Free Software Foundation) version 2.1 dated February 1999.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the IMPLIED WARRANTY OF
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the terms and
+// conditions of the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//////////////////////////////////////////////////////////////////////////////
+#include "stepindex.h"
+#include <QMap>
+
+#include "event.h"
+#include "commevent.h"
+#include "rpartition.h"
+
+StepIndex::StepIndex()
+    : max_step(-1),
+      step_offsets(QVector<int>()),
+      entries(QVector<CommEvent *>()),
+      partition_reach(QVector<int>())
+{
+}
+
+StepIndex::~StepIndex()
+{
+}
+
+void StepIndex::build(QList<Partition *> * partitions, int max_global_step)
+{
+    max_step = max_global_step;
+    step_offsets = QVector<int>(max_step + 2, 0);
+    partition_reach = QVector<int>(partitions->size(), -1);
+
+    // Count events per step and how far each prefix of partitions reaches
+    int reach = -1;
+    for (int i = 0; i < partitions->size(); ++i)
+    {
+        Partition * part = partitions->at(i);
+        reach = std::max(reach, part->max_global_step);
+        partition_reach[i] = reach;
+
+        for (QMap<int, QList<CommEvent *> *>::Iterator event_list
+             = part->events->begin();
+             event_list != part->events->end(); ++event_list)
+        {
+            for (QList<CommEvent *>::Iterator evt = (event_list.value())->begin();
+                 evt != (event_list.value())->end(); ++evt)
+            {
+                if ((*evt)->step >= 0 && (*evt)->step <= max_step)
+                    ++step_offsets[(*evt)->step + 1];
+            }
+        }
+    }
+
+    for (int s = 1; s < step_offsets.size(); ++s)
+        step_offsets[s] += step_offsets[s - 1];
+
+    // Fill the buckets
+    entries = QVector<CommEvent *>(step_offsets.last(), NULL);
+    QVector<int> fill = step_offsets;
+    for (QList<Partition *>::Iterator part = partitions->begin();
+         part != partitions->end(); ++part)
+    {
+        for (QMap<int, QList<CommEvent *> *>::Iterator event_list
+             = (*part)->events->begin();
+             event_list != (*part)->events->end(); ++event_list)
+        {
+            for (QList<CommEvent *>::Iterator evt = (event_list.value())->begin();
+                 evt != (event_list.value())->end(); ++evt)
+            {
+                if ((*evt)->step >= 0 && (*evt)->step <= max_step)
+                    entries[fill[(*evt)->step]++] = *evt;
+            }
+        }
+    }
+
+    for (int s = 0; s <= max_step; ++s)
+        qSort(entries.begin() + step_offsets[s],
+              entries.begin() + step_offsets[s + 1],
+              eventTaskLessThan);
+}
+
+void StepIndex::findEvents(int bottom_step, int top_step,
+                           int first_task, int last_task,
+                           QVector<CommEvent *> * found)
+{
+    bottom_step = std::max(bottom_step, 0);
+    top_step = std::min(top_step, max_step);
+    for (int s = bottom_step; s <= top_step; ++s)
+    {
+        // Binary search for the first task in the bucket
+        int low = step_offsets[s];
+        int high = step_offsets[s + 1];
+        while (low < high)
+        {
+            int mid = (low + high) / 2;
+            if (entries[mid]->task < first_task)
+                low = mid + 1;
+            else
+                high = mid;
+        }
+
+        for (int i = low; i < step_offsets[s + 1]; ++i)
+        {
+            if (entries[i]->task > last_task)
+                break;
+            found->append(entries[i]);
+        }
+    }
+}
+
+// Returns the number of partitions if none reach that far
+int StepIndex::findPartition(int step)
+{
+    int low = 0;
+    int high = partition_reach.size();
+    while (low < high)
+    {
+        int mid = (low + high) / 2;
+        if (partition_reach[mid] < step)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    return low;
+}
+
+// Steps past either end are clamped to the ends of the index
+int StepIndex::stepOffset(int step)
+{
+    if (step_offsets.isEmpty())
+        return 0;
+    step = std::max(0, std::min(step, max_step + 1));
+    return step_offsets[step];
+}
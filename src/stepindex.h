@@ -0,0 +1,73 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+//
+// This file is part of Ravel.
+// Written by Kate Isaacs, kisaacs@acm.org, All rights reserved.
+// LLNL-CODE-663885
+//
+// For details, see https://github.com/scalability-llnl/ravel
+// Please also see the LICENSE file for our notice and the LGPL.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (as published by
+// the Free Software Foundation) version 2.1 dated February 1999.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the IMPLIED WARRANTY OF
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the terms and
+// conditions of the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//////////////////////////////////////////////////////////////////////////////
+#ifndef STEPINDEX_H
+#define STEPINDEX_H
+
+#include <QList>
+#include <QVector>
+
+class Partition;
+class CommEvent;
+
+// Index of CommEvents by global step and then task so the logical views
+// can find what falls in their viewport without walking whole partitions.
+// Each step's events are stored contiguously and sorted by task.
+class StepIndex
+{
+public:
+    StepIndex();
+    ~StepIndex();
+
+    // Partitions must already be sorted by global step
+    void build(QList<Partition *> * partitions, int max_global_step);
+
+    // Appends events with bottom_step <= step <= top_step and
+    // first_task <= task <= last_task to found, step by step.
+    void findEvents(int bottom_step, int top_step,
+                    int first_task, int last_task,
+                    QVector<CommEvent *> * found);
+
+    // Index of the first partition that reaches step
+    int findPartition(int step);
+
+    // Position of the first event at step in the step-major order, so
+    // callers can lay out per-event data that lines up with the index.
+    int stepOffset(int step);
+    int size() { return entries.size(); }
+    CommEvent * at(int i) { return entries.at(i); }
+
+private:
+    int max_step;
+
+    // Events of step s are entries[step_offsets[s]] to
+    // entries[step_offsets[s+1] - 1]
+    QVector<int> step_offsets;
+    QVector<CommEvent *> entries;
+
+    // Running maximum of max_global_step over the partition list
+    QVector<int> partition_reach;
+};
+
+#endif // STEPINDEX_H
@@ -34,6 +34,8 @@
 #include "event.h"
 #include "p2pevent.h"
 #include "collectiveevent.h"
+#include "stepindex.h"
+#include "barrenderer.h"
 #include <iostream>
 #include <cmath>
 #include <QLocale>
@@ -56,7 +58,28 @@ StepVis::StepVis(QWidget* parent, VisOptions * _options)
     blockheight(0),
     ellipse_width(0),
     ellipse_height(0),
-    overdrawYMap(new QMap<int, int>())
+    overdrawYMap(new QMap<int, int>()),
+    bundling(false),
+    bucket_tasks(1),
+    message_bundles(new QMap<MessageBundle, int>()),
+    bundles_current(false),
+    bundles_bottom(0),
+    bundles_top(0),
+    bundles_first_task(0),
+    bundles_last_task(0),
+    bundles_show(VisOptions::MSG_NONE),
+    bundles_aggregates(false),
+    bundles_selected(NULL),
+    bundle_selected_comms(new QSet<CommBundle *>()),
+    bar_renderer(new BarRenderer()),
+    bars_current(false),
+    bars_metric(""),
+    bars_aggregates(false),
+    bars_gnome(NULL),
+    bars_tasks(QList<int>()),
+    bars_colormap(NULL),
+    bars_color_low(0),
+    bars_color_high(0)
 {
 
 }
@@ -64,6 +87,11 @@ StepVis::StepVis(QWidget* parent, VisOptions * _options)
 StepVis::~StepVis()
 {
     delete overdrawYMap;
+    delete message_bundles;
+    delete bundle_selected_comms;
+
+    makeCurrent(); // GL resources go with the context
+    delete bar_renderer;
 }
 
 void StepVis::setTrace(Trace * t)
@@ -80,6 +108,9 @@ void StepVis::setTrace(Trace * t)
     startPartition = 0;
 
     maxStep = trace->global_max_step;
+    bars_current = false;
+    bars_colormap = NULL;
+    bundles_current = false;
     setupMetric();
 }
 
@@ -138,7 +169,7 @@ void StepVis::setMaxMetric(long long int new_max)
     else
         maxMetricText = systemlocale.toString(new_max) + " "
                         + trace->metric_units->value(options->metric);
-    repaint();
+    update();
 }
 
 // SLOT for coordinated step changing
@@ -157,7 +188,7 @@ void StepVis::setSteps(float start, float stop, bool jump)
     jumped = jump;
 
     if (!closed)
-        repaint();
+        update();
 }
 
 // Rectangle selection graphic
@@ -191,7 +222,7 @@ void StepVis::rightDrag(QMouseEvent * event)
         taskSpan = taskSpan * (pressy - event->y())
                       / (rect().height() - colorBarHeight);
     }
-    repaint();
+    update();
     changeSource = true;
     emit stepsChanged(startStep, startStep + stepSpan, false);
 }
@@ -231,7 +262,7 @@ void StepVis::mouseMoveEvent(QMouseEvent * event)
         mousex = event->x();
         mousey = event->y();
 
-        repaint();
+        update();
         changeSource = true;
         emit stepsChanged(startStep, startStep + stepSpan, false);
     }
@@ -241,7 +272,7 @@ void StepVis::mouseMoveEvent(QMouseEvent * event)
                           std::min(pressy, event->y()),
                           abs(pressx - event->x()),
                           abs(pressy - event->y()));
-        repaint();
+        update();
     }
     else // potential hover - check event vs aggregate event vs colorbar area
     {
@@ -258,45 +289,39 @@ void StepVis::mouseMoveEvent(QMouseEvent * event)
                                                 * (event->x() - colorbar_offset)
                                                 / (rect().width()
                                                    - 2 * colorbar_offset)));
-                repaint();
+                update();
             }
         }
         else if (options->showAggregateSteps && hover_event
-                 && drawnEvents[hover_event].contains(mousex, mousey))
+                 && drawnEvents.value(hover_event).contains(mousex, mousey))
         {
             if (!hover_aggregate && mousex
-                <= drawnEvents[hover_event].x() + stepwidth)
+                <= drawnEvents.value(hover_event).x() + stepwidth)
             {
                 hover_aggregate = true;
-                repaint();
+                update();
             }
-            else if (hover_aggregate && mousex >=  drawnEvents[hover_event].x()
+            else if (hover_aggregate && mousex >=  drawnEvents.value(hover_event).x()
                      + stepwidth)
             {
                 hover_aggregate = false;
-                repaint();
+                update();
             }
         }
         else if (hover_event == NULL
-                 || !drawnEvents[hover_event].contains(mousex, mousey))
+                 || !drawnEvents.value(hover_event).contains(mousex, mousey))
         {
-            hover_event = NULL;
-            for (QMap<Event *, QRect>::Iterator evt = drawnEvents.begin();
-                 evt != drawnEvents.end(); ++evt)
+            Event * last_hover = hover_event;
+            hover_event = drawnEvents.find(mousex, mousey);
+            hover_aggregate = false;
+            if (hover_event && options->showAggregateSteps
+                && mousex <= drawnEvents.value(hover_event).x() + stepwidth)
             {
-                if (evt.value().contains(mousex, mousey))
-                {
-                    hover_aggregate = false;
-                    if (options->showAggregateSteps && mousex
-                        <= evt.value().x() + stepwidth)
-                    {
-                        hover_aggregate = true;
-                    }
-                    hover_event = evt.key();
-                }
+                hover_aggregate = true;
             }
 
-            repaint();
+            if (hover_event != last_hover)
+                update();
         }
     }
 
@@ -323,7 +348,7 @@ void StepVis::wheelEvent(QWheelEvent * event)
         stepSpan *= scale;
         startStep = avgStep - stepSpan / 2.0;
     }
-    repaint();
+    update();
     changeSource = true;
     emit stepsChanged(startStep, startStep + stepSpan, false);
 }
@@ -331,57 +356,11 @@ void StepVis::wheelEvent(QWheelEvent * event)
 void StepVis::prepaint()
 {
     closed = false;
-    drawnEvents.clear();
-    if (jumped) // We have to redo the active_partitions
-    {
-        // We know this list is in order, so we only have to go so far
-        //int topStep = boundStep(startStep + stepSpan) + 1;
-        int bottomStep = floor(startStep) - 1;
-        Partition * part = NULL;
-        for (int i = 0; i < trace->partitions->length(); ++i)
-        {
-            part = trace->partitions->at(i);
-            if (part->max_global_step >= bottomStep)
-            {
-                startPartition = i;
-                break;
-            }
-        }
-    }
-    else // We nudge the active partitions as necessary
-    {
-        int bottomStep = floor(startStep) - 1;
-        Partition * part = NULL;
-        if (startStep < lastStartStep) // check earlier partitions
-        {
-            // Keep setting the one before until its right
-            for (int i = startPartition; i >= 0; --i)
-            {
-                part = trace->partitions->at(i);
-                if (part->max_global_step >= bottomStep)
-                {
-                    startPartition = i;
-                }
-                else
-                {
-                    break;
-                }
-            }
-        }
-        else if (startStep > lastStartStep) // check current partitions up
-        {
-            // As soon as we find one, we're good
-            for (int i = startPartition; i < trace->partitions->length(); ++i)
-            {
-                part = trace->partitions->at(i);
-                if (part->max_global_step >= bottomStep)
-                {
-                    startPartition = i;
-                    break;
-                }
-            }
-        }
-    }
+    drawnEvents.reset(rect());
+
+    // First partition we may need to draw
+    int bottomStep = floor(startStep) - 1;
+    startPartition = trace->step_index->findPartition(bottomStep);
 
     // If the metric has changed, we have to redo this
     if (trace && options->metric.compare(cacheMetric) != 0)
@@ -399,6 +378,11 @@ void StepVis::qtPaint(QPainter *painter)
     {
       paintEvents(painter);
     }
+    else if (options->showMessages != VisOptions::MSG_NONE)
+    {
+      // Bars are drawn by GL, messages go on top as bundles
+      paintMessageBundles(painter);
+    }
 
     // Always done by qt
     drawTaskLabels(painter, rect().height() - colorBarHeight,
@@ -453,28 +437,33 @@ void StepVis::drawNativeGL()
     stepwidth = width / effectiveSpan;
 
 
-    double num_events = 0;
-    Partition * part = NULL;
     int topStep = boundStep(startStep + stepSpan) + 1;
     int bottomStep = floor(startStep) - 1;
 
+    // Events of the visible steps are one run of the stored bars
+    int first = trace->step_index->stepOffset(bottomStep);
+    int last = trace->step_index->stepOffset(topStep + 1);
+    bool retained = bar_renderer->initialize();
+
     // Based on the number of events, determine how much overplotting we
-    // should do
-    for (int i = startPartition; i < trace->partitions->length(); ++i)
+    // should do. Each event is both it and its aggregate.
+    QVector<CommEvent *> visible_events = QVector<CommEvent *>();
+    double num_events;
+    if (retained)
     {
-        part = trace->partitions->at(i);
-        if (part->min_global_step > topStep)
-            break;
-        else if (part->max_global_step < bottomStep)
-            continue;
-        // Twice (each event is both it and its aggregate) of the
-        // step overlap with the view, divided by how many steps are
-        // spanned by the partition
-        double overlap = 2 * (part->max_global_step - part->min_global_step + 2
-                              - std::max(0, part->max_global_step - topStep)
-                              - std::max(0, bottomStep - part->min_global_step))
-                              / (part->max_global_step - part->min_global_step + 2);
-        num_events += part->num_events() * overlap;
+        // Assume tasks out of view hold their share of the steps' events
+        num_events = 2.0 * (last - first)
+                     * std::min(taskSpan, float(trace->num_tasks))
+                     / trace->num_tasks;
+    }
+    else
+    {
+        // Only the events in the view
+        trace->step_index->findEvents(bottomStep, topStep,
+                                      std::max(0, int(floor(startTask))),
+                                      int(ceil(startTask + taskSpan)),
+                                      &visible_events);
+        num_events = 2 * visible_events.size();
     }
 
     // 1 if an event at every step, small if less
@@ -504,6 +493,44 @@ void StepVis::drawNativeGL()
         }
     }
 
+    float maxTask = taskSpan + startTask;
+    float opacity_multiplier = 1.0;
+    if (selected_gnome && !selected_tasks.isEmpty())
+        opacity_multiplier = 0.50;
+
+    if (retained)
+    {
+        if (!bars_current || bars_metric != options->metric
+            || bars_aggregates != options->showAggregateSteps
+            || bars_gnome != selected_gnome || bars_tasks != selected_tasks)
+        {
+            buildBars();
+        }
+        if (bars_colormap != options->colormap
+            || bars_color_low != options->colormap->getMin()
+            || bars_color_high != options->colormap->getClamp())
+        {
+            bar_renderer->setColorMap(options->colormap);
+            bars_colormap = options->colormap;
+            bars_color_low = options->colormap->getMin();
+            bars_color_high = options->colormap->getClamp();
+        }
+
+        // Bars are stored by absolute step and task, so the view is
+        // just where the viewport sits in that space.
+        int bars_per_event = options->showAggregateSteps ? 2 : 1;
+        float originStep = startStep;
+        if (!(options->showAggregateSteps))
+            originStep /= 2.0;
+        bar_renderer->draw(bars_per_event * first,
+                           bars_per_event * (last - first),
+                           QPointF(originStep, -maxTask),
+                           QPointF(effectiveSpan, taskSpan),
+                           QPointF(xoffset, yoffset),
+                           opacity, opacity_multiplier);
+        return;
+    }
+
     // Generate buffers to hold each bar. We don't know how many there will
     // be since we draw one per event.
     QVector<GLfloat> bars = QVector<GLfloat>();
@@ -513,99 +540,74 @@ void StepVis::drawNativeGL()
     float x, y; // true position
     float position; // placement of task
     QColor color;
-    float maxTask = taskSpan + startTask;
-    float myopacity, opacity_multiplier = 1.0;
-    if (selected_gnome && !selected_tasks.isEmpty())
-        opacity_multiplier = 0.50;
-    for (int i = startPartition; i < trace->partitions->length(); ++i)
+    float myopacity;
+    for (QVector<CommEvent *>::Iterator evt = visible_events.begin();
+         evt != visible_events.end(); ++evt)
     {
-        part = trace->partitions->at(i);
-        if (part->min_global_step > topStep)
-            break;
-        else if (part->max_global_step < bottomStep)
-            continue;
-        for (QMap<int, QList<CommEvent *> *>::Iterator event_list = part->events->begin();
-             event_list != part->events->end(); ++event_list)
+        bool selected = false;
+        if ((*evt)->partition->gnome == selected_gnome
+            && selected_tasks.contains(proc_to_order[(*evt)->task]))
         {
-            bool selected = false;
-            if (part->gnome == selected_gnome
-                && selected_tasks.contains(proc_to_order[event_list.key()]))
-            {
-                selected = true;
-            }
-
-            position = proc_to_order[event_list.key()];
-            // Out of task span check
-            if (position < floor(startTask)
-                || position > ceil(startTask + taskSpan))
-            {
-                 continue;
-            }
-            y = (maxTask - position) * barheight - 1;
+            selected = true;
+        }
 
-            for (QList<CommEvent *>::Iterator evt = (event_list.value())->begin();
-                 evt != (event_list.value())->end(); ++evt)
-            {
-                // Out of step span test
-                if ((*evt)->step < bottomStep || (*evt)->step > topStep)
-                    continue;
+        position = proc_to_order[(*evt)->task];
+        y = (maxTask - position) * barheight - 1;
 
-                // Calculate position of this bar in float space
-                if (options->showAggregateSteps)
-                    x = ((*evt)->step - startStep) * barwidth;
-                else
-                    x = ((*evt)->step - startStep) / 2 * barwidth;
+        // Calculate position of this bar in float space
+        if (options->showAggregateSteps)
+            x = ((*evt)->step - startStep) * barwidth;
+        else
+            x = ((*evt)->step - startStep) / 2 * barwidth;
 
-                color = options->colormap->color((*(*evt)->metrics)[metric]->event);
-                if (selected)
-                    myopacity = opacity;
-                else
-                    myopacity = opacity * opacity_multiplier;
-
-                bars.append(x - xoffset);
-                bars.append(y - yoffset);
-                bars.append(x - xoffset);
-                bars.append(y + barheight + yoffset);
-                bars.append(x + barwidth + xoffset);
-                bars.append(y + barheight + yoffset);
-                bars.append(x + barwidth + xoffset);
-                bars.append(y - yoffset);
-                for (int j = 0; j < 4; ++j)
-                {
-                    colors.append(color.red() / 255.0);
-                    colors.append(color.green() / 255.0);
-                    colors.append(color.blue() / 255.0);
-                    colors.append(myopacity);
-                }
+        color = options->colormap->color((*(*evt)->metrics)[metric]->event);
+        if (selected)
+            myopacity = opacity;
+        else
+            myopacity = opacity * opacity_multiplier;
+
+        bars.append(x - xoffset);
+        bars.append(y - yoffset);
+        bars.append(x - xoffset);
+        bars.append(y + barheight + yoffset);
+        bars.append(x + barwidth + xoffset);
+        bars.append(y + barheight + yoffset);
+        bars.append(x + barwidth + xoffset);
+        bars.append(y - yoffset);
+        for (int j = 0; j < 4; ++j)
+        {
+            colors.append(color.red() / 255.0);
+            colors.append(color.green() / 255.0);
+            colors.append(color.blue() / 255.0);
+            colors.append(myopacity);
+        }
 
 
-                if (options->showAggregateSteps) // repeat!
-                {
-                    x = ((*evt)->step - startStep - 1) * barwidth;
-                    if (x + barwidth <= 0)
-                        continue;
-
-                    color = options->colormap->color((*(*evt)->metrics)[metric]->aggregate);
-
-                    bars.append(x - xoffset);
-                    bars.append(y - yoffset);
-                    bars.append(x - xoffset);
-                    bars.append(y + barheight + yoffset);
-                    bars.append(x + barwidth + xoffset);
-                    bars.append(y + barheight + yoffset);
-                    bars.append(x + barwidth + xoffset);
-                    bars.append(y - yoffset);
-                    for (int j = 0; j < 4; ++j)
-                    {
-                        colors.append(color.red() / 255.0);
-                        colors.append(color.green() / 255.0);
-                        colors.append(color.blue() / 255.0);
-                        colors.append(myopacity);
-                    }
-                }
+        if (options->showAggregateSteps) // repeat!
+        {
+            x = ((*evt)->step - startStep - 1) * barwidth;
+            if (x + barwidth <= 0)
+                continue;
 
+            color = options->colormap->color((*(*evt)->metrics)[metric]->aggregate);
+
+            bars.append(x - xoffset);
+            bars.append(y - yoffset);
+            bars.append(x - xoffset);
+            bars.append(y + barheight + yoffset);
+            bars.append(x + barwidth + xoffset);
+            bars.append(y + barheight + yoffset);
+            bars.append(x + barwidth + xoffset);
+            bars.append(y - yoffset);
+            for (int j = 0; j < 4; ++j)
+            {
+                colors.append(color.red() / 255.0);
+                colors.append(color.green() / 255.0);
+                colors.append(color.blue() / 255.0);
+                colors.append(myopacity);
             }
         }
+
     }
 
     // Draw
@@ -619,6 +621,48 @@ void StepVis::drawNativeGL()
 }
 
 
+// Upload a bar per event and aggregate in the step index's order. Steps
+// run along x and tasks down from zero along y.
+void StepVis::buildBars()
+{
+    QString metric(options->metric);
+    StepIndex * index = trace->step_index;
+    QVector<GLfloat> vertices = QVector<GLfloat>();
+    int bars_per_event = options->showAggregateSteps ? 2 : 1;
+    vertices.reserve(index->size() * bars_per_event
+                     * BarRenderer::verticesPerBar
+                     * BarRenderer::floatsPerVertex);
+
+    for (int i = 0; i < index->size(); ++i)
+    {
+        CommEvent * evt = index->at(i);
+        bool selected = evt->partition->gnome == selected_gnome
+                        && selected_tasks.contains(proc_to_order[evt->task]);
+        float y = -proc_to_order[evt->task] - 1;
+        CommEvent::MetricPair * values = (*(evt->metrics))[metric];
+
+        if (options->showAggregateSteps)
+        {
+            BarRenderer::appendBar(&vertices, evt->step, y, 1, 1,
+                                   values->event, selected);
+            BarRenderer::appendBar(&vertices, evt->step - 1, y, 1, 1,
+                                   values->aggregate, selected);
+        }
+        else
+        {
+            BarRenderer::appendBar(&vertices, evt->step / 2.0, y, 1, 1,
+                                   values->event, selected);
+        }
+    }
+    bar_renderer->setBars(vertices);
+
+    bars_current = true;
+    bars_metric = metric;
+    bars_aggregates = options->showAggregateSteps;
+    bars_gnome = selected_gnome;
+    bars_tasks = selected_tasks;
+}
+
 // Qt Event painting
 void StepVis::paintEvents(QPainter * painter)
 {
@@ -656,198 +700,328 @@ void StepVis::paintEvents(QPainter * painter)
     QSet<CommBundle *> drawComms = QSet<CommBundle *>();
     QSet<CommBundle *> selectedComms = QSet<CommBundle *>();
     painter->setPen(QPen(QColor(0, 0, 0)));
-    Partition * part = NULL;
     int topStep = boundStep(startStep + stepSpan) + 1;
     int bottomStep = floor(startStep) - 1;
+    QVector<CommEvent *> visible_events = QVector<CommEvent *>();
+    trace->step_index->findEvents(bottomStep, topStep,
+                                  std::max(0, int(floor(startTask))),
+                                  int(ceil(startTask + taskSpan)),
+                                  &visible_events);
     float myopacity, opacity = 1.0;
     if (selected_gnome && !selected_tasks.isEmpty())
         opacity = 0.50;
 
     QList<int> overdraw_tasks;
 
-    // Only do partitions in our range
-    for (int i = startPartition; i < trace->partitions->length(); ++i)
+    // Only events in our range
+    for (QVector<CommEvent *>::Iterator evt = visible_events.begin();
+         evt != visible_events.end(); ++evt)
     {
-        part = trace->partitions->at(i);
-        if (part->min_global_step > topStep)
-            break;
-        else if (part->max_global_step < bottomStep)
-            continue;
-
-        // Go through events in partition
-        for (QMap<int, QList<CommEvent *> *>::Iterator event_list
-             = part->events->begin();
-             event_list != part->events->end(); ++event_list)
+        bool selected = false;
+        if ((*evt)->partition->gnome == selected_gnome
+            && selected_tasks.contains(proc_to_order[(*evt)->task]))
         {
-            bool selected = false;
-            if (part->gnome == selected_gnome
-                && selected_tasks.contains(proc_to_order[event_list.key()]))
-            {
-                selected = true;
-            }
+            selected = true;
+        }
 
-            // Out of span test
-            position = proc_to_order[event_list.key()];
-            if (position < floor(startTask)
-                || position > ceil(startTask + taskSpan))
-            {
-                continue;
-            }
-            y = floor((position - startTask) * blockheight) + 1;
+        position = proc_to_order[(*evt)->task];
+        y = floor((position - startTask) * blockheight) + 1;
 
-            for (QList<CommEvent *>::Iterator evt = (event_list.value())->begin();
-                 evt != (event_list.value())->end(); ++evt)
-            {
-                 // Out of step span test
-                if ((*evt)->step < bottomStep || (*evt)->step > topStep)
-                {
-                    continue;
-                }
-                // 0 = startTask, effectiveHeight = stopTask (startTask + taskSpan)
-                // 0 = startStep, rect().width() = stopStep (startStep + stepSpan)
-
-                x = getX(*evt);
-                w = barwidth;
-                h = barheight;
-
-                // Corrections for partially drawn
-                complete = true;
-                if (y < 0) {
-                    h = barheight - fabs(y);
-                    y = 0;
-                    complete = false;
-                } else if (y >= effectiveHeight) {
-                    continue;
-                } else if (y + barheight > effectiveHeight) {
-                    h = effectiveHeight - y;
-                    complete = false;
-                }
-                if (x < 0) {
-                    w = barwidth + x;
-                    x = 0;
-                    complete = false;
-                } else if (x + barwidth > rect().width()) {
-                    w = rect().width() - x;
-                    complete = false;
-                }
+        // 0 = startTask, effectiveHeight = stopTask (startTask + taskSpan)
+        // 0 = startStep, rect().width() = stopStep (startStep + stepSpan)
 
-                myopacity = opacity;
-                if (selected)
-                    myopacity = 1.0;
-                painter->setPen(QPen(QColor(0, 0, 0, myopacity*255)));
-                // Draw the event
-                if ((*evt)->hasMetric(metric))
-                    painter->fillRect(QRectF(x, y, w, h),
-                                      QBrush(options->colormap->color((*evt)->getMetric(metric),
-                                                                      myopacity)));
-                else
-                    painter->fillRect(QRectF(x, y, w, h),
-                                      QBrush(QColor(180, 180, 180)));
-                // Change pen color if selected
-                if (*evt == selected_event && !selected_aggregate)
-                    painter->setPen(QPen(Qt::yellow));
-                // Draw border only if we're doing spacing, otherwise too messy
-                if (step_spacing > 0 && task_spacing > 0)
-                {
-                    if (complete)
-                        painter->drawRect(QRectF(x,y,w,h));
-                    else
-                        incompleteBox(painter, x, y, w, h, &extents);
-                }
-                // Revert pen color
-                if (*evt == selected_event && !selected_aggregate)
-                    painter->setPen(QPen(QColor(0, 0, 0)));
+        x = getX(*evt);
+        w = barwidth;
+        h = barheight;
+
+        // Corrections for partially drawn
+        complete = true;
+        if (y < 0) {
+            h = barheight - fabs(y);
+            y = 0;
+            complete = false;
+        } else if (y >= effectiveHeight) {
+            continue;
+        } else if (y + barheight > effectiveHeight) {
+            h = effectiveHeight - y;
+            complete = false;
+        }
+        if (x < 0) {
+            w = barwidth + x;
+            x = 0;
+            complete = false;
+        } else if (x + barwidth > rect().width()) {
+            w = rect().width() - x;
+            complete = false;
+        }
 
+        myopacity = opacity;
+        if (selected)
+            myopacity = 1.0;
+        painter->setPen(QPen(QColor(0, 0, 0, myopacity*255)));
+        // Draw the event
+        if ((*evt)->hasMetric(metric))
+            painter->fillRect(QRectF(x, y, w, h),
+                              QBrush(options->colormap->color((*evt)->getMetric(metric),
+                                                              myopacity)));
+        else
+            painter->fillRect(QRectF(x, y, w, h),
+                              QBrush(QColor(180, 180, 180)));
+        // Change pen color if selected
+        if (*evt == selected_event && !selected_aggregate)
+            painter->setPen(QPen(Qt::yellow));
+        // Draw border only if we're doing spacing, otherwise too messy
+        if (step_spacing > 0 && task_spacing > 0)
+        {
+            if (complete)
+                painter->drawRect(QRectF(x,y,w,h));
+            else
+                incompleteBox(painter, x, y, w, h, &extents);
+        }
+        // Revert pen color
+        if (*evt == selected_event && !selected_aggregate)
+            painter->setPen(QPen(QColor(0, 0, 0)));
 
-                // Save messages for the end since they draw on top
-                (*evt)->addComms(&drawComms);
-                if (*evt == selected_event)
-                {
-                    if (overdraw_selected)
-                        overdraw_tasks = (*evt)->neighborTasks();
-                    (*evt)->addComms(&selectedComms);
-                }
 
-                // Draw aggregate events if necessary
-                if (options->showAggregateSteps) {
-                    xa = floor(((*evt)->step - startStep - 1) * blockwidth) + 1
-                         + labelWidth;
-                    wa = barwidth;
-                    if (xa + wa <= 0)
-                        continue;
-
-                    aggcomplete = true;
-                    if (xa < 0) {
-                        wa = barwidth + xa;
-                        xa = 0;
-                        aggcomplete = false;
-                    } else if (xa + barwidth > rect().width()) {
-                        wa = rect().width() - xa;
-                        aggcomplete = false;
-                    }
-
-                    aggcomplete = aggcomplete && complete;
-                    if ((*evt)->hasMetric(metric))
-                        painter->fillRect(QRectF(xa, y, wa, h),
-                                          QBrush(options->colormap->color((*evt)->getMetric(metric,
-                                                                                            true),
-                                                                          myopacity)));
-                    else
-                        painter->fillRect(QRectF(xa, y, wa, h),
-                                          QBrush(QColor(180, 180, 180)));
-
-                    if (*evt == selected_event && selected_aggregate)
-                        painter->setPen(QPen(Qt::yellow));
-                    if (step_spacing > 0 && task_spacing > 0)
-                        if (aggcomplete)
-                            painter->drawRect(QRectF(xa, y, wa, h));
-                        else
-                            incompleteBox(painter, xa, y, wa, h, &extents);
-                    if (*evt == selected_event && selected_aggregate)
-                        painter->setPen(QPen(QColor(0, 0, 0)));
-
-                    // For selection
-                    drawnEvents[*evt] = QRect(xa, y, (x - xa) + w, h);
-                } else {
-                    // For selection
-                    drawnEvents[*evt] = QRect(x, y, w, h);
-                }
+        // Save messages for the end since they draw on top
+        (*evt)->addComms(&drawComms);
+        if (*evt == selected_event)
+        {
+            if (overdraw_selected)
+                overdraw_tasks = (*evt)->neighborTasks();
+            (*evt)->addComms(&selectedComms);
+        }
 
+        // Draw aggregate events if necessary
+        if (options->showAggregateSteps) {
+            xa = floor(((*evt)->step - startStep - 1) * blockwidth) + 1
+                 + labelWidth;
+            wa = barwidth;
+            if (xa + wa <= 0)
+                continue;
+
+            aggcomplete = true;
+            if (xa < 0) {
+                wa = barwidth + xa;
+                xa = 0;
+                aggcomplete = false;
+            } else if (xa + barwidth > rect().width()) {
+                wa = rect().width() - xa;
+                aggcomplete = false;
             }
+
+            aggcomplete = aggcomplete && complete;
+            if ((*evt)->hasMetric(metric))
+                painter->fillRect(QRectF(xa, y, wa, h),
+                                  QBrush(options->colormap->color((*evt)->getMetric(metric,
+                                                                                    true),
+                                                                  myopacity)));
+            else
+                painter->fillRect(QRectF(xa, y, wa, h),
+                                  QBrush(QColor(180, 180, 180)));
+
+            if (*evt == selected_event && selected_aggregate)
+                painter->setPen(QPen(Qt::yellow));
+            if (step_spacing > 0 && task_spacing > 0)
+                if (aggcomplete)
+                    painter->drawRect(QRectF(xa, y, wa, h));
+                else
+                    incompleteBox(painter, xa, y, wa, h, &extents);
+            if (*evt == selected_event && selected_aggregate)
+                painter->setPen(QPen(QColor(0, 0, 0)));
+
+            // For selection
+            drawnEvents.insert(*evt, QRect(xa, y, (x - xa) + w, h));
+        } else {
+            // For selection
+            drawnEvents.insert(*evt, QRect(x, y, w, h));
         }
+
     }
 
     // Messages
     // We need to do all of the message drawing after the event drawing
     // for overlap purposes
     if (options->showMessages != VisOptions::MSG_NONE)
+        paintMessages(painter, &drawComms, &selectedComms);
+
+    if (overdraw_selected)
+        overdrawSelected(painter, overdraw_tasks);
+}
+
+// Draws the comms of the events in view. If there are more than the
+// message limit (or bundle is set) the unselected ones are aggregated by
+// task bucket and step and drawn as weighted bundles instead.
+void StepVis::paintMessages(QPainter * painter,
+                            QSet<CommBundle *> * drawComms,
+                            QSet<CommBundle *> * selectedComms,
+                            bool bundle)
+{
+    if (blockwidth / 5 > 0)
+        ellipse_width = blockwidth / 5;
+    else
+        ellipse_width = 3;
+    if (blockheight / 5 > 0)
+        ellipse_height = blockheight / 5;
+    else
+        ellipse_height = 3;
+
+    bundling = bundle || drawComms->size() > options->messageLimit;
+    if (bundling)
     {
-        if (blockwidth / 5 > 0)
-            ellipse_width = blockwidth / 5;
-        else
-            ellipse_width = 3;
-        if (blockheight / 5 > 0)
-            ellipse_height = blockheight / 5;
-        else
-            ellipse_height = 3;
+        bundles_current = false;
+        message_bundles->clear();
+        bucket_tasks = std::max(1.0f, ceilf(bundlePixels / blockheight));
+    }
+
+    for (QSet<CommBundle *>::Iterator comm = drawComms->begin();
+         comm != drawComms->end(); ++comm)
+    {
+        if (!selectedComms->contains(*comm))
+            (*comm)->draw(painter, this);
+    }
 
+    if (bundling)
+    {
+        drawBundles(painter);
+        bundling = false;
+    }
+
+    // Now draw selected
+    for (QSet<CommBundle *>::Iterator comm = selectedComms->begin();
+         comm != selectedComms->end(); ++comm)
+    {
+        (*comm)->draw(painter, this);
+    }
+}
+
+// When the bars are drawn by GL there is no per-event Qt pass, so we
+// gather the comms of the visible events here and always bundle them.
+// The counts are kept while the view only moves within a step or task.
+void StepVis::paintMessageBundles(QPainter * painter)
+{
+    int effectiveHeight = rect().height() - colorBarHeight;
+    float effectiveSpan = stepSpan;
+    if (!(options->showAggregateSteps))
+        effectiveSpan /= 2.0;
+    blockheight = effectiveHeight / taskSpan;
+    blockwidth = (rect().width() - labelWidth) / effectiveSpan;
+    if (blockwidth / 5 > 0)
+        ellipse_width = blockwidth / 5;
+    else
+        ellipse_width = 3;
+    if (blockheight / 5 > 0)
+        ellipse_height = blockheight / 5;
+    else
+        ellipse_height = 3;
+
+    int topStep = boundStep(startStep + stepSpan) + 1;
+    int bottomStep = floor(startStep) - 1;
+    int firstTask = std::max(0, int(floor(startTask)));
+    int lastTask = int(ceil(startTask + taskSpan));
+    float bucket = std::max(1.0f, ceilf(bundlePixels / blockheight));
+
+    if (!bundles_current || bundles_bottom != bottomStep
+        || bundles_top != topStep || bundles_first_task != firstTask
+        || bundles_last_task != lastTask || bucket_tasks != bucket
+        || bundles_show != options->showMessages
+        || bundles_aggregates != options->showAggregateSteps
+        || bundles_selected != selected_event)
+    {
+        QVector<CommEvent *> visible_events = QVector<CommEvent *>();
+        trace->step_index->findEvents(bottomStep, topStep, firstTask,
+                                      lastTask, &visible_events);
+
+        QSet<CommBundle *> drawComms = QSet<CommBundle *>();
+        bundle_selected_comms->clear();
+        for (QVector<CommEvent *>::Iterator evt = visible_events.begin();
+             evt != visible_events.end(); ++evt)
+        {
+            (*evt)->addComms(&drawComms);
+            if (*evt == selected_event)
+                (*evt)->addComms(bundle_selected_comms);
+        }
+
+        // Count the unselected comms into their bundles
+        message_bundles->clear();
+        bucket_tasks = bucket;
+        bundling = true;
         for (QSet<CommBundle *>::Iterator comm = drawComms.begin();
              comm != drawComms.end(); ++comm)
         {
-            if (!selectedComms.contains(*comm))
+            if (!bundle_selected_comms->contains(*comm))
                 (*comm)->draw(painter, this);
         }
+        bundling = false;
+
+        bundles_current = true;
+        bundles_bottom = bottomStep;
+        bundles_top = topStep;
+        bundles_first_task = firstTask;
+        bundles_last_task = lastTask;
+        bundles_show = options->showMessages;
+        bundles_aggregates = options->showAggregateSteps;
+        bundles_selected = selected_event;
+    }
 
-        // Now draw selected
-        for (QSet<CommBundle *>::Iterator comm = selectedComms.begin();
-             comm != selectedComms.end(); ++comm)
-        {
-            (*comm)->draw(painter, this);
-        }
+    drawBundles(painter);
+
+    // Selected comms are drawn singly on top
+    for (QSet<CommBundle *>::Iterator comm = bundle_selected_comms->begin();
+         comm != bundle_selected_comms->end(); ++comm)
+    {
+        (*comm)->draw(painter, this);
     }
+}
 
-    if (overdraw_selected)
-        overdrawSelected(painter, overdraw_tasks);
+// Counts a line between two positions and steps into its bundle
+void StepVis::bundleEdge(int from_position, int from_step,
+                         int to_position, int to_step)
+{
+    MessageBundle key(int(from_position / bucket_tasks), from_step,
+                      int(to_position / bucket_tasks), to_step);
+    (*message_bundles)[key] += 1;
+}
+
+// One line per bundle from bucket center to bucket center, heavier and
+// darker the more messages it stands for
+void StepVis::drawBundles(QPainter * painter)
+{
+    if (message_bundles->isEmpty())
+        return;
+
+    int max_count = 1;
+    for (QMap<MessageBundle, int>::Iterator bundle
+         = message_bundles->begin();
+         bundle != message_bundles->end(); ++bundle)
+    {
+        if (bundle.value() > max_count)
+            max_count = bundle.value();
+    }
+
+    float max_width = 1;
+    if (taskSpan <= 32)
+        max_width = 2;
+    max_width += 2;
+
+    float w = blockwidth;
+    QPointF p1, p2;
+    for (QMap<MessageBundle, int>::Iterator bundle
+         = message_bundles->begin();
+         bundle != message_bundles->end(); ++bundle)
+    {
+        float weight = bundle.value() / float(max_count);
+        const MessageBundle &key = bundle.key();
+        p1 = QPointF(stepX(key.from_step) + w / 2.0,
+                     ((key.from_bucket + 0.5) * bucket_tasks - startTask)
+                     * blockheight + 1);
+        p2 = QPointF(stepX(key.to_step) + w / 2.0,
+                     ((key.to_bucket + 0.5) * bucket_tasks - startTask)
+                     * blockheight + 1);
+        painter->setPen(QPen(QColor(0, 0, 0, 64 + 191 * weight),
+                             1 + (max_width - 1) * weight, Qt::SolidLine));
+        drawLine(painter, &p1, &p2);
+    }
 }
 
 // Might want to use something like this to also have a lens feature
@@ -920,13 +1094,18 @@ int StepVis::getY(CommEvent * evt)
 }
 
 int StepVis::getX(CommEvent *evt)
+{
+    return stepX(evt->step);
+}
+
+int StepVis::stepX(int step)
 {
     int x = 0;
-    if (options->showAggregateSteps) // Factor these calcs into own fxn!
-        x = floor((evt->step - startStep) * blockwidth) + 1
+    if (options->showAggregateSteps)
+        x = floor((step - startStep) * blockwidth) + 1
             + labelWidth;
     else
-        x = floor((evt->step - startStep) / 2 * blockwidth) + 1
+        x = floor((step - startStep) / 2 * blockwidth) + 1
             + labelWidth;
 
     return x;
@@ -934,6 +1113,18 @@ int StepVis::getX(CommEvent *evt)
 
 void StepVis::drawMessage(QPainter * painter, Message * msg)
 {
+    if (bundling)
+    {
+        // Within step messages run from the sender's step to the next one
+        int to_step = msg->receiver->step;
+        if (options->showMessages == VisOptions::MSG_SINGLE)
+            to_step = msg->sender->step
+                      + (options->showAggregateSteps ? 1 : 2);
+        bundleEdge(proc_to_order[msg->sender->task], msg->sender->step,
+                   proc_to_order[msg->receiver->task], to_step);
+        return;
+    }
+
     int penwidth = 1;
     if (taskSpan <= 32)
         penwidth = 2;
@@ -969,6 +1160,17 @@ void StepVis::drawMessage(QPainter * painter, Message * msg)
 
 void StepVis::drawCollective(QPainter * painter, CollectiveRecord * cr)
 {
+    if (bundling)
+    {
+        // Bundle the chain of lines, skipping the markers
+        for (int i = 1; i < cr->events->size(); i++)
+            bundleEdge(proc_to_order[cr->events->at(i-1)->task],
+                       cr->events->at(i-1)->step,
+                       proc_to_order[cr->events->at(i)->task],
+                       cr->events->at(i)->step);
+        return;
+    }
+
     int root, x, y, prev_x, prev_y, root_x, root_y;
     CollectiveEvent * coll_event;
     QPointF p1, p2;
@@ -1234,7 +1436,7 @@ void StepVis::mouseDoubleClickEvent(QMouseEvent * event)
                                         * (event->x() - colorbar_offset)
                                         / (rect().width()
                                            - 2 * colorbar_offset));
-            repaint();
+            update();
         }
         else if (event->x() > rect().width() - colorbar_offset + 3
                  && event->x() < rect().width() - colorbar_offset + 3
@@ -25,10 +25,13 @@
 #ifndef STEPVIS_H
 #define STEPVIS_H
 
+#include <QSet>
 #include "timelinevis.h"
 
 class MetricRangeDialog;
 class CommEvent;
+class BarRenderer;
+class CommBundle;
 
 // Logical timeline vis
 class StepVis : public TimelineVis
@@ -59,6 +62,13 @@ protected:
     void qtPaint(QPainter *painter);
     void drawNativeGL();
     void paintEvents(QPainter *painter);
+    void paintMessages(QPainter * painter, QSet<CommBundle *> * drawComms,
+                       QSet<CommBundle *> * selectedComms,
+                       bool bundle = false);
+    void paintMessageBundles(QPainter * painter);
+    void bundleEdge(int from_position, int from_step,
+                    int to_position, int to_step);
+    void drawBundles(QPainter * painter);
     void prepaint();
     void overdrawSelected(QPainter *painter, QList<int> tasks);
     void drawColorBarGL();
@@ -72,7 +82,9 @@ protected:
     void setupMetric();
     void drawColorValue(QPainter * painter);
     int getX(CommEvent * evt);
+    int stepX(int step);
     int getY(CommEvent * evt);
+    void buildBars();
 
 private:
     double maxMetric;
@@ -88,7 +100,64 @@ private:
     int ellipse_height;
     QMap<int, int> * overdrawYMap;
 
+    // Messages between the same task buckets and steps, counted so they
+    // can be drawn as one line when there are too many to draw singly
+    class MessageBundle {
+    public:
+        MessageBundle(int _from_bucket, int _from_step,
+                      int _to_bucket, int _to_step)
+            : from_bucket(_from_bucket), from_step(_from_step),
+              to_bucket(_to_bucket), to_step(_to_step) {}
+
+        bool operator<(const MessageBundle &other) const
+        {
+            if (from_step != other.from_step)
+                return from_step < other.from_step;
+            if (to_step != other.to_step)
+                return to_step < other.to_step;
+            if (from_bucket != other.from_bucket)
+                return from_bucket < other.from_bucket;
+            return to_bucket < other.to_bucket;
+        }
+
+        int from_bucket;
+        int from_step;
+        int to_bucket;
+        int to_step;
+    };
+    bool bundling; // drawMessage/drawCollective count rather than draw
+    float bucket_tasks; // tasks per bundle bucket
+    QMap<MessageBundle, int> * message_bundles;
+
+    // Bundles gathered for the GL path, kept until the steps, tasks or
+    // bucket size in view change so hover repaints only draw them.
+    bool bundles_current;
+    int bundles_bottom;
+    int bundles_top;
+    int bundles_first_task;
+    int bundles_last_task;
+    VisOptions::MessageType bundles_show;
+    bool bundles_aggregates;
+    Event * bundles_selected;
+    QSet<CommBundle *> * bundle_selected_comms;
+
+    // Bars for every event kept on the GL side, laid out in step index
+    // order and rebuilt only when what they show changes.
+    BarRenderer * bar_renderer;
+    bool bars_current;
+    QString bars_metric;
+    bool bars_aggregates;
+    Gnome * bars_gnome;
+    QList<int> bars_tasks;
+
+    // Colormap last given to the bar renderer, uploaded again only when
+    // the map or its range changes
+    ColorMap * bars_colormap;
+    double bars_color_low;
+    double bars_color_high;
+
     static const int colorBarHeight = 24;
+    static const int bundlePixels = 8; // height of a bundle bucket
 };
 
 #endif // STEPVIS_H
@@ -0,0 +1,159 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+//
+// This file is part of Ravel.
+// Written by Kate Isaacs, kisaacs@acm.org, All rights reserved.
+// LLNL-CODE-663885
+//
+// For details, see https://github.com/scalability-llnl/ravel
+// Please also see the LICENSE file for our notice and the LGPL.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (as published by
+// the Free Software Foundation) version 2.1 dated February 1999.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the IMPLIED WARRANTY OF
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the terms and
+// conditions of the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//////////////////////////////////////////////////////////////////////////////
+#include "stridegraph.h"
+#include <QPair>
+#include <QtAlgorithms>
+#include <algorithm>
+
+#include "commevent.h"
+
+StrideGraph::StrideGraph()
+    : edge_parents(QVector<CommEvent *>()),
+      edge_children(QVector<CommEvent *>()),
+      node_list(QVector<CommEvent *>()),
+      parent_offsets(QVector<int>()),
+      parent_nodes(QVector<int>()),
+      child_offsets(QVector<int>()),
+      child_nodes(QVector<int>())
+{
+}
+
+StrideGraph::~StrideGraph()
+{
+}
+
+void StrideGraph::addEdge(CommEvent * parent, CommEvent * child)
+{
+    edge_parents.append(parent);
+    edge_children.append(child);
+}
+
+void StrideGraph::build(const QList<CommEvent *>& nodes)
+{
+    node_list = nodes.toVector();
+    qSort(node_list.begin(), node_list.end());
+
+    // Edges as index pairs, sorted so duplicates are adjacent
+    QVector<QPair<int, int> > edges = QVector<QPair<int, int> >();
+    edges.reserve(edge_parents.size());
+    for (int i = 0; i < edge_parents.size(); ++i)
+    {
+        int from = indexOf(edge_parents[i]);
+        int to = indexOf(edge_children[i]);
+        if (from >= 0 && to >= 0)
+            edges.append(QPair<int, int>(from, to));
+    }
+    edge_parents = QVector<CommEvent *>();
+    edge_children = QVector<CommEvent *>();
+    qSort(edges);
+
+    int num_nodes = node_list.size();
+    parent_offsets = QVector<int>(num_nodes + 1, 0);
+    child_offsets = QVector<int>(num_nodes + 1, 0);
+    int num_edges = 0;
+    for (int i = 0; i < edges.size(); ++i)
+    {
+        if (i > 0 && edges[i] == edges[i - 1])
+            continue;
+        ++child_offsets[edges[i].first + 1];
+        ++parent_offsets[edges[i].second + 1];
+        edges[num_edges++] = edges[i];
+    }
+    edges.resize(num_edges);
+
+    for (int i = 0; i < num_nodes; ++i)
+    {
+        child_offsets[i + 1] += child_offsets[i];
+        parent_offsets[i + 1] += parent_offsets[i];
+    }
+
+    // Edges are sorted by parent, so children fill in order
+    child_nodes = QVector<int>(num_edges);
+    parent_nodes = QVector<int>(num_edges);
+    QVector<int> fill = parent_offsets;
+    for (int i = 0; i < num_edges; ++i)
+    {
+        child_nodes[i] = edges[i].second;
+        parent_nodes[fill[edges[i].second]++] = edges[i].first;
+    }
+}
+
+int StrideGraph::indexOf(CommEvent * evt)
+{
+    QVector<CommEvent *>::Iterator found = qLowerBound(node_list.begin(),
+                                                       node_list.end(),
+                                                       evt);
+    if (found == node_list.end() || *found != evt)
+        return -1;
+    return found - node_list.begin();
+}
+
+// Nodes are released a frontier at a time as their last parent is set.
+// Nodes on a cycle are never released and keep their stride.
+int StrideGraph::assignStrides()
+{
+    int num_nodes = node_list.size();
+    QVector<int> waiting = QVector<int>(num_nodes);
+    QVector<int> current = QVector<int>();
+    QVector<int> next = QVector<int>();
+    for (int i = 0; i < num_nodes; ++i)
+    {
+        waiting[i] = lastParent(i) - firstParent(i);
+        if (!waiting[i])
+        {
+            node_list[i]->stride = 0;
+            current.append(i);
+        }
+    }
+
+    int max_stride = 0;
+    while (!current.isEmpty())
+    {
+        for (QVector<int>::Iterator index = current.begin();
+             index != current.end(); ++index)
+        {
+            for (int edge = firstChild(*index); edge < lastChild(*index);
+                 ++edge)
+            {
+                int next_index = child(edge);
+                if (--waiting[next_index])
+                    continue;
+
+                int stride = -1;
+                for (int up = firstParent(next_index);
+                     up < lastParent(next_index); ++up)
+                {
+                    stride = std::max(stride, node_list[parent(up)]->stride);
+                }
+                node_list[next_index]->stride = stride + 1;
+                max_stride = std::max(max_stride, stride + 1);
+                next.append(next_index);
+            }
+        }
+        current.swap(next);
+        next.clear();
+    }
+    return max_stride;
+}
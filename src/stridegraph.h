@@ -0,0 +1,75 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+//
+// This file is part of Ravel.
+// Written by Kate Isaacs, kisaacs@acm.org, All rights reserved.
+// LLNL-CODE-663885
+//
+// For details, see https://github.com/scalability-llnl/ravel
+// Please also see the LICENSE file for our notice and the LGPL.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (as published by
+// the Free Software Foundation) version 2.1 dated February 1999.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the IMPLIED WARRANTY OF
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the terms and
+// conditions of the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//////////////////////////////////////////////////////////////////////////////
+#ifndef STRIDEGRAPH_H
+#define STRIDEGRAPH_H
+
+#include <QList>
+#include <QVector>
+
+class CommEvent;
+
+// Stride dependencies of one partition while it is being stepped. Edges
+// are gathered as a flat list and then packed into compressed arrays of
+// parents and children per node, so no event carries its own sets.
+class StrideGraph
+{
+public:
+    StrideGraph();
+    ~StrideGraph();
+
+    void addEdge(CommEvent * parent, CommEvent * child);
+
+    // Packs the edges among nodes. Edges touching other events and
+    // duplicate edges are dropped.
+    void build(const QList<CommEvent *>& nodes);
+
+    int size() { return node_list.size(); }
+    int indexOf(CommEvent * evt);
+    CommEvent * node(int index) { return node_list.at(index); }
+
+    // Edges of node i are [firstParent(i), lastParent(i)) and so on
+    int firstParent(int index) { return parent_offsets.at(index); }
+    int lastParent(int index) { return parent_offsets.at(index + 1); }
+    int parent(int edge) { return parent_nodes.at(edge); }
+    int firstChild(int index) { return child_offsets.at(index); }
+    int lastChild(int index) { return child_offsets.at(index + 1); }
+    int child(int edge) { return child_nodes.at(edge); }
+
+    // Sets each node's stride one past its highest parent, with nodes
+    // lacking parents at zero. Returns the highest stride.
+    int assignStrides();
+
+private:
+    QVector<CommEvent *> edge_parents;
+    QVector<CommEvent *> edge_children;
+
+    QVector<CommEvent *> node_list; // sorted for lookup
+    QVector<int> parent_offsets;
+    QVector<int> parent_nodes;
+    QVector<int> child_offsets;
+    QVector<int> child_nodes;
+};
+
+#endif // STRIDEGRAPH_H
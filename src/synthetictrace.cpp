@@ -0,0 +1,345 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+//
+// This file is part of Ravel.
+// Written by Kate Isaacs, kisaacs@acm.org, All rights reserved.
+// LLNL-CODE-663885
+//
+// For details, see https://github.com/scalability-llnl/ravel
+// Please also see the LICENSE file for our notice and the LGPL.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (as published by
+// the Free Software Foundation) version 2.1 dated February 1999.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the IMPLIED WARRANTY OF
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the terms and
+// conditions of the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//////////////////////////////////////////////////////////////////////////////
+#include "synthetictrace.h"
+#include <QVector>
+#include <QStringList>
+
+static OTF2_FlushType synthetic_pre_flush(void * userData,
+                                          OTF2_FileType fileType,
+                                          OTF2_LocationRef location,
+                                          void * callerData,
+                                          bool final)
+{
+    Q_UNUSED(userData);
+    Q_UNUSED(fileType);
+    Q_UNUSED(location);
+    Q_UNUSED(callerData);
+    Q_UNUSED(final);
+    return OTF2_FLUSH;
+}
+
+static OTF2_TimeStamp synthetic_post_flush(void * userData,
+                                           OTF2_FileType fileType,
+                                           OTF2_LocationRef location)
+{
+    Q_UNUSED(userData);
+    Q_UNUSED(fileType);
+    Q_UNUSED(location);
+    return 0;
+}
+
+SyntheticTrace::SyntheticTrace(Pattern _pattern, int _ranks, int _iterations,
+                               int _depth)
+    : pattern(_pattern),
+      ranks(_ranks),
+      iterations(_iterations),
+      depth(_depth),
+      event_counts(QList<uint64_t>())
+{
+}
+
+QString SyntheticTrace::patternName(Pattern pattern)
+{
+    switch (pattern)
+    {
+    case SP_STENCIL:
+        return "stencil";
+    case SP_ALLTOALL:
+        return "alltoall";
+    case SP_MASTERWORKER:
+        return "masterworker";
+    case SP_ISENDBURST:
+        return "isendburst";
+    case SP_COLLECTIVE:
+        return "collective";
+    }
+    return "";
+}
+
+bool SyntheticTrace::patternFromName(QString name, Pattern * pattern)
+{
+    QList<Pattern> patterns = allPatterns();
+    for (QList<Pattern>::Iterator p = patterns.begin(); p != patterns.end(); ++p)
+        if (patternName(*p) == name)
+        {
+            *pattern = *p;
+            return true;
+        }
+    return false;
+}
+
+QList<SyntheticTrace::Pattern> SyntheticTrace::allPatterns()
+{
+    QList<Pattern> patterns = QList<Pattern>();
+    patterns << SP_STENCIL << SP_ALLTOALL << SP_MASTERWORKER << SP_ISENDBURST
+             << SP_COLLECTIVE;
+    return patterns;
+}
+
+// Number of communication slots in each iteration
+int SyntheticTrace::slots()
+{
+    switch (pattern)
+    {
+    case SP_STENCIL:
+        return 4;
+    case SP_ALLTOALL:
+        return 2 * (ranks - 1);
+    case SP_MASTERWORKER:
+        return 2 * (ranks - 1) + 2;
+    case SP_ISENDBURST:
+        return 2 * qMin(int(burst_width), ranks - 1) + 1;
+    case SP_COLLECTIVE:
+        return 3;
+    }
+    return 0;
+}
+
+QList<SyntheticTrace::Operation> SyntheticTrace::operations(int rank)
+{
+    QList<Operation> ops = QList<Operation>();
+    if (ranks < 2 && pattern != SP_COLLECTIVE)
+        return ops;
+
+    int left = (rank - 1 + ranks) % ranks;
+    int right = (rank + 1) % ranks;
+    int workers = ranks - 1;
+    int width = qMin(int(burst_width), ranks - 1);
+    switch (pattern)
+    {
+    case SP_STENCIL:
+        ops << Operation(SR_SEND, right, 0) << Operation(SR_SEND, left, 1)
+            << Operation(SR_RECV, left, 2) << Operation(SR_RECV, right, 3);
+        break;
+    case SP_ALLTOALL:
+        for (int i = 1; i < ranks; i++)
+            ops << Operation(SR_SEND, (rank + i) % ranks, i - 1);
+        for (int i = 1; i < ranks; i++)
+            ops << Operation(SR_RECV, (rank - i + ranks) % ranks,
+                             ranks - 2 + i);
+        break;
+    case SP_MASTERWORKER:
+        // Work goes out in order, each result comes back in a later slot
+        if (rank == 0)
+        {
+            for (int w = 1; w <= workers; w++)
+                ops << Operation(SR_SEND, w, w - 1);
+            for (int w = 1; w <= workers; w++)
+                ops << Operation(SR_RECV, w, workers + w + 1);
+        }
+        else
+        {
+            ops << Operation(SR_RECV, 0, rank)
+                << Operation(SR_SEND, 0, workers + rank);
+        }
+        break;
+    case SP_ISENDBURST:
+        for (int i = 1; i <= width; i++)
+            ops << Operation(SR_ISEND, (rank + i) % ranks, i - 1);
+        for (int i = 1; i <= width; i++)
+            ops << Operation(SR_RECV, (rank - i + ranks) % ranks,
+                             width + i - 1);
+        ops << Operation(SR_WAITALL, width, 2 * width);
+        break;
+    case SP_COLLECTIVE:
+        ops << Operation(SR_ALLREDUCE, 0, 0) << Operation(SR_BCAST, 0, 1)
+            << Operation(SR_ALLREDUCE, 0, 2);
+        break;
+    }
+    return ops;
+}
+
+// Small deterministic spread so ranks are not perfectly in step
+OTF2_TimeStamp SyntheticTrace::jitter(int rank, int iteration, int salt)
+{
+    quint32 x = rank * 7919u + iteration * 104729u + salt * 15485863u;
+    x ^= x >> 13;
+    x *= 0x5bd1e995u;
+    x ^= x >> 15;
+    return x;
+}
+
+void SyntheticTrace::writeRank(OTF2_EvtWriter * writer, int rank)
+{
+    QList<Operation> ops = operations(rank);
+    OTF2_TimeStamp period = compute_length + (slots() + 1) * slot_length
+                            + 4 * depth + 20;
+    uint64_t request = 0;
+
+    OTF2_EvtWriter_Enter(writer, NULL, 1, SR_MAIN);
+    for (int it = 0; it < iterations; it++)
+    {
+        OTF2_TimeStamp start = 10 + it * period;
+        for (int level = 0; level < depth; level++)
+            OTF2_EvtWriter_Enter(writer, NULL, start + 2 * level,
+                                 SR_LEVEL + level);
+
+        OTF2_TimeStamp compute = start + 2 * depth;
+        OTF2_EvtWriter_Enter(writer, NULL, compute, SR_COMPUTE);
+        OTF2_EvtWriter_Leave(writer, NULL, compute + compute_length
+                             - jitter(rank, it, 0) % 300, SR_COMPUTE);
+
+        // A send in a slot always lands before a receive in any later slot
+        OTF2_TimeStamp base = compute + compute_length + 10;
+        uint64_t first_request = request;
+        for (QList<Operation>::Iterator op = ops.begin(); op != ops.end(); ++op)
+        {
+            OTF2_TimeStamp enter = base + op->slot * slot_length
+                                   + jitter(rank, it, op->slot + 1) % 40;
+            OTF2_TimeStamp exit = enter + 50;
+            OTF2_EvtWriter_Enter(writer, NULL, enter, op->region);
+            switch (op->region)
+            {
+            case SR_SEND:
+                OTF2_EvtWriter_MpiSend(writer, NULL, enter + 5, op->peer,
+                                       0, 0, 1024);
+                break;
+            case SR_RECV:
+                OTF2_EvtWriter_MpiRecv(writer, NULL, exit - 5, op->peer,
+                                       0, 0, 1024);
+                break;
+            case SR_ISEND:
+                OTF2_EvtWriter_MpiIsend(writer, NULL, enter + 5, op->peer,
+                                        0, 0, 1024, request++);
+                break;
+            case SR_WAITALL:
+                for (uint64_t r = first_request; r < request; r++)
+                    OTF2_EvtWriter_MpiIsendComplete(writer, NULL,
+                                                    enter + 5 + (r - first_request),
+                                                    r);
+                break;
+            case SR_ALLREDUCE:
+            case SR_BCAST:
+                OTF2_EvtWriter_MpiCollectiveBegin(writer, NULL, enter + 1);
+                OTF2_EvtWriter_MpiCollectiveEnd(writer, NULL, exit - 1,
+                                                op->region == SR_BCAST
+                                                ? OTF2_COLLECTIVE_OP_BCAST
+                                                : OTF2_COLLECTIVE_OP_ALLREDUCE,
+                                                0,
+                                                op->region == SR_BCAST
+                                                ? op->peer
+                                                : OTF2_UNDEFINED_UINT32,
+                                                1024, 1024);
+                break;
+            }
+            OTF2_EvtWriter_Leave(writer, NULL, exit, op->region);
+        }
+
+        for (int level = depth - 1; level >= 0; level--)
+            OTF2_EvtWriter_Leave(writer, NULL, start + period - 2 - 2 * level,
+                                 SR_LEVEL + level);
+    }
+    OTF2_EvtWriter_Leave(writer, NULL, 10 + iterations * period, SR_MAIN);
+}
+
+void SyntheticTrace::writeDefinitions(OTF2_GlobalDefWriter * writer,
+                                      OTF2_TimeStamp end)
+{
+    OTF2_GlobalDefWriter_WriteClockProperties(writer, 1000000000, 0, end + 1);
+
+    QStringList names = QStringList();
+    names << "main" << "compute" << "MPI_Send" << "MPI_Recv" << "MPI_Isend"
+          << "MPI_Waitall" << "MPI_Allreduce" << "MPI_Bcast";
+    for (int level = 0; level < depth; level++)
+        names << QString("level_%1").arg(level);
+    int num_regions = names.size();
+    names << "MPI_COMM_WORLD";
+    for (int rank = 0; rank < ranks; rank++)
+        names << QString("MPI Rank %1").arg(rank);
+
+    // String 0 is left empty, region i is named by string i + 1
+    OTF2_GlobalDefWriter_WriteString(writer, 0, "");
+    for (int i = 0; i < names.size(); i++)
+        OTF2_GlobalDefWriter_WriteString(writer, i + 1,
+                                         names.at(i).toStdString().c_str());
+
+    for (int region = 0; region < num_regions; region++)
+        OTF2_GlobalDefWriter_WriteRegion(writer, region, region + 1, 0, 0,
+                                         OTF2_REGION_ROLE_FUNCTION,
+                                         names.at(region).startsWith("MPI_")
+                                         ? OTF2_PARADIGM_MPI
+                                         : OTF2_PARADIGM_UNKNOWN,
+                                         OTF2_REGION_FLAG_NONE, 0, 0, 0);
+
+    int world_name = num_regions + 1;
+    QVector<uint64_t> members = QVector<uint64_t>(ranks);
+    for (int rank = 0; rank < ranks; rank++)
+    {
+        members[rank] = rank;
+        OTF2_GlobalDefWriter_WriteLocationGroup(writer, rank,
+                                                world_name + 1 + rank,
+                                                OTF2_LOCATION_GROUP_TYPE_PROCESS,
+                                                0);
+        OTF2_GlobalDefWriter_WriteLocation(writer, rank, world_name + 1 + rank,
+                                           OTF2_LOCATION_TYPE_CPU_THREAD,
+                                           event_counts.at(rank), rank);
+    }
+
+    OTF2_GlobalDefWriter_WriteGroup(writer, 0, world_name,
+                                    OTF2_GROUP_TYPE_COMM_LOCATIONS,
+                                    OTF2_PARADIGM_MPI, OTF2_GROUP_FLAG_NONE,
+                                    ranks, members.constData());
+    OTF2_GlobalDefWriter_WriteComm(writer, 0, world_name, 0,
+                                   OTF2_UNDEFINED_COMM);
+}
+
+bool SyntheticTrace::write(QString path, QString filename)
+{
+    OTF2_Archive * archive = OTF2_Archive_Open(path.toStdString().c_str(),
+                                               filename.toStdString().c_str(),
+                                               OTF2_FILEMODE_WRITE,
+                                               1024 * 1024, 4 * 1024 * 1024,
+                                               OTF2_SUBSTRATE_POSIX,
+                                               OTF2_COMPRESSION_NONE);
+    if (!archive)
+        return false;
+
+    OTF2_FlushCallbacks flush_callbacks;
+    flush_callbacks.otf2_pre_flush = synthetic_pre_flush;
+    flush_callbacks.otf2_post_flush = synthetic_post_flush;
+    OTF2_Archive_SetFlushCallbacks(archive, &flush_callbacks, NULL);
+    OTF2_Archive_SetSerialCollectiveCallbacks(archive);
+
+    // Events first so the location definitions can carry their counts
+    event_counts.clear();
+    OTF2_TimeStamp end = 10 + iterations * (compute_length
+                                            + (slots() + 1) * slot_length
+                                            + 4 * depth + 20);
+    OTF2_Archive_OpenEvtFiles(archive);
+    for (int rank = 0; rank < ranks; rank++)
+    {
+        OTF2_EvtWriter * writer = OTF2_Archive_GetEvtWriter(archive, rank);
+        writeRank(writer, rank);
+        uint64_t count = 0;
+        OTF2_EvtWriter_GetNumberOfEvents(writer, &count);
+        event_counts.append(count);
+        OTF2_Archive_CloseEvtWriter(archive, writer);
+    }
+    OTF2_Archive_CloseEvtFiles(archive);
+
+    writeDefinitions(OTF2_Archive_GetGlobalDefWriter(archive), end);
+
+    return OTF2_Archive_Close(archive) == OTF2_SUCCESS;
+}
@@ -0,0 +1,87 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+//
+// This file is part of Ravel.
+// Written by Kate Isaacs, kisaacs@acm.org, All rights reserved.
+// LLNL-CODE-663885
+//
+// For details, see https://github.com/scalability-llnl/ravel
+// Please also see the LICENSE file for our notice and the LGPL.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (as published by
+// the Free Software Foundation) version 2.1 dated February 1999.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the IMPLIED WARRANTY OF
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the terms and
+// conditions of the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//////////////////////////////////////////////////////////////////////////////
+#ifndef SYNTHETICTRACE_H
+#define SYNTHETICTRACE_H
+
+#include <QString>
+#include <QList>
+#include <otf2/otf2.h>
+
+// Writes OTF2 archives with a regular MPI communication pattern so import
+// and structure extraction can be measured at any scale. Every rank runs
+// the same number of iterations, each a nest of calls `depth` deep around
+// a compute region followed by the pattern's communication.
+class SyntheticTrace
+{
+public:
+    enum Pattern { SP_STENCIL, SP_ALLTOALL, SP_MASTERWORKER, SP_ISENDBURST,
+                   SP_COLLECTIVE };
+
+    SyntheticTrace(Pattern _pattern, int _ranks, int _iterations,
+                   int _depth);
+
+    // Writes path/filename.otf2, returns false if OTF2 reports an error
+    bool write(QString path, QString filename);
+
+    static QString patternName(Pattern pattern);
+    static bool patternFromName(QString name, Pattern * pattern);
+    static QList<Pattern> allPatterns();
+
+    Pattern pattern;
+    int ranks;
+    int iterations;
+    int depth;
+
+private:
+    // One MPI call in an iteration. Calls are placed in slots that are the
+    // same on every rank so sends always precede their receives.
+    class Operation {
+    public:
+        Operation(int _region, int _peer, int _slot)
+            : region(_region), peer(_peer), slot(_slot) {}
+
+        int region;
+        int peer; // rank for point-to-point, root for collectives
+        int slot;
+    };
+
+    enum Region { SR_MAIN, SR_COMPUTE, SR_SEND, SR_RECV, SR_ISEND,
+                  SR_WAITALL, SR_ALLREDUCE, SR_BCAST, SR_LEVEL };
+
+    QList<Operation> operations(int rank);
+    int slots();
+    OTF2_TimeStamp jitter(int rank, int iteration, int salt);
+    void writeRank(OTF2_EvtWriter * writer, int rank);
+    void writeDefinitions(OTF2_GlobalDefWriter * writer,
+                          OTF2_TimeStamp end);
+
+    QList<uint64_t> event_counts;
+
+    static const int burst_width = 4;
+    static const OTF2_TimeStamp slot_length = 100;
+    static const OTF2_TimeStamp compute_length = 1000;
+};
+
+#endif // SYNTHETICTRACE_H
@@ -0,0 +1,87 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+//
+// This file is part of Ravel.
+// Written by Kate Isaacs, kisaacs@acm.org, All rights reserved.
+// LLNL-CODE-663885
+//
+// For details, see https://github.com/scalability-llnl/ravel
+// Please also see the LICENSE file for our notice and the LGPL.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (as published by
+// the Free Software Foundation) version 2.1 dated February 1999.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the IMPLIED WARRANTY OF
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the terms and
+// conditions of the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//////////////////////////////////////////////////////////////////////////////
+#include "tilecache.h"
+#include <cmath>
+
+uint qHash(const TileKey& key)
+{
+    return qHash(key.trace) ^ qHash(key.metric)
+           ^ qHash(qint64(key.time_scale * 1024)) ^ qHash(key.x)
+           ^ (qHash(key.y) << 8) ^ qHash(int(key.task_scale * 16));
+}
+
+TileCache::TileCache(int _capacity)
+    : capacity(_capacity),
+      tiles(QHash<TileKey, QImage>()),
+      order(QList<TileKey>())
+{
+}
+
+QImage TileCache::get(const TileKey& key)
+{
+    if (!tiles.contains(key))
+        return QImage();
+
+    order.removeOne(key);
+    order.append(key);
+    return tiles.value(key);
+}
+
+void TileCache::insert(const TileKey& key, const QImage& tile)
+{
+    if (tiles.contains(key))
+        order.removeOne(key);
+    tiles.insert(key, tile);
+    order.append(key);
+
+    while (order.size() > capacity)
+        tiles.remove(order.takeFirst());
+}
+
+void TileCache::removeTask(Trace * trace, float position)
+{
+    QList<TileKey>::Iterator key = order.begin();
+    while (key != order.end())
+    {
+        float top = position * key->task_scale;
+        float bottom = top + key->task_scale;
+        if (key->trace == trace && top < (key->y + 1) * tileSize
+            && bottom >= key->y * tileSize)
+        {
+            tiles.remove(*key);
+            key = order.erase(key);
+        }
+        else
+        {
+            ++key;
+        }
+    }
+}
+
+void TileCache::clear()
+{
+    tiles.clear();
+    order.clear();
+}
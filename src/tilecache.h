@@ -0,0 +1,91 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+//
+// This file is part of Ravel.
+// Written by Kate Isaacs, kisaacs@acm.org, All rights reserved.
+// LLNL-CODE-663885
+//
+// For details, see https://github.com/scalability-llnl/ravel
+// Please also see the LICENSE file for our notice and the LGPL.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (as published by
+// the Free Software Foundation) version 2.1 dated February 1999.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the IMPLIED WARRANTY OF
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the terms and
+// conditions of the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//////////////////////////////////////////////////////////////////////////////
+#ifndef TILECACHE_H
+#define TILECACHE_H
+
+#include <QHash>
+#include <QList>
+#include <QImage>
+#include <QString>
+
+class Trace;
+
+// Which tile of which drawing. Time runs along x and tasks down y, each
+// tile covering size pixels at the given scales.
+class TileKey
+{
+public:
+    TileKey()
+        : trace(NULL), metric(""), color_low(0), color_high(0),
+          time_scale(0), task_scale(0), x(0), y(0) {}
+
+    bool operator==(const TileKey& other) const
+    {
+        return trace == other.trace && metric == other.metric
+               && color_low == other.color_low
+               && color_high == other.color_high
+               && time_scale == other.time_scale
+               && task_scale == other.task_scale
+               && x == other.x && y == other.y;
+    }
+
+    Trace * trace;
+    QString metric; // empty when the drawing is not metric colored
+    double color_low; // colormap range, if metric colored
+    double color_high;
+    double time_scale; // time units per pixel
+    float task_scale; // pixels per task
+    qint64 x;
+    int y;
+};
+
+uint qHash(const TileKey& key);
+
+// Least recently used cache of drawn tiles, so panning only has to draw
+// what has just come into view.
+class TileCache
+{
+public:
+    TileCache(int _capacity = 192);
+
+    static const int tileSize = 256;
+
+    bool contains(const TileKey& key) { return tiles.contains(key); }
+
+    // Null image if missing. Marks the tile as just used.
+    QImage get(const TileKey& key);
+    void insert(const TileKey& key, const QImage& tile);
+
+    // Drop tiles whose rows include the task at position
+    void removeTask(Trace * trace, float position);
+    void clear();
+
+private:
+    int capacity;
+    QHash<TileKey, QImage> tiles;
+    QList<TileKey> order; // least recently used first
+};
+
+#endif // TILECACHE_H
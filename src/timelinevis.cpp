@@ -101,58 +101,55 @@ void TimelineVis::mouseDoubleClickEvent(QMouseEvent * event)
 
     int x = event->x();
     int y = event->y();
-    for (QMap<Event *, QRect>::Iterator evt = drawnEvents.begin();
-         evt != drawnEvents.end(); ++evt)
+    Event * clicked = drawnEvents.find(x, y);
+    if (clicked) // We've found the event
     {
-        if (evt.value().contains(x,y)) // We've found the event
+        QRect clicked_rect = drawnEvents.value(clicked);
+        if (clicked == selected_event) // We were in this event
         {
-            if (evt.key() == selected_event) // We were in this event
+            if (options->showAggregateSteps)
             {
-                if (options->showAggregateSteps)
+                // we're in the aggregate event
+                if (x < clicked_rect.x() + clicked_rect.width() / 2)
                 {
-                    // we're in the aggregate event
-                    if (x < evt.value().x() + evt.value().width() / 2)
+                    if (selected_aggregate)
                     {
-                        if (selected_aggregate)
-                        {
-                            selected_event = NULL;
-                            selected_aggregate = false;
-                        }
-                        else
-                        {
-                            selected_aggregate = true;
-                        }
+                        selected_event = NULL;
+                        selected_aggregate = false;
                     }
-                    else // We're in the normal event
+                    else
                     {
-                        if (selected_aggregate)
-                        {
-                            selected_aggregate = false;
-                        }
-                        else
-                        {
-                            selected_event = NULL;
-                        }
+                        selected_aggregate = true;
                     }
                 }
-                else
-                    selected_event = NULL;
-            }
-            else // This is a new event to us
-            {
-                // we're in the aggregate event
-                if (options->showAggregateSteps
-                    && x < evt.value().x() + evt.value().width() / 2)
-                {
-                    selected_aggregate = true;
-                }
-                else
+                else // We're in the normal event
                 {
-                    selected_aggregate = false;
+                    if (selected_aggregate)
+                    {
+                        selected_aggregate = false;
+                    }
+                    else
+                    {
+                        selected_event = NULL;
+                    }
                 }
-                selected_event = evt.key();
             }
-            break;
+            else
+                selected_event = NULL;
+        }
+        else // This is a new event to us
+        {
+            // we're in the aggregate event
+            if (options->showAggregateSteps
+                && x < clicked_rect.x() + clicked_rect.width() / 2)
+            {
+                selected_aggregate = true;
+            }
+            else
+            {
+                selected_aggregate = false;
+            }
+            selected_event = clicked;
         }
     }
 
@@ -165,7 +162,7 @@ void TimelineVis::mouseDoubleClickEvent(QMouseEvent * event)
 
     changeSource = true;
     emit eventClicked(selected_event, selected_aggregate, overdraw_selected);
-    repaint();
+    update();
 }
 
 
@@ -214,7 +211,7 @@ void TimelineVis::selectEvent(Event * event, bool aggregate, bool overdraw)
         return;
     }
     if (!closed)
-        repaint();
+        update();
 }
 
 void TimelineVis::selectTasks(QList<int> tasks, Gnome * gnome)
@@ -227,7 +224,7 @@ void TimelineVis::selectTasks(QList<int> tasks, Gnome * gnome)
         return;
     }
     if (!closed)
-        repaint();
+        update();
 }
 
 void TimelineVis::drawHover(QPainter * painter)
@@ -0,0 +1,245 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+//
+// This file is part of Ravel.
+// Written by Kate Isaacs, kisaacs@acm.org, All rights reserved.
+// LLNL-CODE-663885
+//
+// For details, see https://github.com/scalability-llnl/ravel
+// Please also see the LICENSE file for our notice and the LGPL.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (as published by
+// the Free Software Foundation) version 2.1 dated February 1999.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the IMPLIED WARRANTY OF
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the terms and
+// conditions of the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//////////////////////////////////////////////////////////////////////////////
+#include "timepyramid.h"
+#include <climits>
+#include <algorithm>
+
+#include "event.h"
+#include "packedcalls.h"
+
+TimePyramid::TimePyramid()
+    : minTime(0),
+      maxTime(0),
+      bin_span(1),
+      num_bins(0),
+      num_levels(0),
+      group(1),
+      level_offsets(QVector<int>()),
+      summaries(QVector<QVector<TimeBin> >())
+{
+}
+
+TimePyramid::~TimePyramid()
+{
+}
+
+void TimePyramid::build(QVector<QVector<Event *> *> * roots)
+{
+    int num_tasks = roots->size();
+    summaries.clear();
+    level_offsets.clear();
+    num_bins = 0;
+    num_levels = 0;
+    group = 1;
+
+    // Time bounds of the call trees
+    minTime = ULLONG_MAX;
+    maxTime = 0;
+    for (QVector<QVector<Event *> *>::Iterator task_roots = roots->begin();
+         task_roots != roots->end(); ++task_roots)
+    {
+        for (QVector<Event *>::Iterator root = (*task_roots)->begin();
+             root != (*task_roots)->end(); ++root)
+        {
+            if ((*root)->enter < minTime)
+                minTime = (*root)->enter;
+            if ((*root)->exit > maxTime)
+                maxTime = (*root)->exit;
+        }
+    }
+    if (num_tasks == 0 || minTime >= maxTime)
+        return;
+
+    // Finest level gets the largest power of two in budget but never
+    // fewer than min_bins, tasks are grouped instead
+    num_bins = min_bins;
+    while (num_bins < max_bins
+           && 2 * qint64(num_bins) * 2 * num_tasks <= bin_budget)
+    {
+        num_bins *= 2;
+    }
+    while (2 * qint64(num_bins) * ((num_tasks + group - 1) / group)
+           > bin_budget)
+    {
+        group *= 2;
+    }
+    bin_span = (maxTime - minTime) / num_bins + 1;
+    summaries = QVector<QVector<TimeBin> >((num_tasks + group - 1) / group);
+
+    int total = 0;
+    for (int bins = num_bins; bins > 0; bins /= 2)
+    {
+        level_offsets.append(total);
+        total += bins;
+        ++num_levels;
+    }
+
+    for (int row = 0; row < summaries.size(); ++row)
+    {
+        QVector<TimeBin> * bins = &(summaries[row]);
+        bins->resize(total);
+
+        int last_task = std::min(num_tasks, (row + 1) * group);
+        for (int task = row * group; task < last_task; ++task)
+        {
+            QVector<Event *> * task_roots = roots->at(task);
+            for (QVector<Event *>::Iterator root = task_roots->begin();
+                 root != task_roots->end(); ++root)
+            {
+                addSegments(*root, bins);
+            }
+        }
+
+        // Each coarser bin keeps whichever of its two halves shows more
+        for (int level = 1; level < num_levels; ++level)
+        {
+            int fine = level_offsets[level - 1];
+            int coarse = level_offsets[level];
+            for (int i = 0; i < numBins(level); ++i)
+            {
+                const TimeBin& left = bins->at(fine + 2 * i);
+                const TimeBin& right = bins->at(fine + 2 * i + 1);
+                TimeBin merged = (right.time > left.time) ? right : left;
+                if (left.function == right.function
+                    && left.depth == right.depth)
+                {
+                    merged.time = left.time + right.time;
+                }
+                (*bins)[coarse + i] = merged;
+            }
+        }
+    }
+}
+
+// Split evt into the stretches where it is the deepest event showing.
+// Communication events are drawn separately on top, so the time
+// under them is counted toward their caller.
+void TimePyramid::addSegments(Event * evt, QVector<TimeBin> * bins)
+{
+    if (evt->isCommEvent())
+        return;
+    if (evt->isPacked())
+    {
+        addPackedSegments(static_cast<PackedCalls *>(evt), bins);
+        return;
+    }
+
+    unsigned long long start = evt->enter;
+    for (QVector<Event *>::Iterator child = evt->callees->begin();
+         child != evt->callees->end(); ++child)
+    {
+        if ((*child)->isCommEvent())
+            continue;
+
+        addTime(evt->function, evt->depth, start, (*child)->enter, bins);
+        addSegments(*child, bins);
+        start = (*child)->exit;
+    }
+    addTime(evt->function, evt->depth, start, evt->exit, bins);
+}
+
+// The same over decoded calls. Gaps between the calls of the run belong
+// to the caller.
+void TimePyramid::addPackedSegments(PackedCalls * packed,
+                                   QVector<TimeBin> * bins)
+{
+    QVector<PackedCalls::Call> calls = QVector<PackedCalls::Call>();
+    packed->decode(&calls);
+
+    QVector<unsigned long long> starts = QVector<unsigned long long>();
+    starts.reserve(calls.size());
+    unsigned long long run_start = packed->enter;
+    for (int i = 0; i < calls.size(); ++i)
+    {
+        const PackedCalls::Call& call = calls.at(i);
+        starts.append(call.enter);
+        if (call.parent >= 0)
+        {
+            const PackedCalls::Call& parent = calls.at(call.parent);
+            addTime(parent.function, parent.depth, starts.at(call.parent),
+                    call.enter, bins);
+            starts[call.parent] = call.exit;
+        }
+        else
+        {
+            if (packed->caller)
+                addTime(packed->caller->function, packed->caller->depth,
+                        run_start, call.enter, bins);
+            run_start = call.exit;
+        }
+    }
+
+    for (int i = 0; i < calls.size(); ++i)
+        addTime(calls.at(i).function, calls.at(i).depth, starts.at(i),
+                calls.at(i).exit, bins);
+}
+
+void TimePyramid::addTime(int function, int depth, unsigned long long start,
+                          unsigned long long stop, QVector<TimeBin> * bins)
+{
+    if (stop <= start)
+        return;
+
+    int first = binIndex(0, start);
+    int last = binIndex(0, stop - 1);
+    for (int i = first; i <= last; ++i)
+    {
+        unsigned long long bin_start = binStart(0, i);
+        unsigned long long overlap = std::min(stop, bin_start + bin_span)
+                                     - std::max(start, bin_start);
+
+        TimeBin& bin = (*bins)[i];
+        if (bin.function == function && bin.depth == depth)
+        {
+            bin.time += overlap;
+        }
+        else if (overlap > bin.time)
+        {
+            bin.function = function;
+            bin.depth = depth;
+            bin.time = overlap;
+        }
+    }
+}
+
+int TimePyramid::findLevel(double max_bin_time)
+{
+    int level = -1;
+    for (int i = 0; i < num_levels; ++i)
+    {
+        if ((bin_span << i) > max_bin_time)
+            break;
+        level = i;
+    }
+    return level;
+}
+
+int TimePyramid::binIndex(int level, unsigned long long time)
+{
+    if (time <= minTime)
+        return 0;
+    int index = (time - minTime) / (bin_span << level);
+    return std::min(index, numBins(level) - 1);
+}
@@ -0,0 +1,95 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+//
+// This file is part of Ravel.
+// Written by Kate Isaacs, kisaacs@acm.org, All rights reserved.
+// LLNL-CODE-663885
+//
+// For details, see https://github.com/scalability-llnl/ravel
+// Please also see the LICENSE file for our notice and the LGPL.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (as published by
+// the Free Software Foundation) version 2.1 dated February 1999.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the IMPLIED WARRANTY OF
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the terms and
+// conditions of the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//////////////////////////////////////////////////////////////////////////////
+#ifndef TIMEPYRAMID_H
+#define TIMEPYRAMID_H
+
+#include <QVector>
+
+class Event;
+class PackedCalls;
+
+// Per-task summary of the call tree in physical time, at several
+// resolutions like a mipmap. Each bin holds the function (and its depth)
+// that shows the most in that stretch of time so a zoomed out physical
+// timeline can be drawn without walking the call trees. With many tasks,
+// runs of consecutive tasks share one row of bins so the time resolution
+// stays fine enough to use.
+class TimePyramid
+{
+public:
+    TimePyramid();
+    ~TimePyramid();
+
+    class TimeBin {
+    public:
+        TimeBin()
+            : function(-1), depth(-1), time(0) {}
+
+        int function; // -1 for nothing drawn
+        int depth;
+        unsigned long long time; // how much of the bin function covers
+    };
+
+    void build(QVector<QVector<Event *> *> * roots);
+
+    // Coarsest level with bins no longer than max_bin_time, or -1 if
+    // even the finest level is too coarse to stand in for real events.
+    int findLevel(double max_bin_time);
+
+    int numBins(int level) { return num_bins >> level; }
+    unsigned long long binStart(int level, int index)
+        { return minTime + (bin_span << level) * index; }
+    int binIndex(int level, unsigned long long time);
+    const TimeBin& bin(int task, int level, int index)
+        { return summaries[task / group].at(level_offsets[level] + index); }
+
+    // Tasks summarized together, a power of two
+    int taskGroup() { return group; }
+
+private:
+    void addSegments(Event * evt, QVector<TimeBin> * bins);
+    void addPackedSegments(PackedCalls * packed, QVector<TimeBin> * bins);
+    void addTime(int function, int depth, unsigned long long start,
+                 unsigned long long stop, QVector<TimeBin> * bins);
+
+    unsigned long long minTime;
+    unsigned long long maxTime;
+    unsigned long long bin_span; // time covered by a finest level bin
+    int num_bins; // at the finest level
+    int num_levels;
+    int group; // tasks per row of bins
+    QVector<int> level_offsets;
+
+    // All levels of a task, finest first
+    QVector<QVector<TimeBin> > summaries;
+
+    // Bins per row: at least enough for a zoomed out view to be a bin a
+    // pixel, at most max_bins. Rows are grouped to keep all bins in budget.
+    static const int min_bins = 1024;
+    static const int max_bins = 4096;
+    static const int bin_budget = 1 << 22;
+};
+
+#endif // TIMEPYRAMID_H
@@ -26,7 +26,6 @@
 
 #include <iostream>
 #include <fstream>
-#include <QElapsedTimer>
 #include <QTime>
 #include <cmath>
 #include <climits>
@@ -36,7 +35,9 @@
 #include "event.h"
 #include "commevent.h"
 #include "p2pevent.h"
+#include "message.h"
 #include "collectiveevent.h"
+#include "packedcalls.h"
 #include "function.h"
 #include "rpartition.h"
 #include "otfimportoptions.h"
@@ -44,6 +45,12 @@
 #include "exchangegnome.h"
 #include "taskgroup.h"
 #include "otfcollective.h"
+#include "stepindex.h"
+#include "timepyramid.h"
+#include "hotspotindex.h"
+#include "processingprofile.h"
+#include "rawtrace.h"
+#include "callstore.h"
 #include "general_util.h"
 
 Trace::Trace(int nt)
@@ -67,9 +74,19 @@ Trace::Trace(int nt)
       roots(new QVector<QVector<Event *> *>(nt)),
       mpi_group(-1),
       global_max_step(-1),
+      step_times(new QVector<StepTime>()),
+      min_time(ULLONG_MAX),
+      max_time(0),
       dag_entries(new QList<Partition *>()),
       dag_step_dict(new QMap<int, QSet<Partition *> *>()),
-      isProcessed(false)
+      step_index(new StepIndex()),
+      time_pyramid(new TimePyramid()),
+      hotspots(new HotspotIndex()),
+      profile(new ProcessingProfile()),
+      rawtrace(NULL),
+      call_store(NULL),
+      isProcessed(false),
+      step_metric_totals(new QMap<QString, QVector<double> *>())
 {
     for (int i = 0; i < nt; i++) {
         (*events)[i] = new QVector<Event *>();
@@ -102,6 +119,28 @@ Trace::~Trace()
     }
     delete partitions;
 
+    // Messages are shared by their sender and receiver, so gather them
+    // once before the events go
+    QSet<Message *> messages = QSet<Message *>();
+    for (QVector<QVector<Event *> *>::Iterator eitr = events->begin();
+         eitr != events->end(); ++eitr)
+    {
+        for (QVector<Event *>::Iterator itr = (*eitr)->begin();
+             itr != (*eitr)->end(); ++itr)
+        {
+            if ((*itr)->isCommEvent() && static_cast<CommEvent *>(*itr)->isP2P())
+            {
+                QVector<Message *> * evt_messages
+                        = static_cast<P2PEvent *>(*itr)->getMessages();
+                for (QVector<Message *>::Iterator msg = evt_messages->begin();
+                     msg != evt_messages->end(); ++msg)
+                {
+                    messages.insert(*msg);
+                }
+            }
+        }
+    }
+
     for (QVector<QVector<Event *> *>::Iterator eitr = events->begin();
          eitr != events->end(); ++eitr)
     {
@@ -115,6 +154,7 @@ Trace::~Trace()
         *eitr = NULL;
     }
     delete events;
+    qDeleteAll(messages);
 
     // Don't need to delete Events, they were deleted above
     for (QVector<QVector<Event *> *>::Iterator eitr = roots->begin();
@@ -161,7 +201,21 @@ Trace::~Trace()
 
     delete dag_entries;
     delete dag_step_dict;
-
+    delete step_times;
+    delete step_index;
+    delete time_pyramid;
+    delete hotspots;
+    delete profile;
+    delete rawtrace;
+    delete call_store; // After the packed calls that point at it
+
+    for (QMap<QString, QVector<double> *>::Iterator totals
+         = step_metric_totals->begin();
+         totals != step_metric_totals->end(); ++totals)
+    {
+        delete totals.value();
+    }
+    delete step_metric_totals;
 
     for (QMap<int, Task *>::Iterator comm = tasks->begin();
          comm != tasks->end(); ++comm)
@@ -169,43 +223,28 @@ Trace::~Trace()
         delete *comm;
         *comm = NULL;
     }
-    delete taskgroups;
+    delete tasks;
 }
 
 void Trace::preprocess(OTFImportOptions * _options)
 {
-    QElapsedTimer traceTimer;
-    qint64 traceElapsed;
-
-    traceTimer.start();
+    ProfileScope scope(profile, "Structure Extraction");
 
+    // ravel-bench times these same calls one at a time
     options = *_options;
     partition();
     assignSteps();
-
-    emit(startClustering());
-    std::cout << "Gnomifying..." << std::endl;
-    if (options.cluster)
-        gnomify();
-
-    qSort(partitions->begin(), partitions->end(),
-          dereferencedLessThan<Partition>);
+    clusterTasks();
+    compactCallTrees();
+    buildIndexes();
     addPartitionMetric(); // For debugging
 
     isProcessed = true;
-
-    traceElapsed = traceTimer.nsecsElapsed();
-    std::cout << "Structure Extraction: ";
-    gu_printTime(traceElapsed);
-    std::cout << std::endl;
 }
 
 void Trace::preprocessFromSaved()
 {
-    QElapsedTimer traceTimer;
-    qint64 traceElapsed;
-
-    traceTimer.start();
+    ProfileScope scope(profile, "Gnome/Cluster Etc");
 
     // Sets partition-to-partition connectors and min/max steps
 
@@ -220,22 +259,197 @@ void Trace::preprocessFromSaved()
     set_partition_dag();
     //std::cout << "Setting the dag steps.." << std::endl;
     //set_dag_steps();
+    setStepTimes();
+
+    clusterTasks();
+    compactCallTrees();
+    buildIndexes();
+
+    isProcessed = true;
+}
+
+// Only the clustering options changed, so keep the partitions and steps
+// and make their gnomes again
+void Trace::recluster(OTFImportOptions * _options)
+{
+    options.cluster = _options->cluster;
+    options.seedClusters = _options->seedClusters;
+    options.clusterSeed = _options->clusterSeed;
+
+    for (QList<Partition *>::Iterator part = partitions->begin();
+         part != partitions->end(); ++part)
+    {
+        delete (*part)->gnome;
+        (*part)->gnome = NULL;
+    }
 
+    // The profile keeps only the latest clustering
+    for (int i = profile->phases.size() - 1; i >= 0; i--)
+        if (profile->phases[i].name == "Gnomification/Clustering")
+            profile->phases.removeAt(i);
 
+    int num_metrics = metrics->size();
+    clusterTasks();
+
+    // Clustering for the first time adds the Gnome metric
+    if (metrics->size() != num_metrics)
+        hotspots->build(step_index, metrics);
+}
+
+void Trace::clusterTasks()
+{
     emit(startClustering());
     std::cout << "Gnomifying..." << std::endl;
     if (options.cluster)
         gnomify();
+}
 
+// Everything the views look events up by
+void Trace::buildIndexes()
+{
+    int phase = profile->beginPhase("View Indexes");
     qSort(partitions->begin(), partitions->end(),
           dereferencedLessThan<Partition>);
+    step_index->build(partitions, global_max_step);
+    time_pyramid->build(roots);
+    hotspots->build(step_index, metrics);
+    profile->endPhase(phase);
+}
 
-    isProcessed = true;
+// Replace the calls with nothing communicating below them by packed runs
+// so they cost a few bytes each. Everything on the way down to a
+// communication event is still an Event. When paging, each run goes to
+// disk as soon as it is packed. Only done when the options ask for it.
+void Trace::compactCallTrees()
+{
+    if (!options.compactCallTrees && !options.pageCallTrees)
+        return;
+
+    int phase = profile->beginPhase("Call Tree Packing");
+    if (options.pageCallTrees && !call_store)
+    {
+        call_store = new CallStore(qint64(options.callTreeBudget) << 20);
+        if (!call_store->open())
+        {
+            std::cout << "Could not open a page file, packed calls stay in memory"
+                      << std::endl;
+            delete call_store;
+            call_store = NULL;
+        }
+    }
+
+    int num_packed = 0;
+    for (int task = 0; task < num_tasks; ++task)
+    {
+        QVector<Event *> * task_events = events->at(task);
+        QSet<Event *> keep = QSet<Event *>();
+        for (QVector<Event *>::Iterator evt = task_events->begin();
+             evt != task_events->end(); ++evt)
+        {
+            if (!(*evt)->isCommEvent())
+                continue;
+
+            Event * above = (*evt)->caller;
+            while (above && !keep.contains(above))
+            {
+                keep.insert(above);
+                above = above->caller;
+            }
+        }
+
+        QSet<Event *> packed = QSet<Event *>();
+        QVector<Event *> stubs = QVector<Event *>();
+        packCalls(roots->at(task), NULL, keep, &packed, &stubs);
+        if (packed.isEmpty())
+            continue;
+
+        // The task's list owns its events, so it trades them for the stubs
+        QVector<Event *> * kept = new QVector<Event *>();
+        kept->reserve(task_events->size() - packed.size() + stubs.size());
+        for (QVector<Event *>::Iterator evt = task_events->begin();
+             evt != task_events->end(); ++evt)
+        {
+            if (packed.contains(*evt))
+                delete *evt;
+            else
+                kept->append(*evt);
+        }
+        *kept += stubs;
+        delete task_events;
+        (*events)[task] = kept;
+        num_packed += packed.size();
+    }
+    profile->setCounter("Packed calls", num_packed);
+    if (call_store)
+        profile->setCounter("Paged call bytes", call_store->bytesStored());
+    profile->endPhase(phase);
+}
+
+void Trace::packCalls(QVector<Event *> * calls, Event * caller,
+                      const QSet<Event *>& keep, QSet<Event *> * packed,
+                      QVector<Event *> * stubs)
+{
+    QVector<Event *> kept = QVector<Event *>();
+    QVector<Event *> run = QVector<Event *>();
+    for (QVector<Event *>::Iterator call = calls->begin();
+         call != calls->end(); ++call)
+    {
+        if ((*call)->isPacked() && call_store)
+            static_cast<PackedCalls *>(*call)->pageOut(call_store);
 
-    traceElapsed = traceTimer.nsecsElapsed();
-    std::cout << "Gnome/Cluster Etc: ";
-    gu_printTime(traceElapsed);
-    std::cout << std::endl;
+        if ((*call)->isCommEvent() || (*call)->isPacked()
+            || keep.contains(*call))
+        {
+            packRun(run, caller, &kept, packed, stubs);
+            run.clear();
+            kept.append(*call);
+            packCalls((*call)->callees, *call, keep, packed, stubs);
+        }
+        else
+        {
+            run.append(*call);
+        }
+    }
+    packRun(run, caller, &kept, packed, stubs);
+    *calls = kept;
+}
+
+// A lone leaf is left alone, packing it would not save anything
+void Trace::packRun(const QVector<Event *>& run, Event * caller,
+                    QVector<Event *> * kept, QSet<Event *> * packed,
+                    QVector<Event *> * stubs)
+{
+    if (run.isEmpty())
+        return;
+    if (run.size() == 1 && run.first()->callees->isEmpty())
+    {
+        kept->append(run.first());
+        return;
+    }
+
+    PackedCalls * stub = new PackedCalls(caller, run.first()->task,
+                                         run.first()->depth);
+    QStack<Event *> below = QStack<Event *>();
+    for (QVector<Event *>::ConstIterator call = run.constBegin();
+         call != run.constEnd(); ++call)
+    {
+        stub->append(*call);
+        below.push(*call);
+    }
+    while (!below.isEmpty())
+    {
+        Event * evt = below.pop();
+        packed->insert(evt);
+        for (QVector<Event *>::Iterator child = evt->callees->begin();
+             child != evt->callees->end(); ++child)
+        {
+            below.push(*child);
+        }
+    }
+    if (call_store)
+        stub->pageOut(call_store);
+    kept->append(stub);
+    stubs->append(stub);
 }
 
 // Check every gnome in our set for matching and set which gnome as a metric
@@ -243,10 +457,7 @@ void Trace::preprocessFromSaved()
 // easily parallelized by partition
 void Trace::gnomify()
 {
-    QElapsedTimer traceTimer;
-    qint64 traceElapsed;
-
-    traceTimer.start();
+    ProfileScope scope(profile, "Gnomification/Clustering");
 
     if (!options.seedClusters)
     {
@@ -256,7 +467,9 @@ void Trace::gnomify()
     }
     std::cout << "Clustering seed: " << options.clusterSeed << std::endl;
 
-    if (options.origin != OTFImportOptions::OF_SAVE_OTF2)
+    // Saved traces and snapshots already carry the Gnome metric
+    bool set_gnome_metric = !metrics->contains("Gnome");
+    if (set_gnome_metric)
     {
         metrics->append("Gnome");
         (*metric_units)["Gnome"] = "";
@@ -280,7 +493,7 @@ void Trace::gnomify()
                 (*part)->gnome->set_seed(options.clusterSeed);
                 (*part)->gnome->setPartition(*part);
                 (*part)->gnome->setFunctions(functions);
-                if (options.origin != OTFImportOptions::OF_SAVE_OTF2)
+                if (set_gnome_metric)
                     setGnomeMetric(*part, i);
                 (*part)->gnome->preprocess();
                 break;
@@ -293,18 +506,13 @@ void Trace::gnomify()
             (*part)->gnome->set_seed(options.clusterSeed);
             (*part)->gnome->setPartition(*part);
             (*part)->gnome->setFunctions(functions);
-            if (options.origin != OTFImportOptions::OF_SAVE_OTF2)
+            if (set_gnome_metric)
                 setGnomeMetric(*part, -1);
             (*part)->gnome->preprocess();
         }
         total += stepPortion * num_steps;
         emit(updateClustering(total));
     }
-
-    traceElapsed = traceTimer.nsecsElapsed();
-    std::cout << "Gnomification/Clustering: ";
-    gu_printTime(traceElapsed);
-    std::cout << std::endl;
 }
 
 void Trace::setGnomeMetric(Partition * part, int gnome_index)
@@ -347,59 +555,50 @@ void Trace::addPartitionMetric()
 
 void Trace::partition()
 {
-    QElapsedTimer traceTimer;
-    qint64 traceElapsed;
-
     // Partition - default - we assume base partitions done
     // at the converter stage, now we have to do a lot of merging
     if (!options.partitionByFunction)
     {
-        traceTimer.start();
+        profile->setCounter("Partitions before merging", partitions->size());
+
           // Merge communication
         std::cout << "Merging for messages..." << std::endl;
+        int phase = profile->beginPhase("Message Merge");
         mergeForMessages();
-        traceElapsed = traceTimer.nsecsElapsed();
-        std::cout << "Message Merge: ";
-        gu_printTime(traceElapsed);
-        std::cout << std::endl;
+        profile->endPhase(phase);
+        profile->setCounter("Partitions after Message Merge", partitions->size());
         std::cout << "Partitions = " << partitions->size() << std::endl;
 
           // Tarjan
         std::cout << "Merging cycles..." << std::endl;
-        traceTimer.start();
+        phase = profile->beginPhase("Cycle Merge");
         mergeCycles();
-        traceElapsed = traceTimer.nsecsElapsed();
-        std::cout << "Cycle Merge: ";
-        gu_printTime(traceElapsed);
-        std::cout << std::endl;
+        profile->endPhase(phase);
+        profile->setCounter("Partitions after Cycle Merge", partitions->size());
         std::cout << "Partitions = " << partitions->size() << std::endl;
 
         // Merge by call tree
       if (options.callerMerge)
       {
           std::cout << "Merging based on call tree..." << std::endl;
-          traceTimer.start();
+          phase = profile->beginPhase("Caller Merge");
           set_dag_steps();
           mergeByCommonCaller();
-          traceElapsed = traceTimer.nsecsElapsed();
-          std::cout << "Caller Merge: ";
-          gu_printTime(traceElapsed);
-          std::cout << std::endl;
-
+          profile->endPhase(phase);
+          profile->setCounter("Partitions after Caller Merge",
+                              partitions->size());
       }
 
           // Merge by rank level [ later ]
         if (options.leapMerge)
         {
             std::cout << "Merging to complete leaps..." << std::endl;
-            traceTimer.start();
+            phase = profile->beginPhase("Leap Merge");
             set_dag_steps();
             mergeByLeap();
-            traceElapsed = traceTimer.nsecsElapsed();
-            std::cout << "Leap Merge: ";
-            gu_printTime(traceElapsed);
-            std::cout << std::endl;
-
+            profile->endPhase(phase);
+            profile->setCounter("Partitions after Leap Merge",
+                                partitions->size());
         }
     }
 
@@ -414,6 +613,41 @@ void Trace::partition()
     }
 }
 
+// Time bounds of each global step and of the whole trace, so the views
+// can go between steps and time without scanning events
+void Trace::setStepTimes()
+{
+    step_times->fill(StepTime(), std::max(global_max_step / 2 + 1, 0));
+    min_time = ULLONG_MAX;
+    max_time = 0;
+    int step;
+    for (QList<Partition *>::Iterator part = partitions->begin();
+         part != partitions->end(); ++part)
+    {
+        for (QMap<int, QList<CommEvent *> *>::Iterator event_list
+             = (*part)->events->begin(); event_list != (*part)->events->end();
+             ++event_list)
+        {
+            for (QList<CommEvent *>::Iterator evt = event_list.value()->begin();
+                 evt != event_list.value()->end(); ++evt)
+            {
+                if ((*evt)->enter < min_time)
+                    min_time = (*evt)->enter;
+                if ((*evt)->exit > max_time)
+                    max_time = (*evt)->exit;
+
+                step = (*evt)->step / 2;
+                if ((*evt)->step < 0 || step >= step_times->size())
+                    continue;
+                if ((*step_times)[step].start > (*evt)->enter)
+                    (*step_times)[step].start = (*evt)->enter;
+                if ((*step_times)[step].stop < (*evt)->exit)
+                    (*step_times)[step].stop = (*evt)->exit;
+            }
+        }
+    }
+}
+
 void Trace::set_global_steps()
 {
     QSet<Partition *> * current_leap = new QSet<Partition *>();
@@ -736,11 +970,8 @@ void Trace::calculate_lateness()
 void Trace::assignSteps()
 {
     // Step
-    QElapsedTimer traceTimer;
-    qint64 traceElapsed;
-
-    traceTimer.start();
     std::cout << "Assigning local steps" << std::endl;
+    int phase = profile->beginPhase("Local Stepping");
     int progressPortion = std::max(round(partitions->size() / 1.0
                                          / steps_portion),
                                    1.0);
@@ -774,39 +1005,33 @@ void Trace::assignSteps()
             (*partition)->basic_step();
         }
     }
-    traceElapsed = traceTimer.nsecsElapsed();
-    std::cout << "Local Stepping: ";
-    gu_printTime(traceElapsed);
-    std::cout << std::endl;
+    profile->endPhase(phase);
 
     std::cout << "Setting global steps..." << std::endl;
-    traceTimer.start();
+    phase = profile->beginPhase("Global Stepping");
 
     set_global_steps();
 
     if (options.globalMerge)
         mergeGlobalSteps();
 
-    traceElapsed = traceTimer.nsecsElapsed();
-    std::cout << "Global Stepping: ";
-    gu_printTime(traceElapsed);
-    std::cout << std::endl;
+    setStepTimes();
+    profile->endPhase(phase);
+    profile->setCounter("Partitions", partitions->size());
+    profile->setCounter("Steps", global_max_step + 1);
     std::cout << "Num partitions " << partitions->length() << std::endl;
 
 
     // Calculate Step metrics
     std::cout << "Calculating lateness..." << std::endl;
-    traceTimer.start();
+    phase = profile->beginPhase("Lateness Calculation");
 
     calculate_lateness();
     calculate_differential_lateness("D.G. Lateness", "G. Lateness");
     calculate_partition_lateness();
     calculate_differential_lateness("D. Lateness", "Lateness");
 
-    traceElapsed = traceTimer.nsecsElapsed();
-    std::cout << "Lateness Calculation: ";
-    gu_printTime(traceElapsed);
-    std::cout << std::endl;
+    profile->endPhase(phase);
 }
 
 // Adjacent (parent/child off by one dag leap) partitions are merged if along
@@ -2137,6 +2362,9 @@ long long int Trace::getAggregateFunctionRecurse(Event * evt,
 {
     if (evt->enter > stop || evt->exit < start)
         return 0;
+    if (evt->isPacked())
+        return getAggregatePackedCalls(static_cast<PackedCalls *>(evt), fpMap,
+                                       start, stop);
 
     unsigned long long overlap_stop = std::min(stop, evt->exit);
     unsigned long long overlap_start = std::max(start, evt->enter);
@@ -2163,6 +2391,40 @@ long long int Trace::getAggregateFunctionRecurse(Event * evt,
     return overlap;
 }
 
+// Same as above over the decoded calls, returning the time of the run
+long long int Trace::getAggregatePackedCalls(PackedCalls * packed,
+                                             QMap<int, FunctionPair> * fpMap,
+                                             unsigned long long start,
+                                             unsigned long long stop)
+{
+    QVector<PackedCalls::Call> calls = QVector<PackedCalls::Call>();
+    packed->decode(&calls, start, stop);
+
+    QVector<long long> overlaps = QVector<long long>(calls.size());
+    long long run_overlap = 0;
+    for (int i = 0; i < calls.size(); ++i)
+    {
+        const PackedCalls::Call& call = calls.at(i);
+        long long overlap = std::min(stop, call.exit)
+                            - std::max(start, call.enter);
+        overlaps[i] += overlap;
+        if (call.parent >= 0)
+            overlaps[call.parent] -= overlap;
+        else
+            run_overlap += overlap;
+    }
+
+    for (int i = 0; i < calls.size(); ++i)
+    {
+        int function = calls.at(i).function;
+        if (fpMap->contains(function))
+            (*fpMap)[function].time += overlaps.at(i);
+        else
+            (*fpMap)[function] = FunctionPair(function, overlaps.at(i));
+    }
+    return run_overlap;
+}
+
 Event * Trace::findEvent(int task, unsigned long long time)
 {
     Event * found = NULL;
@@ -2177,6 +2439,42 @@ Event * Trace::findEvent(int task, unsigned long long time)
     return found;
 }
 
+// Only positive values are summed since that is what the overview displays.
+QVector<double> * Trace::metricStepTotals(QString metric)
+{
+    if (step_metric_totals->contains(metric))
+        return step_metric_totals->value(metric);
+
+    QVector<double> * totals = new QVector<double>(global_max_step + 1, 0);
+    for (QList<Partition *>::Iterator part = partitions->begin();
+         part != partitions->end(); ++part)
+    {
+        for (QMap<int, QList<CommEvent *> *>::Iterator event_list
+             = (*part)->events->begin();
+             event_list != (*part)->events->end(); ++event_list)
+        {
+            for (QList<CommEvent *>::Iterator evt = (event_list.value())->begin();
+                 evt != (event_list.value())->end(); ++evt)
+            {
+                if ((*evt)->step < 0 || (*evt)->step > global_max_step)
+                    continue;
+
+                CommEvent::MetricPair * mp = (*evt)->metrics->value(metric);
+                if (!mp)
+                    continue;
+
+                if (mp->event > 0)
+                    (*totals)[(*evt)->step] += mp->event;
+                if ((*evt)->step > 0 && mp->aggregate > 0)
+                    (*totals)[(*evt)->step - 1] += mp->aggregate;
+            }
+        }
+    }
+
+    step_metric_totals->insert(metric, totals);
+    return totals;
+}
+
 // use GraphViz to see partition graph for debugging
 void Trace::output_graph(QString filename, bool byparent)
 {
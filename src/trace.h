@@ -32,7 +32,9 @@
 #include <QVector>
 #include <QQueue>
 #include <QStack>
+#include <QSet>
 #include <QSharedPointer>
+#include <climits>
 
 #include "otfimportoptions.h"
 
@@ -40,11 +42,18 @@ class Partition;
 class Gnome;
 class Event;
 class CommEvent;
+class PackedCalls;
 class Function;
 class Task;
 class TaskGroup;
 class OTFCollective;
 class CollectiveRecord;
+class StepIndex;
+class TimePyramid;
+class HotspotIndex;
+class ProcessingProfile;
+class RawTrace;
+class CallStore;
 
 class Trace : public QObject
 {
@@ -55,12 +64,23 @@ public:
 
     void preprocess(OTFImportOptions * _options);
     void preprocessFromSaved();
+    void recluster(OTFImportOptions * _options);
     void partition();
     void assignSteps();
     void gnomify();
+
+    // Phases of preprocess after stepping, each checks its own options
+    void clusterTasks();
+    void compactCallTrees();
+    void buildIndexes();
+    void addPartitionMetric(); // For debugging
     void mergePartitions(QList<QList<Partition *> *> * components);
     Event * findEvent(int task, unsigned long long time);
 
+    // Sum of a metric over all events at each global step. Aggregate values
+    // fall on the odd step before their event. Built on first request.
+    QVector<double> * metricStepTotals(QString metric);
+
     QString name;
     QString fullpath;
     int num_tasks;
@@ -91,8 +111,30 @@ public:
     int mpi_group; // functionGroup index of "MPI" functions
 
     int global_max_step; // largest global step
+
+    // Earliest enter and latest exit of the communication events at each
+    // global step, set with the steps. Odd (aggregate) steps share the
+    // entry of the step below them: step s is step_times->at(s / 2).
+    class StepTime {
+    public:
+        StepTime() : start(ULLONG_MAX), stop(0) {}
+
+        unsigned long long start;
+        unsigned long long stop;
+    };
+    QVector<StepTime> * step_times;
+    unsigned long long min_time; // over all communication events
+    unsigned long long max_time;
+    StepTime stepTime(int step) { return step_times->value(step / 2); }
+
     QList<Partition * > * dag_entries; // Leap 0 in the dag
     QMap<int, QSet<Partition *> *> * dag_step_dict; // Map leap to partition
+    StepIndex * step_index; // Events by global step for the logical views
+    TimePyramid * time_pyramid; // Call tree summary for the physical view
+    HotspotIndex * hotspots; // Largest metric values, for the hotspot list
+    ProcessingProfile * profile; // Timings and counts from import on
+    RawTrace * rawtrace; // Matched records kept for reprocessing, may be NULL
+    CallStore * call_store; // Packed calls paged to disk, may be NULL
 
     // This is for aggregate event reporting... lists all functions
     // and how much time was spent in each
@@ -159,6 +201,7 @@ private:
 
     // Steps and metrics
     void set_global_steps();
+    void setStepTimes();
     void calculate_lateness();
     void calculate_differential_lateness(QString metric_name, QString base_name);
     void calculate_partition_lateness();
@@ -168,16 +211,30 @@ private:
 
     // Extra metrics somewhat for debugging
     void setGnomeMetric(Partition * part, int gnome_index);
-    void addPartitionMetric();
+
+    // Call tree packing
+    void packCalls(QVector<Event *> * calls, Event * caller,
+                   const QSet<Event *>& keep, QSet<Event *> * packed,
+                   QVector<Event *> * stubs);
+    void packRun(const QVector<Event *>& run, Event * caller,
+                 QVector<Event *> * kept, QSet<Event *> * packed,
+                 QVector<Event *> * stubs);
 
     // Find functions inside aggregate function
     long long int getAggregateFunctionRecurse(Event * evt,
                                               QMap<int, FunctionPair> * fpMap,
                                               unsigned long long start,
                                               unsigned long long stop);
+    long long int getAggregatePackedCalls(PackedCalls * packed,
+                                          QMap<int, FunctionPair> * fpMap,
+                                          unsigned long long start,
+                                          unsigned long long stop);
 
     bool isProcessed; // Partitions exist
 
+    // Cache for metricStepTotals
+    QMap<QString, QVector<double> *> * step_metric_totals;
+
     // TODO: Replace this terrible stuff with QSharedPointer
     //QSet<RecurseInfo *> * riTracker;
     //QSet<QList<Partition *> *> * riChildrenTracker;
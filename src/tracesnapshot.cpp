@@ -0,0 +1,1058 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+//
+// This file is part of Ravel.
+// Written by Kate Isaacs, kisaacs@acm.org, All rights reserved.
+// LLNL-CODE-663885
+//
+// For details, see https://github.com/scalability-llnl/ravel
+// Please also see the LICENSE file for our notice and the LGPL.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (as published by
+// the Free Software Foundation) version 2.1 dated February 1999.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the IMPLIED WARRANTY OF
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the terms and
+// conditions of the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//////////////////////////////////////////////////////////////////////////////
+#include "tracesnapshot.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QHash>
+#include <QStringList>
+
+#include "trace.h"
+#include "rpartition.h"
+#include "event.h"
+#include "commevent.h"
+#include "p2pevent.h"
+#include "collectiveevent.h"
+#include "packedcalls.h"
+#include "collectiverecord.h"
+#include "message.h"
+#include "function.h"
+#include "task.h"
+#include "taskgroup.h"
+#include "otfcollective.h"
+
+// Kinds of event records
+static const qint8 snapshot_event = 0;
+static const qint8 snapshot_p2p = 1;
+static const qint8 snapshot_collective = 2;
+static const qint8 snapshot_packed = 3;
+
+// Numbers the objects of a trace so links can be written as indices
+class SnapshotIds
+{
+public:
+    QVector<Event *> events;
+    QHash<Event *, int> event_ids;
+    QVector<Message *> messages;
+    QHash<Message *, int> message_ids;
+    QVector<CollectiveRecord *> records;
+    QHash<CollectiveRecord *, int> record_ids;
+    QStringList metrics;
+    QHash<QString, int> metric_ids;
+
+    void addEvent(Event * evt)
+    {
+        if (evt && !event_ids.contains(evt))
+        {
+            event_ids.insert(evt, events.size());
+            events.append(evt);
+        }
+    }
+
+    void addMessage(Message * msg)
+    {
+        if (msg && !message_ids.contains(msg))
+        {
+            message_ids.insert(msg, messages.size());
+            messages.append(msg);
+        }
+    }
+
+    void addRecord(CollectiveRecord * cr)
+    {
+        if (cr && !record_ids.contains(cr))
+        {
+            record_ids.insert(cr, records.size());
+            records.append(cr);
+        }
+    }
+
+    void addMetric(const QString& metric)
+    {
+        if (!metric_ids.contains(metric))
+        {
+            metric_ids.insert(metric, metrics.size());
+            metrics.append(metric);
+        }
+    }
+
+    qint32 eventId(Event * evt) { return evt ? event_ids.value(evt) : -1; }
+};
+
+// Links read from a snapshot, kept as indices until every object exists.
+// Lists are stored flat with offsets per owner.
+class SnapshotLinks
+{
+public:
+    SnapshotLinks() : ok(true) {}
+
+    bool ok;
+
+    qint32 readId(QDataStream& in, int limit, bool allow_none = true)
+    {
+        qint32 id;
+        in >> id;
+        if (id >= limit || id < (allow_none ? -1 : 0))
+            ok = false;
+        return id;
+    }
+
+    void readIds(QDataStream& in, int limit, QVector<qint32> * offsets,
+                 QVector<qint32> * ids)
+    {
+        qint32 count;
+        in >> count;
+        if (count < 0 || in.status() != QDataStream::Ok)
+        {
+            ok = false;
+            count = 0;
+        }
+        for (int i = 0; i < count && ok; ++i)
+            ids->append(readId(in, limit, false));
+        offsets->append(ids->size());
+    }
+};
+
+TraceSnapshot::TraceSnapshot(QString _source, OTFImportOptions * _options)
+    : source(QFileInfo(_source).absoluteFilePath()),
+      options_key(QByteArray()),
+      cache_limit(qint64(_options->snapshotCacheLimit) << 20)
+{
+    // A random cluster seed is not part of what the user asked for
+    OTFImportOptions key_options = *_options;
+    if (!key_options.seedClusters)
+        key_options.clusterSeed = 0;
+    QDataStream out(&options_key, QIODevice::WriteOnly);
+    writeOptions(out, key_options);
+}
+
+QString TraceSnapshot::cacheDir()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation)
+           + "/snapshots";
+}
+
+QString TraceSnapshot::cachePath()
+{
+    QByteArray hash = QCryptographicHash::hash(source.toUtf8(),
+                                               QCryptographicHash::Sha1);
+    return cacheDir() + "/" + QString(hash.toHex()) + ".ravel";
+}
+
+// Files rewritten in place do not change their directory's time, so every
+// file of the trace goes in the key: those next to the anchor sharing its
+// name (OTF's definitions and events, OTF2's global definitions) and those
+// in the directory named for it (OTF2's per location files).
+QByteArray TraceSnapshot::sourceKey()
+{
+    QByteArray key = QByteArray();
+    QDataStream out(&key, QIODevice::WriteOnly);
+    QFileInfo info(source);
+    out << source;
+
+    QFileInfoList files = QDir(info.absolutePath()).entryInfoList(
+                QStringList(info.completeBaseName() + ".*"), QDir::Files,
+                QDir::Name);
+    QFileInfo archive(info.absolutePath() + "/" + info.completeBaseName());
+    if (archive.isDir())
+        files += QDir(archive.absoluteFilePath()).entryInfoList(QDir::Files,
+                                                                QDir::Name);
+    for (QFileInfoList::Iterator file = files.begin(); file != files.end();
+         ++file)
+    {
+        out << file->fileName() << qint64(file->size())
+            << qint64(file->lastModified().toMSecsSinceEpoch());
+    }
+    return key;
+}
+
+// Newest snapshots are kept first, the one just written always stays
+void TraceSnapshot::trimCache()
+{
+    QFileInfoList snapshots = QDir(cacheDir()).entryInfoList(
+                QStringList("*.ravel"), QDir::Files, QDir::Time);
+    qint64 total = 0;
+    for (int i = 0; i < snapshots.size(); ++i)
+    {
+        total += snapshots.at(i).size();
+        if (i > 0 && (total > cache_limit || i >= max_snapshots))
+            QFile::remove(snapshots.at(i).absoluteFilePath());
+    }
+}
+
+void TraceSnapshot::writeOptions(QDataStream& out,
+                                 const OTFImportOptions& opts)
+{
+    out << opts.waitallMerge << opts.callerMerge << opts.leapMerge
+        << opts.leapSkip << opts.partitionByFunction << opts.globalMerge
+        << opts.cluster << opts.isendCoalescing << opts.enforceMessageSizes
+        << opts.seedClusters << qint64(opts.clusterSeed)
+        << opts.advancedStepping << qint32(opts.origin)
+        << opts.partitionFunction
+        << opts.timeWindow << opts.windowStart << opts.windowEnd
+        << opts.taskSubset << opts.taskFilter << qint32(opts.taskHops)
+        << opts.compactCallTrees << opts.pageCallTrees
+        << qint32(opts.callTreeBudget);
+}
+
+void TraceSnapshot::readOptions(QDataStream& in, OTFImportOptions * opts)
+{
+    qint64 seed;
+    qint32 origin;
+    qint32 hops;
+    qint32 budget;
+    in >> opts->waitallMerge >> opts->callerMerge >> opts->leapMerge
+       >> opts->leapSkip >> opts->partitionByFunction >> opts->globalMerge
+       >> opts->cluster >> opts->isendCoalescing >> opts->enforceMessageSizes
+       >> opts->seedClusters >> seed
+       >> opts->advancedStepping >> origin
+       >> opts->partitionFunction
+       >> opts->timeWindow >> opts->windowStart >> opts->windowEnd
+       >> opts->taskSubset >> opts->taskFilter >> hops
+       >> opts->compactCallTrees >> opts->pageCallTrees >> budget;
+    opts->clusterSeed = seed;
+    opts->taskHops = hops;
+    opts->callTreeBudget = budget;
+    opts->origin = static_cast<OTFImportOptions::OriginFormat>(origin);
+}
+
+bool TraceSnapshot::save(Trace * trace)
+{
+    QString path = cachePath();
+    if (!QDir().mkpath(QFileInfo(path).absolutePath()))
+        return false;
+
+    // Number everything reachable from the per-task events and partitions
+    SnapshotIds ids = SnapshotIds();
+    for (QMap<unsigned long long, CollectiveRecord *>::Iterator cr
+         = trace->collectives->begin(); cr != trace->collectives->end(); ++cr)
+    {
+        ids.addRecord(cr.value());
+    }
+    if (trace->collectiveMap)
+        for (int task = 0; task < trace->collectiveMap->size(); ++task)
+        {
+            QMap<unsigned long long, CollectiveRecord *> * task_map
+                = trace->collectiveMap->at(task);
+            for (QMap<unsigned long long, CollectiveRecord *>::Iterator cr
+                 = task_map->begin(); cr != task_map->end(); ++cr)
+            {
+                ids.addRecord(cr.value());
+            }
+        }
+    for (int i = 0; i < ids.records.size(); ++i)
+        for (QList<CollectiveEvent *>::Iterator member
+             = ids.records.at(i)->events->begin();
+             member != ids.records.at(i)->events->end(); ++member)
+        {
+            ids.addEvent(*member);
+        }
+    for (int task = 0; task < trace->num_tasks; ++task)
+    {
+        QVector<Event *> * task_events = trace->events->at(task);
+        for (QVector<Event *>::Iterator evt = task_events->begin();
+             evt != task_events->end(); ++evt)
+        {
+            ids.addEvent(*evt);
+        }
+    }
+    for (QList<Partition *>::Iterator part = trace->partitions->begin();
+         part != trace->partitions->end(); ++part)
+    {
+        for (QMap<int, QList<CommEvent *> *>::Iterator event_list
+             = (*part)->events->begin();
+             event_list != (*part)->events->end(); ++event_list)
+        {
+            for (QList<CommEvent *>::Iterator evt = event_list.value()->begin();
+                 evt != event_list.value()->end(); ++evt)
+            {
+                ids.addEvent(*evt);
+            }
+        }
+    }
+    for (int i = 0; i < ids.events.size(); ++i)
+    {
+        Event * evt = ids.events.at(i);
+        ids.addEvent(evt->caller);
+        for (QVector<Event *>::Iterator callee = evt->callees->begin();
+             callee != evt->callees->end(); ++callee)
+        {
+            ids.addEvent(*callee);
+        }
+        if (!evt->isCommEvent())
+            continue;
+
+        CommEvent * comm = static_cast<CommEvent *>(evt);
+        ids.addEvent(comm->comm_prev);
+        ids.addEvent(comm->comm_next);
+        for (QMap<QString, CommEvent::MetricPair *>::Iterator metric
+             = comm->metrics->begin(); metric != comm->metrics->end(); ++metric)
+        {
+            ids.addMetric(metric.key());
+        }
+
+        if (comm->isP2P())
+        {
+            P2PEvent * p2p = static_cast<P2PEvent *>(comm);
+            for (QVector<Message *>::Iterator msg = p2p->messages->begin();
+                 msg != p2p->messages->end(); ++msg)
+            {
+                ids.addMessage(*msg);
+                ids.addEvent((*msg)->sender);
+                ids.addEvent((*msg)->receiver);
+            }
+            if (p2p->subevents)
+                for (QList<P2PEvent *>::Iterator sub = p2p->subevents->begin();
+                     sub != p2p->subevents->end(); ++sub)
+                {
+                    ids.addEvent(*sub);
+                }
+        }
+        else if (comm->isCollective())
+        {
+            CollectiveRecord * cr = comm->getCollective();
+            ids.addRecord(cr);
+            for (QList<CollectiveEvent *>::Iterator member = cr->events->begin();
+                 member != cr->events->end(); ++member)
+            {
+                ids.addEvent(*member);
+            }
+        }
+    }
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_5_0);
+
+    out << magic << version << sourceKey() << options_key;
+    writeOptions(out, trace->options);
+
+    // Definitions
+    out << trace->name << trace->fullpath << qint32(trace->num_tasks)
+        << qint32(trace->units) << qint32(trace->mpi_group);
+    out << *(trace->metrics) << *(trace->metric_units)
+        << *(trace->functionGroups);
+
+    out << qint32(trace->functions->size());
+    for (QMap<int, Function *>::Iterator fxn = trace->functions->begin();
+         fxn != trace->functions->end(); ++fxn)
+    {
+        out << qint32(fxn.key()) << fxn.value()->name
+            << qint32(fxn.value()->group) << qint32(fxn.value()->comms);
+    }
+
+    out << qint32(trace->tasks ? trace->tasks->size() : 0);
+    if (trace->tasks)
+        for (QMap<int, Task *>::Iterator task = trace->tasks->begin();
+             task != trace->tasks->end(); ++task)
+        {
+            out << qint32(task.key()) << qint32(task.value()->id)
+                << task.value()->name;
+        }
+
+    out << qint32(trace->taskgroups ? trace->taskgroups->size() : 0);
+    if (trace->taskgroups)
+        for (QMap<int, TaskGroup *>::Iterator tg = trace->taskgroups->begin();
+             tg != trace->taskgroups->end(); ++tg)
+        {
+            out << qint32(tg.key()) << qint32(tg.value()->id)
+                << tg.value()->name << *(tg.value()->tasks)
+                << *(tg.value()->taskorder);
+        }
+
+    out << qint32(trace->collective_definitions
+                  ? trace->collective_definitions->size() : 0);
+    if (trace->collective_definitions)
+        for (QMap<int, OTFCollective *>::Iterator cdef
+             = trace->collective_definitions->begin();
+             cdef != trace->collective_definitions->end(); ++cdef)
+        {
+            out << qint32(cdef.key()) << qint32(cdef.value()->id)
+                << qint32(cdef.value()->type) << cdef.value()->name;
+        }
+
+    out << ids.metrics;
+
+    // Object counts so links can be checked as they are read
+    out << qint32(ids.records.size()) << qint32(ids.messages.size())
+        << qint32(ids.events.size());
+
+    for (QVector<CollectiveRecord *>::Iterator cr = ids.records.begin();
+         cr != ids.records.end(); ++cr)
+    {
+        out << quint64((*cr)->matchingId) << quint32((*cr)->root)
+            << quint32((*cr)->collective) << quint32((*cr)->taskgroup);
+    }
+
+    for (QVector<Message *>::Iterator msg = ids.messages.begin();
+         msg != ids.messages.end(); ++msg)
+    {
+        out << quint64((*msg)->sendtime) << quint64((*msg)->recvtime)
+            << qint32((*msg)->taskgroup) << quint32((*msg)->tag)
+            << quint64((*msg)->size);
+    }
+
+    for (QVector<Event *>::Iterator evt = ids.events.begin();
+         evt != ids.events.end(); ++evt)
+    {
+        qint8 kind = snapshot_event;
+        if ((*evt)->isCommEvent())
+            kind = static_cast<CommEvent *>(*evt)->isP2P() ? snapshot_p2p
+                                                           : snapshot_collective;
+        else if ((*evt)->isPacked())
+            kind = snapshot_packed;
+        out << kind << quint64((*evt)->enter) << quint64((*evt)->exit)
+            << qint32((*evt)->function) << qint32((*evt)->task)
+            << qint32((*evt)->depth) << ids.eventId((*evt)->caller);
+
+        out << qint32((*evt)->callees->size());
+        for (QVector<Event *>::Iterator callee = (*evt)->callees->begin();
+             callee != (*evt)->callees->end(); ++callee)
+        {
+            out << ids.eventId(*callee);
+        }
+
+        if (kind == snapshot_packed)
+        {
+            PackedCalls * packed = static_cast<PackedCalls *>(*evt);
+            out << qint32(packed->size()) << packed->bytes();
+        }
+        if (kind == snapshot_event || kind == snapshot_packed)
+            continue;
+
+        CommEvent * comm = static_cast<CommEvent *>(*evt);
+        out << qint32(comm->phase) << qint32(comm->step)
+            << ids.eventId(comm->comm_prev) << ids.eventId(comm->comm_next);
+        out << qint32(comm->metrics->size());
+        for (QMap<QString, CommEvent::MetricPair *>::Iterator metric
+             = comm->metrics->begin(); metric != comm->metrics->end(); ++metric)
+        {
+            out << qint32(ids.metric_ids.value(metric.key()))
+                << metric.value()->event << metric.value()->aggregate;
+        }
+
+        if (kind == snapshot_p2p)
+        {
+            P2PEvent * p2p = static_cast<P2PEvent *>(comm);
+            out << p2p->is_recv << qint32(p2p->messages->size());
+            for (QVector<Message *>::Iterator msg = p2p->messages->begin();
+                 msg != p2p->messages->end(); ++msg)
+            {
+                out << qint32(ids.message_ids.value(*msg));
+            }
+
+            out << bool(p2p->subevents);
+            if (p2p->subevents)
+            {
+                out << qint32(p2p->subevents->size());
+                for (QList<P2PEvent *>::Iterator sub = p2p->subevents->begin();
+                     sub != p2p->subevents->end(); ++sub)
+                {
+                    out << ids.eventId(*sub);
+                }
+            }
+        }
+        else
+        {
+            out << qint32(ids.record_ids.value(comm->getCollective()));
+        }
+    }
+
+    // Links that point back at events
+    for (QVector<CollectiveRecord *>::Iterator cr = ids.records.begin();
+         cr != ids.records.end(); ++cr)
+    {
+        out << qint32((*cr)->events->size());
+        for (QList<CollectiveEvent *>::Iterator member = (*cr)->events->begin();
+             member != (*cr)->events->end(); ++member)
+        {
+            out << ids.eventId(*member);
+        }
+    }
+
+    for (QVector<Message *>::Iterator msg = ids.messages.begin();
+         msg != ids.messages.end(); ++msg)
+    {
+        out << ids.eventId((*msg)->sender) << ids.eventId((*msg)->receiver);
+    }
+
+    for (int task = 0; task < trace->num_tasks; ++task)
+    {
+        QVector<Event *> * task_events = trace->events->at(task);
+        out << qint32(task_events->size());
+        for (QVector<Event *>::Iterator evt = task_events->begin();
+             evt != task_events->end(); ++evt)
+        {
+            out << ids.eventId(*evt);
+        }
+
+        QVector<Event *> * task_roots = trace->roots->at(task);
+        out << qint32(task_roots->size());
+        for (QVector<Event *>::Iterator evt = task_roots->begin();
+             evt != task_roots->end(); ++evt)
+        {
+            out << ids.eventId(*evt);
+        }
+    }
+
+    out << qint32(trace->collectives->size());
+    for (QMap<unsigned long long, CollectiveRecord *>::Iterator cr
+         = trace->collectives->begin(); cr != trace->collectives->end(); ++cr)
+    {
+        out << quint64(cr.key()) << qint32(ids.record_ids.value(cr.value()));
+    }
+
+    out << bool(trace->collectiveMap);
+    if (trace->collectiveMap)
+        for (int task = 0; task < trace->collectiveMap->size(); ++task)
+        {
+            QMap<unsigned long long, CollectiveRecord *> * task_map
+                = trace->collectiveMap->at(task);
+            out << qint32(task_map->size());
+            for (QMap<unsigned long long, CollectiveRecord *>::Iterator cr
+                 = task_map->begin(); cr != task_map->end(); ++cr)
+            {
+                out << quint64(cr.key())
+                    << qint32(ids.record_ids.value(cr.value()));
+            }
+        }
+
+    out << qint32(trace->partitions->size());
+    for (QList<Partition *>::Iterator part = trace->partitions->begin();
+         part != trace->partitions->end(); ++part)
+    {
+        out << qint32((*part)->events->size());
+        for (QMap<int, QList<CommEvent *> *>::Iterator event_list
+             = (*part)->events->begin();
+             event_list != (*part)->events->end(); ++event_list)
+        {
+            out << qint32(event_list.key())
+                << qint32(event_list.value()->size());
+            for (QList<CommEvent *>::Iterator evt = event_list.value()->begin();
+                 evt != event_list.value()->end(); ++evt)
+            {
+                out << ids.eventId(*evt);
+            }
+        }
+    }
+
+    if (out.status() != QDataStream::Ok)
+    {
+        file.cancelWriting();
+        return false;
+    }
+    if (!file.commit())
+        return false;
+
+    trimCache();
+    return true;
+}
+
+static P2PEvent * snapshotP2P(Event * evt)
+{
+    if (evt && evt->isCommEvent() && static_cast<CommEvent *>(evt)->isP2P())
+        return static_cast<P2PEvent *>(evt);
+    return NULL;
+}
+
+static CollectiveEvent * snapshotCollective(Event * evt)
+{
+    if (evt && evt->isCollective())
+        return static_cast<CollectiveEvent *>(evt);
+    return NULL;
+}
+
+Trace * TraceSnapshot::load()
+{
+    QFile file(cachePath());
+    if (!file.open(QIODevice::ReadOnly))
+        return NULL;
+#if QT_VERSION >= QT_VERSION_CHECK(5, 10, 0)
+    // Snapshots in use are the last to be trimmed
+    file.setFileTime(QDateTime::currentDateTime(),
+                     QFileDevice::FileModificationTime);
+#endif
+
+    // Parse straight from a mapping of the file rather than copying it into
+    // a buffer first. Every record is still read into the trace here.
+    uchar * data = file.map(0, file.size());
+    if (!data)
+        return NULL;
+    QByteArray bytes = QByteArray::fromRawData(reinterpret_cast<char *>(data),
+                                               file.size());
+    QDataStream in(bytes);
+    in.setVersion(QDataStream::Qt_5_0);
+
+    quint32 file_magic = 0;
+    qint32 file_version = 0;
+    in >> file_magic >> file_version;
+    if (file_magic != magic || file_version != version)
+        return NULL;
+
+    QByteArray file_source, file_options;
+    in >> file_source >> file_options;
+    if (in.status() != QDataStream::Ok || file_source != sourceKey()
+        || file_options != options_key)
+    {
+        return NULL;
+    }
+
+    // Everything is read into unlinked objects first so a damaged file
+    // can be dropped without touching a half built trace
+    OTFImportOptions saved_options = OTFImportOptions();
+    readOptions(in, &saved_options);
+
+    QString name, fullpath;
+    qint32 num_tasks, units, mpi_group;
+    in >> name >> fullpath >> num_tasks >> units >> mpi_group;
+
+    QList<QString> metrics;
+    QMap<QString, QString> metric_units;
+    QMap<int, QString> functionGroups;
+    in >> metrics >> metric_units >> functionGroups;
+
+    SnapshotLinks links = SnapshotLinks();
+    qint32 count, key;
+
+    QMap<int, Function *> * functions = new QMap<int, Function *>();
+    in >> count;
+    for (int i = 0; i < count && in.status() == QDataStream::Ok; ++i)
+    {
+        QString fxn_name;
+        qint32 group, comms;
+        in >> key >> fxn_name >> group >> comms;
+        Function * fxn = new Function(fxn_name, group);
+        fxn->comms = comms;
+        functions->insert(key, fxn);
+    }
+
+    QMap<int, Task *> * tasks = new QMap<int, Task *>();
+    in >> count;
+    for (int i = 0; i < count && in.status() == QDataStream::Ok; ++i)
+    {
+        qint32 id;
+        QString task_name;
+        in >> key >> id >> task_name;
+        tasks->insert(key, new Task(id, task_name));
+    }
+
+    QMap<int, TaskGroup *> * taskgroups = new QMap<int, TaskGroup *>();
+    in >> count;
+    for (int i = 0; i < count && in.status() == QDataStream::Ok; ++i)
+    {
+        qint32 id;
+        QString tg_name;
+        in >> key >> id >> tg_name;
+        TaskGroup * tg = new TaskGroup(id, tg_name);
+        in >> *(tg->tasks) >> *(tg->taskorder);
+        taskgroups->insert(key, tg);
+    }
+
+    QMap<int, OTFCollective *> * collective_definitions
+            = new QMap<int, OTFCollective *>();
+    in >> count;
+    for (int i = 0; i < count && in.status() == QDataStream::Ok; ++i)
+    {
+        qint32 id, type;
+        QString cdef_name;
+        in >> key >> id >> type >> cdef_name;
+        collective_definitions->insert(key, new OTFCollective(id, type,
+                                                              cdef_name));
+    }
+
+    QStringList metric_names;
+    qint32 num_records = 0, num_messages = 0, num_events = 0;
+    in >> metric_names >> num_records >> num_messages >> num_events;
+    if (in.status() != QDataStream::Ok || num_tasks < 0 || num_records < 0
+        || num_messages < 0 || num_events < 0)
+    {
+        links.ok = false;
+        num_records = num_messages = num_events = 0;
+    }
+
+    QVector<CollectiveRecord *> records = QVector<CollectiveRecord *>();
+    for (int i = 0; i < num_records && links.ok; ++i)
+    {
+        quint64 matching;
+        quint32 root, collective, taskgroup;
+        in >> matching >> root >> collective >> taskgroup;
+        records.append(new CollectiveRecord(matching, root, collective,
+                                            taskgroup));
+    }
+
+    QVector<Message *> messages = QVector<Message *>();
+    for (int i = 0; i < num_messages && links.ok; ++i)
+    {
+        quint64 sendtime, recvtime, size;
+        qint32 group;
+        quint32 tag;
+        in >> sendtime >> recvtime >> group >> tag >> size;
+        Message * msg = new Message(sendtime, recvtime, group);
+        msg->tag = tag;
+        msg->size = size;
+        messages.append(msg);
+    }
+
+    // Events and the links they own
+    QVector<Event *> events = QVector<Event *>();
+    QVector<qint32> callers = QVector<qint32>();
+    QVector<qint32> callee_offsets = QVector<qint32>(1, 0);
+    QVector<qint32> callee_ids = QVector<qint32>();
+    QVector<qint32> prevs = QVector<qint32>();
+    QVector<qint32> nexts = QVector<qint32>();
+    QVector<qint32> message_offsets = QVector<qint32>(1, 0);
+    QVector<qint32> message_ids = QVector<qint32>();
+    QVector<qint32> sub_offsets = QVector<qint32>(1, 0);
+    QVector<qint32> sub_ids = QVector<qint32>();
+    QVector<bool> has_subs = QVector<bool>();
+    QVector<qint32> event_records = QVector<qint32>();
+    events.reserve(num_events);
+    for (int i = 0; i < num_events && links.ok; ++i)
+    {
+        qint8 kind;
+        quint64 enter, exit;
+        qint32 function, task, depth;
+        in >> kind >> enter >> exit >> function >> task >> depth;
+        callers.append(links.readId(in, num_events));
+        links.readIds(in, num_events, &callee_offsets, &callee_ids);
+
+        if (kind == snapshot_event)
+        {
+            events.append(new Event(enter, exit, function, task));
+            events.last()->depth = depth;
+            prevs.append(-1);
+            nexts.append(-1);
+            message_offsets.append(message_ids.size());
+            sub_offsets.append(sub_ids.size());
+            has_subs.append(false);
+            event_records.append(-1);
+            continue;
+        }
+        else if (kind == snapshot_packed)
+        {
+            qint32 calls;
+            QByteArray bytes;
+            in >> calls >> bytes;
+            PackedCalls * packed = new PackedCalls(enter, exit, task, depth);
+            packed->setBytes(bytes, calls);
+            events.append(packed);
+            prevs.append(-1);
+            nexts.append(-1);
+            message_offsets.append(message_ids.size());
+            sub_offsets.append(sub_ids.size());
+            has_subs.append(false);
+            event_records.append(-1);
+            continue;
+        }
+
+        qint32 phase, step;
+        in >> phase >> step;
+        prevs.append(links.readId(in, num_events));
+        nexts.append(links.readId(in, num_events));
+
+        CommEvent * comm = NULL;
+        if (kind == snapshot_p2p)
+            comm = new P2PEvent(enter, exit, function, task, phase,
+                                new QVector<Message *>());
+        else if (kind == snapshot_collective)
+            comm = new CollectiveEvent(enter, exit, function, task, phase,
+                                       NULL);
+        else
+        {
+            links.ok = false;
+            break;
+        }
+        comm->depth = depth;
+        comm->step = step;
+        events.append(comm);
+
+        in >> count;
+        for (int j = 0; j < count && links.ok; ++j)
+        {
+            qint32 metric = links.readId(in, metric_names.size(), false);
+            double event_value, aggregate_value;
+            in >> event_value >> aggregate_value;
+            if (links.ok)
+                comm->addMetric(metric_names.at(metric), event_value,
+                                aggregate_value);
+        }
+
+        if (kind == snapshot_p2p)
+        {
+            bool has_sub;
+            in >> static_cast<P2PEvent *>(comm)->is_recv;
+            links.readIds(in, num_messages, &message_offsets, &message_ids);
+            in >> has_sub;
+            has_subs.append(has_sub);
+            if (has_sub)
+                links.readIds(in, num_events, &sub_offsets, &sub_ids);
+            else
+                sub_offsets.append(sub_ids.size());
+            event_records.append(-1);
+        }
+        else
+        {
+            message_offsets.append(message_ids.size());
+            sub_offsets.append(sub_ids.size());
+            has_subs.append(false);
+            event_records.append(links.readId(in, num_records, false));
+        }
+    }
+    if (events.size() != num_events)
+        links.ok = false;
+
+    // Links that point back at events
+    QVector<qint32> member_offsets = QVector<qint32>(1, 0);
+    QVector<qint32> member_ids = QVector<qint32>();
+    for (int i = 0; i < num_records && links.ok; ++i)
+        links.readIds(in, num_events, &member_offsets, &member_ids);
+
+    QVector<qint32> senders = QVector<qint32>();
+    QVector<qint32> receivers = QVector<qint32>();
+    for (int i = 0; i < num_messages && links.ok; ++i)
+    {
+        senders.append(links.readId(in, num_events));
+        receivers.append(links.readId(in, num_events));
+    }
+
+    QVector<qint32> task_event_offsets = QVector<qint32>(1, 0);
+    QVector<qint32> task_event_ids = QVector<qint32>();
+    QVector<qint32> root_offsets = QVector<qint32>(1, 0);
+    QVector<qint32> root_ids = QVector<qint32>();
+    for (int task = 0; task < num_tasks && links.ok; ++task)
+    {
+        links.readIds(in, num_events, &task_event_offsets, &task_event_ids);
+        links.readIds(in, num_events, &root_offsets, &root_ids);
+    }
+
+    QVector<quint64> collective_keys = QVector<quint64>();
+    QVector<qint32> collective_ids = QVector<qint32>();
+    in >> count;
+    for (int i = 0; i < count && links.ok; ++i)
+    {
+        quint64 matching;
+        in >> matching;
+        collective_keys.append(matching);
+        collective_ids.append(links.readId(in, num_records, false));
+    }
+
+    bool has_map = false;
+    QVector<qint32> map_offsets = QVector<qint32>(1, 0);
+    QVector<quint64> map_keys = QVector<quint64>();
+    QVector<qint32> map_ids = QVector<qint32>();
+    in >> has_map;
+    for (int task = 0; has_map && task < num_tasks && links.ok; ++task)
+    {
+        in >> count;
+        for (int i = 0; i < count && links.ok; ++i)
+        {
+            quint64 time;
+            in >> time;
+            map_keys.append(time);
+            map_ids.append(links.readId(in, num_records, false));
+        }
+        map_offsets.append(map_ids.size());
+    }
+
+    qint32 num_partitions = 0;
+    QVector<qint32> list_counts = QVector<qint32>();
+    QVector<qint32> list_tasks = QVector<qint32>();
+    QVector<qint32> list_offsets = QVector<qint32>(1, 0);
+    QVector<qint32> list_ids = QVector<qint32>();
+    in >> num_partitions;
+    for (int i = 0; i < num_partitions && links.ok; ++i)
+    {
+        in >> count;
+        list_counts.append(count);
+        for (int j = 0; j < count && links.ok; ++j)
+        {
+            in >> key;
+            list_tasks.append(key);
+            links.readIds(in, num_events, &list_offsets, &list_ids);
+        }
+    }
+
+    // Links must join the right kinds of events
+    for (int i = 0; i < sub_ids.size() && links.ok; ++i)
+        if (!snapshotP2P(events[sub_ids[i]]))
+            links.ok = false;
+    for (int i = 0; i < member_ids.size() && links.ok; ++i)
+        if (!snapshotCollective(events[member_ids[i]]))
+            links.ok = false;
+    for (int i = 0; i < list_ids.size() && links.ok; ++i)
+        if (!events[list_ids[i]]->isCommEvent())
+            links.ok = false;
+    for (int i = 0; i < num_messages && links.ok; ++i)
+        if ((senders[i] >= 0 && !snapshotP2P(events[senders[i]]))
+            || (receivers[i] >= 0 && !snapshotP2P(events[receivers[i]])))
+        {
+            links.ok = false;
+        }
+    for (int i = 0; i < num_events && links.ok; ++i)
+        if ((prevs[i] >= 0 && !events[prevs[i]]->isCommEvent())
+            || (nexts[i] >= 0 && !events[nexts[i]]->isCommEvent()))
+        {
+            links.ok = false;
+        }
+
+    if (!links.ok || in.status() != QDataStream::Ok)
+    {
+        qDeleteAll(events);
+        qDeleteAll(messages);
+        qDeleteAll(records);
+        qDeleteAll(*functions);
+        qDeleteAll(*tasks);
+        qDeleteAll(*taskgroups);
+        qDeleteAll(*collective_definitions);
+        delete functions;
+        delete tasks;
+        delete taskgroups;
+        delete collective_definitions;
+        return NULL;
+    }
+
+    // Build the trace
+    Trace * trace = new Trace(num_tasks);
+    trace->name = name;
+    trace->fullpath = fullpath;
+    trace->units = units;
+    trace->mpi_group = mpi_group;
+    *(trace->metrics) = metrics;
+    *(trace->metric_units) = metric_units;
+    *(trace->functionGroups) = functionGroups;
+    delete trace->functions;
+    trace->functions = functions;
+    trace->tasks = tasks;
+    trace->taskgroups = taskgroups;
+    trace->collective_definitions = collective_definitions;
+
+    // Clustering reruns from the saved seed to give the same clusters
+    trace->options = saved_options;
+    trace->options.seedClusters = true;
+
+    for (int i = 0; i < num_events; ++i)
+    {
+        Event * evt = events[i];
+        if (callers[i] >= 0)
+            evt->caller = events[callers[i]];
+        for (int j = callee_offsets[i]; j < callee_offsets[i + 1]; ++j)
+            evt->callees->append(events[callee_ids[j]]);
+        if (!evt->isCommEvent())
+            continue;
+
+        CommEvent * comm = static_cast<CommEvent *>(evt);
+        if (prevs[i] >= 0)
+            comm->comm_prev = static_cast<CommEvent *>(events[prevs[i]]);
+        if (nexts[i] >= 0)
+            comm->comm_next = static_cast<CommEvent *>(events[nexts[i]]);
+
+        P2PEvent * p2p = snapshotP2P(evt);
+        if (p2p)
+        {
+            for (int j = message_offsets[i]; j < message_offsets[i + 1]; ++j)
+                p2p->messages->append(messages[message_ids[j]]);
+            if (has_subs[i])
+            {
+                p2p->subevents = new QList<P2PEvent *>();
+                for (int j = sub_offsets[i]; j < sub_offsets[i + 1]; ++j)
+                    p2p->subevents->append(snapshotP2P(events[sub_ids[j]]));
+            }
+        }
+        else
+        {
+            static_cast<CollectiveEvent *>(evt)->collective
+                    = records[event_records[i]];
+        }
+    }
+
+    for (int i = 0; i < num_records; ++i)
+        for (int j = member_offsets[i]; j < member_offsets[i + 1]; ++j)
+            records[i]->events->append(snapshotCollective(events[member_ids[j]]));
+
+    for (int i = 0; i < num_messages; ++i)
+    {
+        if (senders[i] >= 0)
+            messages[i]->sender = snapshotP2P(events[senders[i]]);
+        if (receivers[i] >= 0)
+            messages[i]->receiver = snapshotP2P(events[receivers[i]]);
+    }
+
+    for (int task = 0; task < num_tasks; ++task)
+    {
+        for (int j = task_event_offsets[task]; j < task_event_offsets[task + 1];
+             ++j)
+        {
+            (*(trace->events))[task]->append(events[task_event_ids[j]]);
+        }
+        for (int j = root_offsets[task]; j < root_offsets[task + 1]; ++j)
+            (*(trace->roots))[task]->append(events[root_ids[j]]);
+    }
+
+    trace->collectives = new QMap<unsigned long long, CollectiveRecord *>();
+    for (int i = 0; i < collective_keys.size(); ++i)
+        trace->collectives->insert(collective_keys[i],
+                                   records[collective_ids[i]]);
+
+    if (has_map)
+    {
+        trace->collectiveMap
+                = new QVector<QMap<unsigned long long, CollectiveRecord *> *>(num_tasks);
+        for (int task = 0; task < num_tasks; ++task)
+        {
+            QMap<unsigned long long, CollectiveRecord *> * task_map
+                    = new QMap<unsigned long long, CollectiveRecord *>();
+            for (int j = map_offsets[task]; j < map_offsets[task + 1]; ++j)
+                task_map->insert(map_keys[j], records[map_ids[j]]);
+            (*(trace->collectiveMap))[task] = task_map;
+        }
+    }
+
+    int list = 0;
+    for (int i = 0; i < num_partitions; ++i)
+    {
+        Partition * part = new Partition();
+        part->new_partition = part;
+        for (int j = 0; j < list_counts[i]; ++j, ++list)
+        {
+            QList<CommEvent *> * event_list = new QList<CommEvent *>();
+            for (int k = list_offsets[list]; k < list_offsets[list + 1]; ++k)
+            {
+                CommEvent * evt = static_cast<CommEvent *>(events[list_ids[k]]);
+                evt->partition = part;
+                event_list->append(evt);
+            }
+            part->events->insert(list_tasks[list], event_list);
+        }
+        trace->partitions->append(part);
+    }
+
+    return trace;
+}
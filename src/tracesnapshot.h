@@ -0,0 +1,71 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+//
+// This file is part of Ravel.
+// Written by Kate Isaacs, kisaacs@acm.org, All rights reserved.
+// LLNL-CODE-663885
+//
+// For details, see https://github.com/scalability-llnl/ravel
+// Please also see the LICENSE file for our notice and the LGPL.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (as published by
+// the Free Software Foundation) version 2.1 dated February 1999.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the IMPLIED WARRANTY OF
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the terms and
+// conditions of the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//////////////////////////////////////////////////////////////////////////////
+#ifndef TRACESNAPSHOT_H
+#define TRACESNAPSHOT_H
+
+#include <QString>
+#include <QByteArray>
+#include <QDataStream>
+
+#include "otfimportoptions.h"
+
+class Trace;
+
+// Binary copy of a processed trace kept in the user's cache directory so
+// reopening a trace skips reading, matching, partitioning and stepping.
+// A snapshot is tied to the sizes and modification times of the trace's
+// files and to the import options; it is ignored when any of these differ
+// or when it was written by another format version. Saving trims the
+// cache to its size limit and snapshot count, oldest first.
+class TraceSnapshot
+{
+public:
+    TraceSnapshot(QString _source, OTFImportOptions * _options);
+
+    // Returns NULL when there is no usable snapshot. The trace still
+    // needs preprocessFromSaved() for its partition dag and clusters.
+    Trace * load();
+    bool save(Trace * trace);
+
+private:
+    static QString cacheDir();
+    QString cachePath();
+    QByteArray sourceKey();
+    void trimCache();
+
+    static void writeOptions(QDataStream& out, const OTFImportOptions& opts);
+    static void readOptions(QDataStream& in, OTFImportOptions * opts);
+
+    QString source;
+    QByteArray options_key;
+    qint64 cache_limit; // bytes
+
+    static const int max_snapshots = 32;
+
+    static const quint32 magic = 0x5256534e; // RVSN
+    static const qint32 version = 5;
+};
+
+#endif // TRACESNAPSHOT_H
@@ -39,6 +39,10 @@
 #include "event.h"
 #include "p2pevent.h"
 #include "collectiveevent.h"
+#include "stepindex.h"
+#include "framebuilder.h"
+#include "calltreeframe.h"
+#include "labelcache.h"
 
 TraditionalVis::TraditionalVis(QWidget * parent, VisOptions * _options)
     : TimelineVis(parent = parent, _options),
@@ -46,28 +50,36 @@ TraditionalVis::TraditionalVis(QWidget * parent, VisOptions * _options)
     maxTime(0),
     startTime(0),
     timeSpan(0),
-    stepToTime(new QVector<TimePair *>()),
     lassoRect(QRect()),
-    blockheight(0)
+    blockheight(0),
+    frame_builder(new FrameBuilder()),
+    tiles(new TileCache()),
+    tile_requests(QMap<int, QList<TileKey> >()),
+    requested_tiles(QList<TileKey>()),
+    shown_zoom(TileKey()),
+    tiles_selected(NULL),
+    labels(new LabelCache()),
+    frame_labels(new LabelCache())
 {
-
+    connect(frame_builder, SIGNAL(frameReady(QImage, int)), this,
+            SLOT(frameReady(QImage, int)));
 }
 
 TraditionalVis::~TraditionalVis()
 {
-    for (QVector<TimePair *>::Iterator itr = stepToTime->begin();
-         itr != stepToTime->end(); itr++)
-    {
-        delete *itr;
-        *itr = NULL;
-    }
-    delete stepToTime;
+    delete frame_builder;
+    delete tiles;
+    delete labels;
+    delete frame_labels;
 }
 
 
 void TraditionalVis::setTrace(Trace * t)
 {
+    cancelFrames();
     VisWidget::setTrace(t);
+    labels->clear();
+    frame_labels->clear();
 
     // Initial conditions
     startStep = 0;
@@ -76,73 +88,23 @@ void TraditionalVis::setTrace(Trace * t)
     taskSpan = trace->num_tasks;
     startPartition = 0;
 
-    // Determine/save time information
-    minTime = ULLONG_MAX;
-    maxTime = 0;
+    // Time information comes from the trace's step map
+    minTime = trace->min_time;
+    maxTime = trace->max_time;
+    maxStep = trace->global_max_step;
     startTime = ULLONG_MAX;
     unsigned long long stopTime = 0;
-    maxStep = trace->global_max_step;
-    for (QList<Partition*>::Iterator part = trace->partitions->begin();
-         part != trace->partitions->end(); ++part)
+    for (int step = boundStep(startStep); step <= boundStep(stopStep);
+         step += 2)
     {
-        for (QMap<int, QList<CommEvent *> *>::Iterator event_list
-             = (*part)->events->begin(); event_list != (*part)->events->end();
-             ++event_list)
-        {
-            for (QList<CommEvent *>::Iterator evt = (event_list.value())->begin();
-                 evt != (event_list.value())->end(); ++evt)
-            {
-                if ((*evt)->exit > maxTime)
-                    maxTime = (*evt)->exit;
-                if ((*evt)->enter < minTime)
-                    minTime = (*evt)->enter;
-                if ((*evt)->step >= boundStep(startStep)
-                        && (*evt)->enter < startTime)
-                    startTime = (*evt)->enter;
-                if ((*evt)->step <= boundStep(stopStep)
-                        && (*evt)->exit > stopTime)
-                    stopTime = (*evt)->exit;
-            }
-        }
+        Trace::StepTime bounds = trace->stepTime(step);
+        if (bounds.start < startTime)
+            startTime = bounds.start;
+        if (bounds.stop > stopTime)
+            stopTime = bounds.stop;
     }
     timeSpan = stopTime - startTime;
     stepSpan = stopStep - startStep;
-
-    // Clean up old
-    for (QVector<TimePair *>::Iterator itr = stepToTime->begin();
-         itr != stepToTime->end(); itr++)
-    {
-        delete *itr;
-        *itr = NULL;
-    }
-    delete stepToTime;
-
-    // Create time/step mapping
-    stepToTime = new QVector<TimePair *>();
-    for (int i = 0; i < maxStep/2 + 1; i++)
-        stepToTime->insert(i, new TimePair(ULLONG_MAX, 0));
-    int step;
-    for (QList<Partition*>::Iterator part = trace->partitions->begin();
-         part != trace->partitions->end(); ++part)
-    {
-        for (QMap<int, QList<CommEvent *> *>::Iterator event_list
-             = (*part)->events->begin(); event_list != (*part)->events->end();
-             ++event_list)
-        {
-            for (QList<CommEvent *>::Iterator evt = (event_list.value())->begin();
-                 evt != (event_list.value())->end(); ++evt)
-            {
-                if ((*evt)->step < 0)
-                    continue;
-                step = (*evt)->step / 2;
-                if ((*stepToTime)[step]->start > (*evt)->enter)
-                    (*stepToTime)[step]->start = (*evt)->enter;
-                if ((*stepToTime)[step]->stop < (*evt)->exit)
-                    (*stepToTime)[step]->stop = (*evt)->exit;
-            }
-        }
-    }
-
 }
 
 void TraditionalVis::mouseDoubleClickEvent(QMouseEvent * event)
@@ -150,27 +112,23 @@ void TraditionalVis::mouseDoubleClickEvent(QMouseEvent * event)
     if (!visProcessed)
         return;
 
-    int x = event->x();
-    int y = event->y();
-    for (QMap<Event *, QRect>::Iterator evt = drawnEvents.begin();
-         evt != drawnEvents.end(); ++evt)
-        if (evt.value().contains(x,y))
+    Event * clicked = drawnEvents.find(event->x(), event->y());
+    if (clicked)
+    {
+        if (clicked == selected_event)
         {
-            if (evt.key() == selected_event)
-            {
-                selected_event = NULL;
-            }
-            else
-            {
-                selected_aggregate = false;
-                selected_event = evt.key();
-            }
-            break;
+            selected_event = NULL;
         }
+        else
+        {
+            selected_aggregate = false;
+            selected_event = clicked;
+        }
+    }
 
     changeSource = true;
     emit eventClicked(selected_event, false, false);
-    repaint();
+    update();
 }
 
 void TraditionalVis::rightDrag(QMouseEvent * event)
@@ -215,7 +173,7 @@ void TraditionalVis::rightDrag(QMouseEvent * event)
         startTask = 0;
 
 
-    repaint();
+    update();
     changeSource = true;
     emit stepsChanged(startStep, startStep + stepSpan, false);
 }
@@ -247,7 +205,7 @@ void TraditionalVis::mouseMoveEvent(QMouseEvent * event)
 
         mousex = event->x();
         mousey = event->y();
-        repaint();
+        update();
     }
     else if (mousePressed && rightPressed)
     {
@@ -255,17 +213,18 @@ void TraditionalVis::mouseMoveEvent(QMouseEvent * event)
                           std::min(pressy, event->y()),
                           abs(pressx - event->x()),
                           abs(pressy - event->y()));
-        repaint();
+        update();
     }
     else // potential hover
     {
         mousex = event->x();
         mousey = event->y();
         if (hover_event == NULL
-                || !drawnEvents[hover_event].contains(mousex, mousey))
+                || !drawnEvents.value(hover_event).contains(mousex, mousey))
         {
             // Hover for all events! Note since we only save comm events in the
             // drawnEvents, this will recalculate for non-comm events each move
+            Event * last_hover = hover_event;
             if (mousey > blockheight * taskSpan)
                 hover_event = NULL;
             else
@@ -277,7 +236,8 @@ void TraditionalVis::mouseMoveEvent(QMouseEvent * event)
                                                 * timeSpan + startTime;
                 hover_event = trace->findEvent(hover_proc, hover_time);
             }
-            repaint();
+            if (hover_event != last_hover)
+                update();
         }
     }
 
@@ -309,7 +269,7 @@ void TraditionalVis::wheelEvent(QWheelEvent * event)
         timeSpan *= scale;
         startTime = middleTime - timeSpan / 2.0;
     }
-    repaint();
+    update();
     changeSource = true;
     // startStep & stepSpan are calculated during painting when we
     // examine each element
@@ -329,13 +289,13 @@ void TraditionalVis::setSteps(float start, float stop, bool jump)
     lastStartStep = startStep;
     startStep = start;
     stepSpan = stop - start;
-    startTime = (*stepToTime)[std::max(boundStep(start)/2, 0)]->start;
-    timeSpan = (*stepToTime)[std::min(boundStep(stop)/2,  maxStep/2)]->stop
+    startTime = trace->stepTime(std::max(boundStep(start), 0)).start;
+    timeSpan = trace->stepTime(std::min(boundStep(stop), maxStep)).stop
             - startTime;
     jumped = jump;
 
     if (!closed) {
-        repaint();
+        update();
     }
 }
 
@@ -344,60 +304,13 @@ void TraditionalVis::prepaint()
     if (!trace)
         return;
     closed = false;
-    drawnEvents.clear();
+    drawnEvents.reset(rect());
     int bottomStep = floor(startStep) - 1;
     // Fix bottomStep in the case where there are no steps in the view,
     // otherwise partition place will be lost
-    while (bottomStep > 0 && stepToTime->value(bottomStep/2)->stop > startTime)
+    while (bottomStep > 0 && trace->stepTime(bottomStep).stop > startTime)
        bottomStep -= 2;
-    if (jumped) // We have to redo the active_partitions
-    {
-        // We know this list is in order, so we only have to go so far
-        //int topStep = boundStep(startStep + stepSpan) + 1;
-        Partition * part = NULL;
-        for (int i = 0; i < trace->partitions->length(); ++i)
-        {
-            part = trace->partitions->at(i);
-            if (part->max_global_step >= bottomStep)
-            {
-                startPartition = i;
-                break;
-            }
-        }
-    }
-    else // We nudge the active partitions as necessary
-    {
-        Partition * part = NULL;
-        if (startStep <= lastStartStep) // check earlier partitions
-        {
-            // Keep setting the one before until its right
-            for (int i = startPartition; i >= 0; --i)
-            {
-                part = trace->partitions->at(i);
-                if (part->max_global_step >= bottomStep)
-                {
-                    startPartition = i;
-                }
-                else
-                {
-                    break;
-                }
-            }
-        }
-        else if (startStep > lastStartStep) // check current partitions up
-        {
-            // As soon as we find one, we're good
-            for (int i = startPartition; i < trace->partitions->length(); ++i)
-            {
-                part = trace->partitions->at(i);
-                if (part->max_global_step >= bottomStep)
-                {
-                    startPartition = i;
-                    break;
-                }
-            }
-        }
-    }
+    startPartition = trace->step_index->findPartition(bottomStep);
 }
 
 
@@ -411,7 +324,6 @@ void TraditionalVis::drawNativeGL()
     if (effectiveHeight / taskSpan >= 3 && rect().width() / stepSpan >= 3)
         return;
 
-    QString metric(options->metric);
     unsigned long long stopTime = startTime + timeSpan;
 
     // Setup viewport
@@ -462,12 +374,17 @@ void TraditionalVis::drawNativeGL()
                     || position > ceil(startTask + taskSpan))
                 continue;
             y = (maxTask - position) * barheight - 1;
+            QVector<QRgb> row_colors = QVector<QRgb>();
+            if (options->colorTraditionalByMetric)
+                rowColors(event_list.value(), stopTime, &row_colors);
+            int row_index = 0;
             for (QList<CommEvent *>::Iterator evt = (event_list.value())->begin();
                  evt != (event_list.value())->end(); ++evt)
             {
                 // Out of time span test
                 if ((*evt)->exit < startTime || (*evt)->enter > stopTime)
                     continue;
+                int color_index = row_index++;
 
 
                 // save step information for emitting
@@ -486,10 +403,9 @@ void TraditionalVis::drawNativeGL()
                 else
                     w -= (startTime - (*evt)->enter);
 
-                color = options->colormap->color((*(*evt)->metrics)[metric]->event);
                 if (options->colorTraditionalByMetric
                         && (*evt)->hasMetric(options->metric))
-                    color= options->colormap->color((*evt)->getMetric(options->metric));
+                    color = QColor(row_colors[color_index]);
                 else
                 {
                     if (*evt == selected_event)
@@ -539,8 +455,12 @@ void TraditionalVis::qtPaint(QPainter *painter)
     if(!visProcessed)
         return;
 
-    if ((rect().height() - timescaleHeight) / taskSpan >= 3)
+    int canvasHeight = rect().height() - timescaleHeight;
+    if (canvasHeight / taskSpan >= 3)
+    {
+        paintTiles(painter, canvasHeight);
         paintEvents(painter);
+    }
 
     drawTaskLabels(painter, rect().height() - timescaleHeight,
                       taskheight);
@@ -568,6 +488,8 @@ void TraditionalVis::paintEvents(QPainter *painter)
     blockheight = floor(canvasHeight / taskSpan);
     float barheight = blockheight - task_spacing;
     taskheight = blockheight;
+    labels->setTrace(trace);
+    labels->setFont(painter->font());
     int oldStart = startStep;
     int oldStop = stepSpan + startStep;
     int upperStep = startStep + stepSpan + 2;
@@ -576,7 +498,6 @@ void TraditionalVis::paintEvents(QPainter *painter)
     QRect extents = QRect(labelWidth, 0, rect().width(), canvasHeight);
 
     painter->setFont(QFont("Helvetica", 10));
-    QFontMetrics font_metrics = painter->fontMetrics();
 
     int position, step;
     bool complete;
@@ -587,21 +508,7 @@ void TraditionalVis::paintEvents(QPainter *painter)
     painter->setPen(QPen(QColor(0, 0, 0)));
     Partition * part = NULL;
 
-    int start = std::max(int(floor(startTask)), 0);
-    int end = std::min(int(ceil(startTask + taskSpan)),
-                       trace->num_tasks - 1);
-    for (int i = start; i <= end; ++i)
-    {
-        position = order_to_proc[i];
-        QVector<Event *> * roots = trace->roots->at(i);
-        for (QVector<Event *>::Iterator root = roots->begin();
-             root != roots->end(); ++root)
-        {
-            paintNotStepEvents(painter, *root, position, task_spacing,
-                               barheight, blockheight, &extents);
-        }
-    }
-
+    // The rest of the call tree is already drawn from the tiles
 
     for (int i = startPartition; i < trace->partitions->length(); ++i)
     {
@@ -626,12 +533,17 @@ void TraditionalVis::paintEvents(QPainter *painter)
                continue;
             y = floor((position - startTask) * blockheight) + 1;
 
+            QVector<QRgb> row_colors = QVector<QRgb>();
+            if (options->colorTraditionalByMetric)
+                rowColors(event_list.value(), stopTime, &row_colors);
+            int row_index = 0;
             for (QList<CommEvent *>::Iterator evt = (event_list.value())->begin();
                  evt != (event_list.value())->end(); ++evt)
             {
                  // Out of time span test
                 if ((*evt)->exit < startTime || (*evt)->enter > stopTime)
                     continue;
+                int color_index = row_index++;
 
 
                 // save step information for emitting
@@ -680,7 +592,7 @@ void TraditionalVis::paintEvents(QPainter *painter)
                         && (*evt)->hasMetric(options->metric))
                     {
                             painter->fillRect(QRectF(x, y, w, h),
-                                              QBrush(options->colormap->color((*evt)->getMetric(options->metric))));
+                                              QBrush(QColor(row_colors[color_index])));
                     }
                     else
                     {
@@ -706,15 +618,19 @@ void TraditionalVis::paintEvents(QPainter *painter)
                     if (*evt == selected_event && !selected_aggregate)
                         painter->setPen(QPen(QColor(0, 0, 0)));
 
-                    drawnEvents[*evt] = QRect(x, y, w, h);
+                    drawnEvents.insert(*evt, QRect(x, y, w, h));
 
                     unsigned long long drawnEnter = std::max(startTime, (*evt)->enter);
                     unsigned long long available_w = ((*evt)->exit - drawnEnter)
                                         / 1.0 / timeSpan * rect().width() + 2;
-                    QString fxnName = ((*(trace->functions))[(*evt)->function])->name;
-                    QRect fxnRect = painter->fontMetrics().boundingRect(fxnName);
-                    if (fxnRect.width() < available_w && fxnRect.height() < h)
-                        painter->drawText(x + 2, y + fxnRect.height(), fxnName);
+                    if (labels->height() < h)
+                    {
+                        QString fxnName = labels->label((*evt)->function,
+                                                        available_w);
+                        if (!fxnName.isEmpty())
+                            painter->drawText(x + 2, y + labels->height(),
+                                              fxnName);
+                    }
 
                     // Selected aggregate
                     if (*evt == selected_event && selected_aggregate)
@@ -766,6 +682,28 @@ void TraditionalVis::paintEvents(QPainter *painter)
                       QBrush(QColor(Qt::white)));
 }
 
+// Metric colors of the events of one task row that are in view, in
+// order, mapped in one pass rather than one color() call per event
+void TraditionalVis::rowColors(QList<CommEvent *> * events,
+                               unsigned long long stopTime,
+                               QVector<QRgb> * colors)
+{
+    QVector<double> values = QVector<double>();
+    for (QList<CommEvent *>::Iterator evt = events->begin();
+         evt != events->end(); ++evt)
+    {
+        if ((*evt)->exit < startTime || (*evt)->enter > stopTime)
+            continue;
+        if ((*evt)->hasMetric(options->metric))
+            values.append((*evt)->getMetric(options->metric));
+        else
+            values.append(0);
+    }
+    colors->resize(values.size());
+    options->colormap->mapColors(values.constData(), values.size(),
+                                 colors->data());
+}
+
 void TraditionalVis::drawMessage(QPainter * painter, Message * msg)
 {
     int penwidth = 1;
@@ -873,97 +811,144 @@ int TraditionalVis::getW(CommEvent *evt)
     return (evt->exit - evt->enter) / 1.0 / timeSpan * rect().width();
 }
 
-// To make sure events have correct overlapping, this draws from the root down
-// TODO: Have a level cut off so we don't descend all the way down the tree
-void TraditionalVis::paintNotStepEvents(QPainter *painter, Event * evt,
-                                        float position, int task_spacing,
-                                        float barheight, float blockheight,
-                                        QRect * extents)
+void TraditionalVis::cancelFrames()
 {
-    if (evt->enter > startTime + timeSpan || evt->exit < startTime)
-        return; // Out of time
-    if (evt->isCommEvent())
-        return; // Drawn later
-
-    int x, y, w, h;
-    w = (evt->exit - evt->enter) / 1.0 / timeSpan * rect().width();
-    if (w >= 2) // Don't draw tiny events
-    {
-        y = floor((position - startTask) * blockheight) + 1;
-        x = floor(static_cast<long long>(evt->enter - startTime) / 1.0
-                  / timeSpan * rect().width()) + 1 + labelWidth;
-        h = barheight;
-
-
-        // Corrections for partially drawn
-        bool complete = true;
-        if (y < 0) {
-            h = barheight - fabs(y);
-            y = 0;
-            complete = false;
-        } else if (y + barheight > rect().height() - timescaleHeight) {
-            h = rect().height() - timescaleHeight - y;
-            complete = false;
-        }
-        if (x < labelWidth) {
-            w -= (labelWidth - x);
-            x = labelWidth;
-            complete = false;
-        } else if (x + w > rect().width()) {
-            w = rect().width() - x;
-            complete = false;
-        }
-
-
-        // Change pen color if selected
-        if (evt == selected_event)
-            painter->setPen(QPen(Qt::yellow));
+    frame_builder->cancel();
+    tiles->clear();
+    tile_requests.clear();
+    requested_tiles.clear();
+    shown_zoom = TileKey();
+    tiles_selected = NULL;
+}
 
+// The call tree layer is not colored by metric, so tiles only change
+// with the trace, scale and selection.
+TileKey TraditionalVis::currentZoom(int canvasHeight)
+{
+    TileKey zoom;
+    zoom.trace = trace;
+    zoom.time_scale = timeSpan / 1.0 / rect().width();
+    zoom.task_scale = floor(canvasHeight / taskSpan);
+    return zoom;
+}
 
-        if (evt == selected_event)
-            painter->fillRect(QRectF(x, y, w, h), QBrush(Qt::yellow));
-        else
-        {
-            // Draw event
-            int graycolor = std::max(100, 100 + evt->depth * 20);
-            painter->fillRect(QRectF(x, y, w, h),
-                              QBrush(QColor(graycolor, graycolor, graycolor)));
-        }
+// Tiles at the scales of zoom that cover the view
+void TraditionalVis::visibleTiles(const TileKey& zoom, QList<TileKey> * found)
+{
+    double span = (rect().width() - labelWidth) * timeSpan / 1.0
+                  / rect().width();
+    qint64 first_x = floor(startTime / zoom.time_scale / TileCache::tileSize);
+    qint64 last_x = floor((startTime + span) / zoom.time_scale
+                          / TileCache::tileSize);
+    int first_y = floor(startTask * zoom.task_scale / TileCache::tileSize);
+    int last_y = floor((startTask + taskSpan) * zoom.task_scale
+                       / TileCache::tileSize);
+
+    TileKey key = zoom;
+    for (key.y = std::max(0, first_y); key.y <= last_y; ++key.y)
+        for (key.x = first_x; key.x <= last_x; ++key.x)
+            found->append(key);
+}
 
+// Draw the tiles we have at zoom, scaled to the current view. Returns
+// whether none were missing.
+bool TraditionalVis::drawTiles(QPainter * painter, const TileKey& zoom,
+                               QList<TileKey> * missing)
+{
+    double time_scale = timeSpan / 1.0 / rect().width();
+    float task_scale = floor((rect().height() - timescaleHeight) / taskSpan);
+    QList<TileKey> keys;
+    visibleTiles(zoom, &keys);
 
-        // Draw border
-        if (task_spacing > 0)
+    bool complete = true;
+    for (QList<TileKey>::Iterator key = keys.begin(); key != keys.end(); ++key)
+    {
+        QImage tile = tiles->get(*key);
+        if (tile.isNull())
         {
-            if (complete)
-                painter->drawRect(QRectF(x,y,w,h));
-            else
-                incompleteBox(painter, x, y, w, h, extents);
+            complete = false;
+            if (missing)
+                missing->append(*key);
+            continue;
         }
 
-        // Revert pen color
-        if (evt == selected_event)
-            painter->setPen(QPen(QColor(0, 0, 0)));
-
-        // Replace this with something else that handles tree
-        //drawnEvents[*evt] = QRect(x, y, w, h);
+        double x = labelWidth + (double(CallTreeFrame::tileTime(*key))
+                                 - double(startTime)) / time_scale;
+        double y = (CallTreeFrame::tileTask(*key) - startTask) * task_scale;
+        double w = TileCache::tileSize * zoom.time_scale / time_scale;
+        double h = TileCache::tileSize * task_scale / zoom.task_scale;
+        painter->drawImage(QRectF(x, y, w, h), tile);
+    }
+    return complete;
+}
 
-        unsigned long long drawnEnter = std::max(startTime, evt->enter);
-        unsigned long long available_w = (evt->getVisibleEnd(drawnEnter)
-                           - drawnEnter)
-                            / 1.0 / timeSpan * rect().width() + 2;
+// Lay down the call tree from cached tiles and ask for whatever is missing
+void TraditionalVis::paintTiles(QPainter * painter, int canvasHeight)
+{
+    TileKey zoom = currentZoom(canvasHeight);
+    if (zoom.task_scale <= 0 || zoom.time_scale <= 0)
+        return;
 
-        QString fxnName = ((*(trace->functions))[evt->function])->name;
-        QRect fxnRect = painter->fontMetrics().boundingRect(fxnName);
-        if (fxnRect.width() < available_w && fxnRect.height() < h)
-            painter->drawText(x + 2, y + fxnRect.height(), fxnName);
+    // Only the rows with the old and new selection need redrawing
+    if (selected_event != tiles_selected)
+    {
+        if (tiles_selected && !tiles_selected->isCommEvent())
+            tiles->removeTask(trace, proc_to_order[tiles_selected->task]);
+        if (selected_event && !selected_event->isCommEvent())
+            tiles->removeTask(trace, proc_to_order[selected_event->task]);
+        tiles_selected = selected_event;
+
+        // Tiles still being drawn have the old selection
+        tile_requests.clear();
+        requested_tiles.clear();
     }
 
-    for (QVector<Event *>::Iterator child = evt->callees->begin();
-         child != evt->callees->end(); ++child)
+    painter->save();
+    painter->setClipRect(labelWidth, 0, rect().width() - labelWidth,
+                         canvasHeight);
+
+    QList<TileKey> missing;
+    if (shown_zoom.trace == trace && !(shown_zoom == zoom))
     {
-        paintNotStepEvents(painter, *child, position, task_spacing,
-                           barheight, blockheight, extents);
+        // Check first so a complete zoom doesn't bring back stand-ins
+        QList<TileKey> keys;
+        visibleTiles(zoom, &keys);
+        bool have_all = true;
+        for (int i = 0; i < keys.size() && have_all; ++i)
+            have_all = tiles->contains(keys.at(i));
+        if (!have_all)
+            drawTiles(painter, shown_zoom, NULL);
     }
+    if (drawTiles(painter, zoom, &missing))
+        shown_zoom = zoom;
+    painter->restore();
+
+    if (missing.isEmpty() || missing == requested_tiles)
+        return;
+
+    requested_tiles = missing;
+    CallTreeFrame * job = new CallTreeFrame(trace, missing, order_to_proc,
+                                            selected_event, frame_labels);
+    tile_requests.insert(frame_builder->request(job), missing);
+}
+
+void TraditionalVis::frameReady(QImage image, int generation)
+{
+    if (!tile_requests.contains(generation))
+        return;
+
+    QList<TileKey> keys = tile_requests.value(generation);
+    for (int i = 0; i < keys.size(); ++i)
+        tiles->insert(keys.at(i), image.copy(i * TileCache::tileSize, 0,
+                                             TileCache::tileSize,
+                                             TileCache::tileSize));
 
+    // Anything asked for before this will never arrive
+    while (!tile_requests.isEmpty()
+           && tile_requests.begin().key() <= generation)
+        tile_requests.erase(tile_requests.begin());
+    if (tile_requests.isEmpty())
+        requested_tiles.clear();
 
+    update();
 }
@@ -27,8 +27,13 @@
 
 #include "timelinevis.h"
 #include <QVector>
+#include <QImage>
+#include <QRgb>
+#include "tilecache.h"
 
 class CommEvent;
+class FrameBuilder;
+class LabelCache;
 
 // Physical timeline
 class TraditionalVis : public TimelineVis
@@ -47,12 +52,14 @@ public:
 
     void drawMessage(QPainter * painter, Message * message);
     void drawCollective(QPainter * painter, CollectiveRecord * cr);
+    void cancelFrames();
 
 signals:
     void timeScaleString(QString);
 
 public slots:
     void setSteps(float start, float stop, bool jump = false);
+    void frameReady(QImage image, int generation);
 
 protected:
     void qtPaint(QPainter *painter);
@@ -63,33 +70,40 @@ protected:
     void prepaint();
     void drawNativeGL();
 
-    // Paint all other events available
-    void paintNotStepEvents(QPainter *painter, Event * evt, float position,
-                            int task_spacing, float barheight,
-                            float blockheight, QRect * extents);
+    // The call tree layer comes from tiles drawn in the background
+    TileKey currentZoom(int canvasHeight);
+    void visibleTiles(const TileKey& zoom, QList<TileKey> * found);
+    bool drawTiles(QPainter *painter, const TileKey& zoom,
+                   QList<TileKey> * missing);
+    void paintTiles(QPainter *painter, int canvasHeight);
 
 private:
-    // For keeping track of map betewen real time and step time
-    class TimePair {
-    public:
-        TimePair(unsigned long long _s1, unsigned long long _s2)
-            : start(_s1), stop(_s2) {}
-
-        unsigned long long start;
-        unsigned long long stop;
-    };
-
     unsigned long long minTime;
     unsigned long long maxTime;
     unsigned long long startTime;
     unsigned long long timeSpan;
-    QVector<TimePair* > * stepToTime;
     QRect lassoRect;
     float blockheight;
 
+    // Drawn call tree tiles and the ones still being drawn by generation.
+    // Tiles at shown_zoom stand in while the current zoom fills in.
+    FrameBuilder * frame_builder;
+    TileCache * tiles;
+    QMap<int, QList<TileKey> > tile_requests;
+    QList<TileKey> requested_tiles;
+    TileKey shown_zoom;
+    Event * tiles_selected;
+
+    // Laid out function labels for the comm events drawn here and for
+    // the tiles, which are only used on the frame builder thread
+    LabelCache * labels;
+    LabelCache * frame_labels;
+
     int getX(CommEvent * evt);
     int getY(CommEvent * evt);
     int getW(CommEvent * evt);
+    void rowColors(QList<CommEvent *> * events, unsigned long long stopTime,
+                   QVector<QRgb> * colors);
 };
 
 #endif // TRADITIONALVIS_H
@@ -32,6 +32,7 @@ VisOptions::VisOptions(bool _showAgg,
       showAggregateSteps(_showAgg),
       colorTraditionalByMetric(_metricTraditional),
       showMessages(MSG_TRUE),
+      messageLimit(2000),
       topByCentroid(false),
       showInactiveSteps(true),
       metric(_metric),
@@ -78,6 +79,7 @@ VisOptions::VisOptions(const VisOptions& copy)
     showAggregateSteps = copy.showAggregateSteps;
     colorTraditionalByMetric = copy.colorTraditionalByMetric;
     showMessages = copy.showMessages;
+    messageLimit = copy.messageLimit;
     showInactiveSteps = copy.showInactiveSteps;
     topByCentroid = copy.topByCentroid;
     metric = copy.metric;
@@ -45,6 +45,7 @@ public:
     bool showAggregateSteps;
     bool colorTraditionalByMetric; // color physical timeline by metric
     MessageType showMessages; // draw message lines
+    int messageLimit; // most message lines drawn before bundling them
     bool topByCentroid; // focus processes are centroid of cluster
     bool showInactiveSteps; // default: no color for inactive proportion
     QString metric;
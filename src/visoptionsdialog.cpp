@@ -57,6 +57,8 @@ VisOptionsDialog::VisOptionsDialog(QWidget *parent, VisOptions * _options,
             SLOT(onShowAggregate(bool)));
     connect(ui->messageComboBox, SIGNAL(currentIndexChanged(int)), this,
             SLOT(onShowMessages(int)));
+    connect(ui->messageLimitSpinBox, SIGNAL(valueChanged(int)), this,
+            SLOT(onMessageLimit(int)));
     connect(ui->inactiveCheckBox, SIGNAL(clicked(bool)), this,
             SLOT(onShowInactive(bool)));
     connect(ui->colorComboBox, SIGNAL(currentIndexChanged(QString)), this,
@@ -126,6 +128,13 @@ void VisOptionsDialog::onShowMessages(int showMessages)
         options->showMessages = VisOptions::MSG_SINGLE;
 }
 
+void VisOptionsDialog::onMessageLimit(int messageLimit)
+{
+    if (!isSet)
+        return;
+    options->messageLimit = messageLimit;
+}
+
 void VisOptionsDialog::onShowInactive(bool showInactive)
 {
     options->showInactiveSteps = showInactive;
@@ -184,6 +193,7 @@ void VisOptionsDialog::setUIState()
     else
         ui->messageComboBox->setCurrentIndex(2);
 
+    ui->messageLimitSpinBox->setValue(options->messageLimit);
 
     if (trace)
     {
@@ -54,6 +54,7 @@ public slots:
     void onMetric(QString metric);
     void onShowAggregate(bool showAggregate);
     void onShowMessages(int showMessages);
+    void onMessageLimit(int messageLimit);
     void onColorCombo(QString type);
     void onShowInactive(bool showInactive);
 
@@ -47,7 +47,7 @@ VisWidget::VisWidget(QWidget *parent, VisOptions * _options) :
     selectColor(QBrush(Qt::yellow)),
     changeSource(false),
     border(20),
-    drawnEvents(QMap<Event *, QRect>()),
+    drawnEvents(HitGrid<Event *>()),
     selected_tasks(QList<int>()),
     selected_gnome(NULL),
     selected_event(NULL),
@@ -170,6 +170,13 @@ void VisWidget::processVis()
     visProcessed = true;
 }
 
+void VisWidget::releaseTrace()
+{
+    cancelFrames();
+    visProcessed = false;
+    selected_gnome = NULL;
+}
+
 void VisWidget::qtPaint(QPainter *painter)
 {
     Q_UNUSED(painter);
@@ -220,7 +227,7 @@ void VisWidget::setClosed(bool _closed)
 {
     if (closed && !_closed)
     {
-        repaint();
+        update();
     }
     closed = _closed;
 }
@@ -33,6 +33,7 @@
 #include <QColor>
 
 #include "visoptions.h"
+#include "hitgrid.h"
 #include "commdrawinterface.h"
 
 class VisOptions;
@@ -65,6 +66,18 @@ public:
     virtual void drawCollective(QPainter * painter, CollectiveRecord * cr)
         { Q_UNUSED(painter); Q_UNUSED(cr); }
 
+    // Stop any background drawing that reads the trace
+    virtual void cancelFrames() { }
+
+    // Stop drawing and drop what points into the trace's clusters until
+    // the trace is set again
+    virtual void releaseTrace();
+
+    // Draws only the box borders inside extents. Static so that frames
+    // drawn off the GUI thread can use it.
+    static void incompleteBox(QPainter *painter, float x, float y,
+                              float w, float h, QRect *extents);
+
 signals:
     void repaintAll();
     void stepsChanged(float start, float stop, bool jump);
@@ -79,8 +92,6 @@ public slots:
 protected:
     void initializeGL();
     void paintEvent(QPaintEvent *event);
-    void incompleteBox(QPainter *painter,
-                       float x, float y, float w, float h, QRect *extents);
     int boundStep(float step); // Determine upper bound on step
 
     virtual void drawNativeGL();
@@ -103,7 +114,7 @@ protected:
     int border;
 
     // Interactions
-    QMap<Event *, QRect> drawnEvents;
+    HitGrid<Event *> drawnEvents; // Rects drawn this paint, for hit tests
     QList<int> selected_tasks;
     Gnome * selected_gnome;
     Event * selected_event;